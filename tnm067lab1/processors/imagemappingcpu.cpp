@@ -4,6 +4,7 @@
 #include <inviwo/core/datastructures/image/layerramprecision.h>
 #include <inviwo/core/util/indexmapper.h>
 #include <inviwo/core/util/imageramutils.h>
+#include <inviwo/core/util/stringconversion.h>
 
 
 namespace inviwo {
@@ -32,7 +33,15 @@ ImageMappingCPU::ImageMappingCPU()
                FloatVec4Property{"color7", "Color 7", vec4(1), vec4(0, 0, 0, 1), vec4(1)},
                FloatVec4Property{"color8", "Color 8", vec4(1), vec4(0, 0, 0, 1), vec4(1)},
                FloatVec4Property{"color9", "Color 9", vec4(1), vec4(0, 0, 0, 1), vec4(1)},
-               FloatVec4Property{"color10", "Color 10", vec4(1), vec4(0, 0, 0, 1), vec4(1)}}) {
+               FloatVec4Property{"color10", "Color 10", vec4(1), vec4(0, 0, 0, 1), vec4(1)}})
+    , normalization_("normalization", "Normalization",
+                     {{"typeRange", "Data Type Range", Normalization::TypeRange},
+                      {"autoRange", "Auto Range", Normalization::AutoRange},
+                      {"equalize", "Histogram Equalization", Normalization::Equalize}},
+                     0)
+    , percentiles_("percentiles", "Auto Range Percentiles", 0.0f, 100.0f, 0.0f, 100.0f, 0.1f)
+    , info_("info", "Data Range", "")
+    , profiling_("profiling", "Profiling") {
 
     addPort(inport_);
     addPort(outport_);
@@ -43,6 +52,20 @@ ImageMappingCPU::ImageMappingCPU()
         c.setCurrentStateAsDefault();
         addProperty(c);
     }
+    addProperty(normalization_);
+    addProperty(percentiles_);
+    addProperty(info_);
+    addProperty(profiling_);
+
+    info_.setReadOnly(true);
+    info_.setSerializationMode(PropertySerializationMode::None);
+
+    auto normalizationVisibility = [this]() {
+        percentiles_.setVisible(normalization_ == Normalization::AutoRange);
+        info_.setVisible(normalization_ != Normalization::TypeRange);
+    };
+    normalization_.onChange(normalizationVisibility);
+    normalizationVisibility();
 
     auto colorVisibility = [&]() {
         for (size_t i = 0; i < 10; i++) {
@@ -55,28 +78,125 @@ ImageMappingCPU::ImageMappingCPU()
 }
 
 void ImageMappingCPU::process() {
-    auto inImg = inport_.getData();
-    auto img = std::make_shared<Image>(inImg->getDimensions(), DataVec4UInt8::get());
-    auto outRep = static_cast<LayerRAMPrecision<glm::u8vec4>*>(
-        img->getColorLayer()->getEditableRepresentation<LayerRAM>());
-    glm::u8vec4* outPixels = outRep->getDataTyped();
-    util::IndexMapper2D index(inImg->getDimensions());
-
     ScalarToColorMapping map;
     for (size_t i = 0; i < numColors_.get(); i++) {
         map.addBaseColors(colors_[i].get());
     }
 
-    inImg->getColorLayer()->getRepresentation<LayerRAM>()->dispatch<void>([&](const auto inRep) {
+    // The statistics only depend on the image, changing the colors or percentiles reuses them
+    if (inport_.isChanged()) stats_.reset();
+
+    auto profile = profiling_.begin();
+    const auto image = inport_.getData();
+    if (normalization_ == Normalization::TypeRange) {
+        outport_.setData(mapImage(*image, map, profile, &pool_));
+    } else {
+        if (!stats_) {
+            stats_ = TNM067::ImageStatistics::compute(
+                *image->getColorLayer()->getRepresentation<LayerRAM>(), profile);
+        }
+        const auto percentiles = dvec2(percentiles_.get()) / 100.0;
+        const auto remap = buildRemap(*stats_, normalization_, percentiles, map);
+        outport_.setData(mapImage(*image, remap, profile, &pool_));
+
+        const auto range = stats_->getRange();
+        info_.set("[" + toString(range.x) + ", " + toString(range.y) + "], percentiles [" +
+                  toString(stats_->percentile(percentiles.x)) + ", " +
+                  toString(stats_->percentile(percentiles.y)) + "]");
+    }
+    profiling_.end();
+}
+
+namespace {
+
+/// Sets every pixel of outPixels to color(pixel) of the corresponding pixel of inImg
+template <typename Color>
+void mapPixels(const Image& inImg, glm::u8vec4* outPixels, Color color) {
+    util::IndexMapper2D index(inImg.getDimensions());
+    inImg.getColorLayer()->getRepresentation<LayerRAM>()->dispatch<void>([&](const auto inRep) {
         auto inPixels = inRep->getDataTyped();
         util::forEachPixelParallel(*inRep, [&](size2_t pos) {
             auto i = index(pos);
-            float inPixelVal = util::glm_convert_normalized<float>(inPixels[i]);
-            outPixels[i] = map.sample(inPixelVal) * 255.f;
+            outPixels[i] = color(inPixels[i]);
         });
     });
+}
+
+std::shared_ptr<Image> outputImage(const Image& inImg, TNM067::BufferPool* pool) {
+    return pool ? pool->image(inImg.getDimensions(), DataVec4UInt8::get())
+                : std::make_shared<Image>(inImg.getDimensions(), DataVec4UInt8::get());
+}
+
+glm::u8vec4* outputPixels(Image& img) {
+    return static_cast<LayerRAMPrecision<glm::u8vec4>*>(
+               img.getColorLayer()->getEditableRepresentation<LayerRAM>())
+        ->getDataTyped();
+}
+
+}  // namespace
+
+std::shared_ptr<Image> ImageMappingCPU::mapImage(const Image& inImg,
+                                                 const ScalarToColorMapping& map,
+                                                 TNM067::Profile* profile,
+                                                 TNM067::BufferPool* pool) {
+    TNM067_PROFILE_SCOPE(profile, "Color mapping");
+    auto img = outputImage(inImg, pool);
+    mapPixels(inImg, outputPixels(*img), [&](const auto& pixel) {
+        float inPixelVal = util::glm_convert_normalized<float>(pixel);
+        return glm::u8vec4(map.sample(inPixelVal) * 255.f);
+    });
+    TNM067_PROFILE_COUNT(profile, PixelsProcessed,
+                         inImg.getDimensions().x * inImg.getDimensions().y);
+
+    return img;
+}
+
+std::shared_ptr<Image> ImageMappingCPU::mapImage(const Image& inImg, const Remap& remap,
+                                                 TNM067::Profile* profile,
+                                                 TNM067::BufferPool* pool) {
+    TNM067_PROFILE_SCOPE(profile, "Remap");
+    auto img = outputImage(inImg, pool);
+    mapPixels(inImg, outputPixels(*img), [&](const auto& pixel) {
+        return remap(static_cast<double>(util::glmcomp(pixel, 0)));
+    });
+    TNM067_PROFILE_COUNT(profile, PixelsProcessed,
+                         inImg.getDimensions().x * inImg.getDimensions().y);
 
-    outport_.setData(img);
+    return img;
+}
+
+ImageMappingCPU::Remap ImageMappingCPU::buildRemap(const TNM067::ImageStatistics& stats,
+                                                   Normalization normalization,
+                                                   dvec2 percentiles,
+                                                   const ScalarToColorMapping& map) {
+    const bool equalize = normalization == Normalization::Equalize;
+    const dvec2 domain = equalize ? stats.getRange()
+                                  : dvec2(stats.percentile(percentiles.x),
+                                          stats.percentile(percentiles.y));
+    const double width = domain.y - domain.x;
+
+    Remap remap;
+    remap.offset = domain.x;
+    size_t size = 1;
+    if (width > 0.0) {
+        size = stats.isInteger() ? static_cast<size_t>(width) + 1 : Remap::remapSize;
+        remap.scale = stats.isInteger() ? 1.0 : static_cast<double>(size) / width;
+    }
+    remap.colors.resize(size);
+
+    // Integer entries hold a single value, the others are sampled at their center
+    const double center = stats.isInteger() ? 0.0 : 0.5;
+    for (size_t entry = 0; entry < size; ++entry) {
+        const double value = domain.x + (static_cast<double>(entry) + center) / remap.scale;
+        double t = 0.0;
+        if (equalize) {
+            t = stats.cdf(value);
+        } else if (width > 0.0) {
+            t = (value - domain.x) / width;
+        }
+        remap.colors[entry] = glm::u8vec4(map.sample(static_cast<float>(t)) * 255.0f);
+    }
+    return remap;
 }
 
 }  // namespace inviwo
@@ -3,12 +3,50 @@
 #include <modules/tnm067lab1/tnm067lab1moduledefine.h>
 #include <inviwo/core/processors/processor.h>
 #include <inviwo/core/properties/ordinalproperty.h>
+#include <inviwo/core/properties/optionproperty.h>
+#include <inviwo/core/properties/minmaxproperty.h>
+#include <inviwo/core/properties/stringproperty.h>
 #include <inviwo/core/ports/imageport.h>
+#include <modules/tnm067lab1/utils/scalartocolormapping.h>
+#include <modules/tnm067lab1/properties/profilingproperty.h>
+#include <modules/tnm067lab1/utils/bufferpool.h>
+#include <modules/tnm067lab1/utils/imagestatistics.h>
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <vector>
 
 namespace inviwo {
 
 class IVW_MODULE_TNM067LAB1_API ImageMappingCPU : public Processor {
 public:
+    /**
+     * How values are normalized before the color mapping. TypeRange uses the range of the data
+     * type, AutoRange the range between two percentiles of the data and Equalize the cumulative
+     * histogram of the data, which spreads the colors evenly over the pixels.
+     */
+    enum class Normalization { TypeRange, AutoRange, Equalize };
+
+    /**
+     * Color lookup table over a range of data values. For 8 and 16 bit integer data there is one
+     * entry per value, otherwise remapSize entries. Values outside of the range get the first or
+     * last color.
+     */
+    struct Remap {
+        static constexpr size_t remapSize = 4096;
+
+        double offset = 0.0;
+        double scale = 1.0;  //!< Entries per unit of data value
+        std::vector<glm::u8vec4> colors;
+
+        glm::u8vec4 operator()(double value) const {
+            const double entry = std::floor((value - offset) * scale);
+            if (!(entry > 0.0)) return colors.front();  // Also NaN
+            return colors[std::min(static_cast<size_t>(entry), colors.size() - 1)];
+        }
+    };
+
     ImageMappingCPU();
     virtual ~ImageMappingCPU() = default;
 
@@ -17,12 +55,42 @@ public:
     virtual const ProcessorInfo getProcessorInfo() const override;
     static const ProcessorInfo processorInfo_;
 
+    /**
+     * Maps the normalized values of the color layer of inImg to colors using map. This is what
+     * process() runs, exposed to allow running it outside of a processor network. The output
+     * image is taken from pool if given.
+     */
+    static std::shared_ptr<Image> mapImage(const Image& inImg, const ScalarToColorMapping& map,
+                                           TNM067::Profile* profile = nullptr,
+                                           TNM067::BufferPool* pool = nullptr);
+
+    /**
+     * Maps the first channel of the color layer of inImg to colors using a precomputed remap,
+     * see buildRemap().
+     */
+    static std::shared_ptr<Image> mapImage(const Image& inImg, const Remap& remap,
+                                           TNM067::Profile* profile = nullptr,
+                                           TNM067::BufferPool* pool = nullptr);
+
+    /**
+     * Builds the remap of AutoRange or Equalize normalization followed by map. percentiles are the
+     * fractions of the values below the ends of the range, in [0, 1], only used by AutoRange.
+     */
+    static Remap buildRemap(const TNM067::ImageStatistics& stats, Normalization normalization,
+                            dvec2 percentiles, const ScalarToColorMapping& map);
+
 private:
     ImageInport inport_;
     ImageOutport outport_;
 
     IntSizeTProperty numColors_;
     std::array<FloatVec4Property, 10> colors_;
+    TemplateOptionProperty<Normalization> normalization_;
+    FloatMinMaxProperty percentiles_;
+    StringProperty info_;
+    ProfilingProperty profiling_;
+    TNM067::BufferPool pool_;
+    std::optional<TNM067::ImageStatistics> stats_;  //!< Of the current input image once needed
 };
 
 }  // namespace inviwo
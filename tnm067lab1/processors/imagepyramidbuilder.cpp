@@ -0,0 +1,48 @@
+#include <modules/tnm067lab1/processors/imagepyramidbuilder.h>
+#include <modules/tnm067lab1/utils/imagepyramid.h>
+
+namespace inviwo {
+
+// The Class Identifier has to be globally unique. Use a reverse DNS naming scheme
+const ProcessorInfo ImagePyramidBuilder::processorInfo_{
+    "org.inviwo.ImagePyramidBuilder",  // Class identifier
+    "Image Pyramid Builder",           // Display name
+    "TNM067",                          // Category
+    CodeState::Experimental,           // Code state
+    Tags::CPU,                         // Tags
+};
+const ProcessorInfo ImagePyramidBuilder::getProcessorInfo() const { return processorInfo_; }
+
+ImagePyramidBuilder::ImagePyramidBuilder()
+    : Processor()
+    , inport_("inport", true)
+    , outport_("outport", false)
+    , levels_("levels", "Levels", 8, 1, 16)
+    , level_("level", "Output Level", 0, 0, 15)
+    , filter_("filter", "Filter",
+              {
+    {"box", "Box", TNM067::ReductionFilter::Box},
+    {"area", "Area", TNM067::ReductionFilter::Area},
+    {"lanczos3", "Lanczos 3", TNM067::ReductionFilter::Lanczos3},
+}, 1)
+, profiling_("profiling", "Profiling") {
+    addPort(inport_);
+    addPort(outport_);
+    addProperty(levels_);
+    addProperty(level_);
+    addProperty(filter_);
+    addProperty(profiling_);
+}
+
+void ImagePyramidBuilder::process() {
+    if (pyramid_.empty() || inport_.isChanged() || levels_.isModified() || filter_.isModified()) {
+        auto profile = profiling_.begin();
+        pyramid_ = TNM067::buildImagePyramid(*inport_.getData(), levels_.get(), filter_.get(),
+                                             profile);
+        profiling_.end();
+    }
+
+    outport_.setData(pyramid_[std::min(level_.get(), pyramid_.size() - 1)]);
+}
+
+}  // namespace inviwo
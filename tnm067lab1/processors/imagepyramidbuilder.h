@@ -0,0 +1,41 @@
+#pragma once
+
+#include <modules/tnm067lab1/tnm067lab1moduledefine.h>
+#include <inviwo/core/processors/processor.h>
+#include <inviwo/core/properties/ordinalproperty.h>
+#include <inviwo/core/properties/optionproperty.h>
+#include <inviwo/core/ports/imageport.h>
+#include <modules/tnm067lab1/properties/profilingproperty.h>
+#include <modules/tnm067lab1/utils/resampling.h>
+
+namespace inviwo {
+
+/**
+ * \class ImagePyramidBuilder
+ * \brief Builds an anti-aliased image pyramid of the input and outputs one of its levels.
+ * The pyramid is only rebuilt when the input, the number of levels or the filter changes, so
+ * switching between levels is cheap.
+ */
+class IVW_MODULE_TNM067LAB1_API ImagePyramidBuilder : public Processor {
+public:
+    ImagePyramidBuilder();
+    virtual ~ImagePyramidBuilder() = default;
+
+    virtual void process() override;
+
+    virtual const ProcessorInfo getProcessorInfo() const override;
+    static const ProcessorInfo processorInfo_;
+
+private:
+    ImageInport inport_;
+    ImageOutport outport_;
+
+    IntSizeTProperty levels_;
+    IntSizeTProperty level_;
+    TemplateOptionProperty<TNM067::ReductionFilter> filter_;
+    ProfilingProperty profiling_;
+
+    std::vector<std::shared_ptr<Image>> pyramid_;
+};
+
+}  // namespace inviwo
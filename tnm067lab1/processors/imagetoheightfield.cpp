@@ -1,7 +1,11 @@
 #include <modules/tnm067lab1/processors/imagetoheightfield.h>
 #include <modules/tnm067lab1/utils/scalartocolormapping.h>
-#include <inviwo/core/util/imageramutils.h>
 #include <inviwo/core/datastructures/image/layerram.h>
+#include <modules/tnm067lab1/utils/interpolationmethods.h>
+#include <modules/tnm067lab1/utils/parallelutils.h>
+
+#include <atomic>
+#include <limits>
 
 namespace inviwo {
 
@@ -16,10 +20,18 @@ const ProcessorInfo ImageToHeightfield::processorInfo_{
 const ProcessorInfo ImageToHeightfield::getProcessorInfo() const { return processorInfo_; }
 
 ImageToHeightfield::ImageToHeightfield()
-    : Processor()
+    : PoolProcessor(pool::Option::KeepOldResults | pool::Option::DelayDispatch)
     , imageInport_("imageInport", true)
     , meshOutport_("meshOutport")
     , heightScaleFactor_("heightScaleFactor", "Height Scale Factor", 1.0f, 0.001f, 2.0f, 0.001f)
+    , mode_("mode", "Mode",
+            {{"boxes", "Boxes", Mode::Boxes}, {"surface", "Continuous Surface", Mode::Surface}}, 0)
+    , resampling_("resampling", "Resampling",
+                  {{"none", "None", Resampling::None},
+                   {"bilinear", "Bilinear", Resampling::Bilinear},
+                   {"biquadratic", "Biquadratic", Resampling::Biquadratic}},
+                  0)
+    , gridScale_("gridScale", "Grid Scale", 1.0f, 0.125f, 4.0f, 0.125f)
     , numColors_("numColors", "Number of colors", 2, 1, 10)
     , colors_(
           {FloatVec4Property{"color1", "Color 1", util::ordinalColor(0.0f, 0.0f, 0.0f, 1.0f)},
@@ -31,16 +43,26 @@ ImageToHeightfield::ImageToHeightfield()
            FloatVec4Property{"color7", "Color 7", util::ordinalColor(1.0f, 1.0f, 1.0f, 1.0f)},
            FloatVec4Property{"color8", "Color 8", util::ordinalColor(1.0f, 1.0f, 1.0f, 1.0f)},
            FloatVec4Property{"color9", "Color 9", util::ordinalColor(1.0f, 1.0f, 1.0f, 1.0f)},
-           FloatVec4Property{"color10", "Color 10", util::ordinalColor(1.0f, 1.0f, 1.0f, 1.0f)}}) {
+           FloatVec4Property{"color10", "Color 10", util::ordinalColor(1.0f, 1.0f, 1.0f, 1.0f)}})
+    , background_("background", "Run in Background", true)
+    , meshCache_("meshCache", "Mesh Cache")
+    , profiling_("profiling", "Profiling")
+    , pool_(std::make_shared<TNM067::BufferPool>()) {
 
     addPort(imageInport_);
     addPort(meshOutport_);
     addProperty(heightScaleFactor_);
+    addProperty(mode_);
+    addProperty(resampling_);
+    addProperty(gridScale_);
 
     addProperty(numColors_);
     for (auto& c : colors_) {
         addProperty(c);
     }
+    addProperty(background_);
+    addProperty(meshCache_);
+    addProperty(profiling_);
 
     auto colorVisibility = [&]() {
         for (size_t i = 0; i < 10; i++) {
@@ -50,11 +72,18 @@ ImageToHeightfield::ImageToHeightfield()
 
     numColors_.onChange(colorVisibility);
     colorVisibility();
+
+    auto surfaceVisibility = [this]() {
+        resampling_.setVisible(mode_ == Mode::Surface);
+        gridScale_.setVisible(mode_ == Mode::Surface && resampling_ != Resampling::None);
+    };
+    mode_.onChange(surfaceVisibility);
+    resampling_.onChange(surfaceVisibility);
+    surfaceVisibility();
 }
 
 namespace {
-using HFMesh = TypedMesh<buffertraits::PositionsBuffer, buffertraits::NormalBuffer,
-                         buffertraits::ColorsBuffer>;
+using HFMesh = ImageToHeightfield::HFMesh;
 
 void addFace(std::vector<HFMesh::Vertex>& vertices, std::vector<unsigned int>& indices,
              const vec3& c1, const vec3& c2, const vec3& c3, const vec3& c4, const vec3& normal,
@@ -70,29 +99,50 @@ void addFace(std::vector<HFMesh::Vertex>& vertices, std::vector<unsigned int>& i
                    {startID + 0, startID + 1, startID + 2, startID + 0, startID + 2, startID + 3});
 }
 
-std::shared_ptr<Mesh> buildMesh(const LayerRAM& image, const ScalarToColorMapping& map,
-                                float scaleFactor) {
+std::shared_ptr<HFMesh> outputMesh(TNM067::BufferPool* pool, ConnectivityType ct) {
+    if (pool) return pool->mesh<HFMesh>(DrawType::Triangles, ct);
+    auto mesh = std::make_shared<HFMesh>();
+    mesh->addIndexBuffer(DrawType::Triangles, ct);
+    return mesh;
+}
+
+}  // namespace
+
+std::shared_ptr<Mesh> ImageToHeightfield::buildMesh(const LayerRAM& image,
+                                                    const ScalarToColorMapping& map,
+                                                    float scaleFactor,
+                                                    TNM067::Profile* profile,
+                                                    TNM067::BufferPool* pool,
+                                                    const TNM067::JobControl* control) {
+    TNM067_PROFILE_SCOPE(profile, "Build mesh");
     const auto dims = image.getDimensions();
 
-    auto mesh = std::make_shared<HFMesh>();
+    auto mesh = outputMesh(pool, ConnectivityType::None);
     auto& indices =
-        mesh->addIndexBuffer(DrawType::Triangles, ConnectivityType::None)->getDataContainer();
+        mesh->getIndexBuffers().front().second->getEditableRAMRepresentation()->getDataContainer();
 
-    std::vector<HFMesh::Vertex> vertices;
+    std::vector<HFMesh::Vertex> ownVertices;
+    auto& vertices = pool ? pool->scratch<std::vector<HFMesh::Vertex>>() : ownVertices;
+    vertices.clear();
 
     const auto bufferSize = 24 * dims.x * dims.y;
     indices.reserve(bufferSize);
     vertices.reserve(bufferSize);
 
+    TNM067_PROFILE_STAGE(mappingTimer, profile, "Color mapping");
+    TNM067_PROFILE_STAGE(faceTimer, profile, "addFace");
+
     const vec2 cellSize = 1.0f / vec2(dims);
-    util::forEachPixel(image, [&](const size2_t& pos) {
+    auto addBox = [&](const size2_t& pos) {
         const vec2 origin2D = vec2(pos) * cellSize;
         const vec3 origin(origin2D.x, 0.0f, origin2D.y);
 
         // TODO: sample image
+        TNM067_PROFILE_STAGE_START(mappingTimer);
         const float imageValue = image.getAsDouble(pos);
         const vec4 color = vec4(map.sample(imageValue));
         const float height = imageValue * scaleFactor;
+        TNM067_PROFILE_STAGE_STOP(mappingTimer);
 
         // Box Corners
         const auto zero = origin + vec3(0.0f, 0.0f, 0.0f);
@@ -112,32 +162,245 @@ std::shared_ptr<Mesh> buildMesh(const LayerRAM& image, const ScalarToColorMappin
         constexpr auto front = vec3(0.0f, 0.0f, -1.0f);
         constexpr auto back = vec3(0.0f, 0.0f, 1.0f);
 
+        TNM067_PROFILE_STAGE_START(faceTimer);
         addFace(vertices, indices, zero, px, pxpz, pz, down, color);       // Bottom face
         addFace(vertices, indices, py, pxpy, pxpypz, pypz, up, color);     // Top face
         addFace(vertices, indices, zero, pz, pypz, py, left, color);       // Left face
         addFace(vertices, indices, px, pxpz, pxpypz, pxpy, right, color);  // Right face
         addFace(vertices, indices, zero, px, pxpy, py, front, color);      // Front face
         addFace(vertices, indices, pz, pxpz, pxpypz, pypz, back, color);   // Back face
-    });
+        TNM067_PROFILE_STAGE_STOP(faceTimer);
+    };
 
+    size2_t pos{};
+    for (pos.y = 0; pos.y < dims.y; ++pos.y) {
+        if (control && control->stopped()) return nullptr;
+        for (pos.x = 0; pos.x < dims.x; ++pos.x) {
+            addBox(pos);
+        }
+        if (control) control->progress(pos.y + 1, dims.y);
+    }
+    TNM067_PROFILE_COUNT(profile, PixelsProcessed, dims.x * dims.y);
+
+    TNM067_PROFILE_SCOPE(profile, "Add vertices");
     mesh->addVertices(vertices);
 
     return mesh;
 }
 
-}  // namespace
+std::shared_ptr<Mesh> ImageToHeightfield::buildSurface(const LayerRAM& image,
+                                                       const ScalarToColorMapping& map,
+                                                       float scaleFactor, Resampling resampling,
+                                                       size2_t gridSize,
+                                                       TNM067::Profile* profile,
+                                                       TNM067::BufferPool* pool,
+                                                       const TNM067::JobControl* control) {
+    TNM067_PROFILE_SCOPE(profile, "Build surface");
+    const size2_t dims = image.getDimensions();
+    const size2_t grid = resampling == Resampling::None ? dims : glm::max(gridSize, size2_t(1));
+
+    auto mesh = outputMesh(pool, ConnectivityType::Strip);
+    auto& indices =
+        mesh->getIndexBuffers().front().second->getEditableRAMRepresentation()->getDataContainer();
+
+    std::vector<HFMesh::Vertex> ownVertices;
+    std::vector<float> ownValues;
+    auto& vertices = pool ? pool->scratch<std::vector<HFMesh::Vertex>>() : ownVertices;
+    auto& values = pool ? pool->scratch<std::vector<float>>() : ownValues;
+    vertices.resize(grid.x * grid.y);
+    values.resize(grid.x * grid.y);
+
+    auto pixel = [&](ivec2 pos) {
+        pos = glm::clamp(pos, ivec2(0), ivec2(dims) - ivec2(1));
+        return static_cast<float>(image.getAsDouble(size2_t(pos)));
+    };
+    // Image coordinates of the grid points, with the pixel centers at integer coordinates
+    const vec2 step = vec2(dims) / vec2(grid);
+    auto sample = [&](size2_t point) {
+        if (resampling == Resampling::None) return pixel(ivec2(point));
+
+        const vec2 c = (vec2(point) + 0.5f) * step - 0.5f;
+        const ivec2 first(glm::floor(c));
+        const vec2 t = c - glm::floor(c);
+        if (resampling == Resampling::Bilinear) {
+            return TNM067::Interpolation::bilinear<float, float>(
+                {pixel(first), pixel(first + ivec2(1, 0)), pixel(first + ivec2(0, 1)),
+                 pixel(first + ivec2(1, 1))},
+                t.x, t.y);
+        }
+        // Taps at first, +1 and +2 with quadratic() at half the fraction, as in ImageUpsampler
+        std::array<float, 9> taps;
+        for (int j = 0; j < 3; ++j) {
+            for (int i = 0; i < 3; ++i) taps[i + 3 * j] = pixel(first + ivec2(i, j));
+        }
+        return TNM067::Interpolation::biQuadratic<float, float>(taps, t.x / 2, t.y / 2);
+    };
+
+    // Both passes report their rows, so progress goes to one when both are done
+    std::atomic<size_t> rowsDone{0};
+    auto rowDone = [&]() {
+        if (control) control->progress(++rowsDone, 2 * grid.y);
+    };
+    std::atomic<bool> stopped{false};
+    auto checkpoint = [&]() {
+        if (control && control->stopped()) stopped = true;
+        return !stopped;
+    };
+
+    {
+        TNM067_PROFILE_SCOPE(profile, "Sampling");
+        TNM067::forEachRangeParallel(grid.y, [&](size_t begin, size_t end, size_t) {
+            for (size_t y = begin; y < end && checkpoint(); ++y) {
+                for (size_t x = 0; x < grid.x; ++x) {
+                    values[x + y * grid.x] = sample({x, y});
+                }
+                rowDone();
+            }
+        });
+        TNM067_PROFILE_COUNT(profile, PixelsProcessed, grid.x * grid.y);
+    }
+    if (stopped) return nullptr;
+
+    {
+        TNM067_PROFILE_SCOPE(profile, "Vertices and normals");
+        const vec2 spacing = 1.0f / vec2(grid);
+        auto height = [&](size_t x, size_t y) { return values[x + y * grid.x] * scaleFactor; };
+        TNM067::forEachRangeParallel(grid.y, [&](size_t begin, size_t end, size_t) {
+            for (size_t y = begin; y < end && checkpoint(); ++y) {
+                const size_t y0 = y > 0 ? y - 1 : y;
+                const size_t y1 = y + 1 < grid.y ? y + 1 : y;
+                for (size_t x = 0; x < grid.x; ++x) {
+                    const size_t x0 = x > 0 ? x - 1 : x;
+                    const size_t x1 = x + 1 < grid.x ? x + 1 : x;
+                    // One-sided differences at the borders, flat if the grid is a single row
+                    const float dx = x1 > x0 ? (height(x1, y) - height(x0, y)) /
+                                                   ((x1 - x0) * spacing.x)
+                                             : 0.0f;
+                    const float dz = y1 > y0 ? (height(x, y1) - height(x, y0)) /
+                                                   ((y1 - y0) * spacing.y)
+                                             : 0.0f;
+
+                    const float value = values[x + y * grid.x];
+                    const vec2 origin2D = (vec2(x, y) + 0.5f) * spacing;
+                    vertices[x + y * grid.x] =
+                        HFMesh::Vertex(vec3(origin2D.x, value * scaleFactor, origin2D.y),
+                                       glm::normalize(vec3(-dx, 1.0f, -dz)),
+                                       vec4(map.sample(value)));
+                }
+                rowDone();
+            }
+        });
+    }
+    if (stopped) return nullptr;
+
+    {
+        TNM067_PROFILE_SCOPE(profile, "Strip indices");
+        // Every strip alternates between a grid row and the next one, winding counter clockwise
+        // seen from above, and is followed by a restart index except the last
+        constexpr auto restart = std::numeric_limits<std::uint32_t>::max();
+        const size_t strips = grid.y > 1 ? grid.y - 1 : 0;
+        const size_t stripLength = 2 * grid.x + 1;
+        indices.resize(strips > 0 ? strips * stripLength - 1 : 0);
+        TNM067::forEachRangeParallel(strips, [&](size_t begin, size_t end, size_t) {
+            for (size_t y = begin; y < end; ++y) {
+                auto out = indices.begin() + y * stripLength;
+                for (size_t x = 0; x < grid.x; ++x) {
+                    *out++ = static_cast<std::uint32_t>(x + y * grid.x);
+                    *out++ = static_cast<std::uint32_t>(x + (y + 1) * grid.x);
+                }
+                if (y + 1 < strips) *out = restart;
+            }
+        });
+    }
+
+    TNM067_PROFILE_SCOPE(profile, "Add vertices");
+    mesh->addVertices(vertices);
+
+    return mesh;
+}
 
 void ImageToHeightfield::process() {
-    const auto layer = imageInport_.getData()->getColorLayer()->getRepresentation<LayerRAM>();
+    const auto image = imageInport_.getData();
+    const auto layer = image->getColorLayer()->getRepresentation<LayerRAM>();
 
     ScalarToColorMapping map;
     for (size_t i = 0; i < numColors_.get(); i++) {
         map.addBaseColors(colors_[i].get());
     }
 
-    const auto mesh = buildMesh(*layer, map, heightScaleFactor_);
+    const auto cache = meshCache_.getCache();
+    const auto generation = ++generation_;
 
-    meshOutport_.setData(mesh);
+    // The cache key covers everything the mesh depends on. It hashes the whole image, so it is
+    // only computed with the cache enabled.
+    std::uint64_t key = 0;
+    if (cache.isEnabled()) {
+        TNM067::Hasher hasher;
+        hasher.add(std::string("ImageToHeightfield.v2"))
+            .add(mode_.get())
+            .add(resampling_.get())
+            .add(gridScale_.get())
+            .add(layer->getDimensions())
+            .add(layer->getDataFormatId())
+            .add(layer->getData(), glm::compMul(layer->getDimensions()) *
+                                       layer->getDataFormat()->getSize())
+            .add(heightScaleFactor_.get())
+            .add(numColors_.get());
+        for (size_t i = 0; i < numColors_.get(); i++) {
+            hasher.add(colors_[i].get());
+        }
+        key = hasher.get();
+
+        auto cached = std::make_shared<HFMesh>();
+        if (cache.load(key, *cached)) {
+            meshOutport_.setData(cached);
+            return;
+        }
+    }
+
+    const auto gridSize = glm::max(
+        size2_t(glm::round(vec2(layer->getDimensions()) * gridScale_.get())), size2_t(1));
+    auto build = [layer, map, scaleFactor = heightScaleFactor_.get(), mode = mode_.get(),
+                  resampling = resampling_.get(),
+                  gridSize](TNM067::Profile* profile, TNM067::BufferPool* pool,
+                            const TNM067::JobControl* control) {
+        if (mode == Mode::Surface) {
+            return buildSurface(*layer, map, scaleFactor, resampling, gridSize, profile, pool,
+                                control);
+        }
+        return buildMesh(*layer, map, scaleFactor, profile, pool, control);
+    };
+
+    if (!background_) {
+        // A stale background job may still be using the pool
+        const auto lock = pool_->lock();
+        auto profile = profiling_.begin();
+        const auto mesh = build(profile, pool_.get(), nullptr);
+        profiling_.end();
+        cache.store(key, *mesh);
+
+        meshOutport_.setData(mesh);
+        return;
+    }
+
+    // The image is captured to keep the layer alive while the job runs
+    auto job = [image, build, key, cache, buffers = pool_](pool::Stop stop,
+                                                          pool::Progress progress) {
+        const auto lock = buffers->lock();
+        const auto profile = ProfilingProperty::beginJob();
+        const TNM067::JobControl control{[stop]() { return stop(); },
+                                         [progress](float done) { progress(done); }};
+        auto mesh = build(profile.get(), buffers.get(), &control);
+        if (profile) profile->end();
+        if (mesh) cache.store(key, *mesh);
+        return std::make_pair(mesh, profile);
+    };
+    dispatchOne(job, [this, generation](auto result) {
+        if (!result.first || generation != generation_) return;
+        if (result.second) profiling_.report(*result.second);
+        meshOutport_.setData(result.first);
+        newResults();
+    });
 }
 
 }  // namespace inviwo
@@ -1,18 +1,44 @@
 #pragma once
 
 #include <modules/tnm067lab1/tnm067lab1moduledefine.h>
-#include <inviwo/core/processors/processor.h>
+#include <inviwo/core/processors/poolprocessor.h>
 #include <inviwo/core/properties/ordinalproperty.h>
+#include <inviwo/core/properties/boolproperty.h>
+#include <inviwo/core/properties/optionproperty.h>
 #include <inviwo/core/ports/imageport.h>
 #include <inviwo/core/ports/meshport.h>
 #include <modules/base/properties/gaussianproperty.h>
 #include <modules/tnm067lab1/utils/scalartocolormapping.h>
 #include <inviwo/core/datastructures/geometry/basicmesh.h>
+#include <inviwo/core/datastructures/geometry/typedmesh.h>
+#include <modules/tnm067lab1/properties/profilingproperty.h>
+#include <modules/tnm067lab1/properties/meshcacheproperty.h>
+#include <modules/tnm067lab1/utils/bufferpool.h>
+#include <modules/tnm067lab1/utils/jobcontrol.h>
 
 namespace inviwo {
 
-class IVW_MODULE_TNM067LAB1_API ImageToHeightfield : public Processor {
+/**
+ * \class ImageToHeightfield
+ * \brief Builds a heightfield mesh from the first color layer of an image.
+ * The heightfield is either one box per pixel or a continuous surface with one vertex per grid
+ * point, which has about 24 times fewer vertices and 6 times fewer triangles at the image size.
+ * With Run in Background set the mesh is built on the thread pool. A new image or property change
+ * stops the job in flight and the previous mesh stays on the outport until the new one is done.
+ */
+class IVW_MODULE_TNM067LAB1_API ImageToHeightfield : public PoolProcessor {
 public:
+    using HFMesh = TypedMesh<buffertraits::PositionsBuffer, buffertraits::NormalBuffer,
+                             buffertraits::ColorsBuffer>;
+
+    enum class Mode { Boxes, Surface };
+
+    /**
+     * How the surface samples the image at its grid points. None uses one grid point per pixel,
+     * the others resample the image with TNM067::Interpolation::bilinear or biQuadratic.
+     */
+    enum class Resampling { None, Bilinear, Biquadratic };
+
     ImageToHeightfield();
     virtual ~ImageToHeightfield() = default;
 
@@ -21,14 +47,49 @@ public:
     virtual const ProcessorInfo getProcessorInfo() const override;
     static const ProcessorInfo processorInfo_;
 
+    /**
+     * Builds the heightfield mesh for image, one box per pixel with its height given by the pixel
+     * value times scaleFactor and its color by map. This is what process() runs, exposed to allow
+     * running it outside of a processor network. The mesh and vertex storage are taken from pool
+     * if given. Returns nullptr if control is stopped, which is checked once per image row.
+     */
+    static std::shared_ptr<Mesh> buildMesh(const LayerRAM& image, const ScalarToColorMapping& map,
+                                           float scaleFactor, TNM067::Profile* profile = nullptr,
+                                           TNM067::BufferPool* pool = nullptr,
+                                           const TNM067::JobControl* control = nullptr);
+
+    /**
+     * Builds a continuous heightfield surface for image over a grid of gridSize points, or one
+     * point per pixel if resampling is None. The grid points are spread over the unit square
+     * like the pixel centers, with their height and color taken from the resampled image like
+     * in buildMesh(). Normals are central differences of the heights. The triangles are given as
+     * one triangle strip per grid row, separated by the restart index 0xFFFFFFFF. Returns nullptr
+     * if control is stopped, which is checked once per grid row.
+     */
+    static std::shared_ptr<Mesh> buildSurface(const LayerRAM& image,
+                                              const ScalarToColorMapping& map, float scaleFactor,
+                                              Resampling resampling = Resampling::None,
+                                              size2_t gridSize = size2_t(0),
+                                              TNM067::Profile* profile = nullptr,
+                                              TNM067::BufferPool* pool = nullptr,
+                                              const TNM067::JobControl* control = nullptr);
+
 private:
     ImageInport imageInport_;
     MeshOutport meshOutport_;
     FloatProperty heightScaleFactor_;
+    TemplateOptionProperty<Mode> mode_;
+    TemplateOptionProperty<Resampling> resampling_;
+    FloatProperty gridScale_;  //!< Grid points per pixel along each axis when resampling
 
     IntSizeTProperty numColors_;
     std::array<FloatVec4Property, 10> colors_;
-
+    BoolProperty background_;
+    MeshCacheProperty meshCache_;
+    ProfilingProperty profiling_;
+    // Shared with the background jobs, which may outlive a process() call
+    std::shared_ptr<TNM067::BufferPool> pool_;
+    size_t generation_ = 0;  //!< Counts process() calls, results of older jobs are dropped
 };
 
 }  // namespace inviwo
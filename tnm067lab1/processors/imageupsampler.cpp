@@ -2,6 +2,9 @@
 #include <modules/opengl/texture/textureutils.h>
 #include <modules/tnm067lab1/processors/imageupsampler.h>
 #include <modules/tnm067lab1/utils/interpolationmethods.h>
+#include <modules/tnm067lab1/utils/resampling.h>
+#include <modules/tnm067lab1/utils/fixedpoint.h>
+#include <modules/tnm067lab1/utils/parallelutils.h>
 #include <inviwo/core/datastructures/image/layerram.h>
 #include <inviwo/core/datastructures/image/layerramprecision.h>
 #include <inviwo/core/util/imageramutils.h>
@@ -10,10 +13,53 @@ namespace inviwo {
 
 namespace detail {
 
+/**
+ * Upsampling with a separable N x N tap kernel, the weights of every row and column are looked up
+ * in the per-axis tables. Rows are processed in parallel.
+ */
+template <size_t N, typename T, typename F>
+void upsampleSeparable(const LayerRAMPrecision<T>& inputImage, LayerRAMPrecision<T>& outputImage,
+                       const TNM067::Interpolation::KernelTable<N, F>& tableX,
+                       const TNM067::Interpolation::KernelTable<N, F>& tableY) {
+    using FT = TNM067::resample_float_t<T>;
+
+    const ivec2 maxPos = ivec2(inputImage.getDimensions()) - ivec2(1);
+    const size2_t outputSize = outputImage.getDimensions();
+    const T* inPixels = inputImage.getDataTyped();
+    T* outPixels = outputImage.getDataTyped();
+
+    TNM067::forEachRangeParallel(outputSize.y, [&](size_t begin, size_t end, size_t) {
+        std::array<FT, N * N> values;
+        for (size_t y = begin; y < end; ++y) {
+            int firstY = 0;
+            const auto& wy = tableY(y, firstY);
+            for (size_t x = 0; x < outputSize.x; ++x) {
+                int firstX = 0;
+                const auto& wx = tableX(x, firstX);
+                for (size_t j = 0; j < N; ++j) {
+                    const int sy = glm::clamp(firstY + static_cast<int>(j), 0, maxPos.y);
+                    for (size_t i = 0; i < N; ++i) {
+                        const int sx = glm::clamp(firstX + static_cast<int>(i), 0, maxPos.x);
+                        values[i + j * N] = static_cast<FT>(inPixels[sx + sy * (maxPos.x + 1)]);
+                    }
+                }
+                outPixels[x + y * outputSize.x] =
+                    TNM067::toPixel<T>(TNM067::Interpolation::separable<N>(values, wx, wy));
+            }
+        }
+    });
+}
+
+/**
+ * Interpolation is done on all channels of a pixel at once. T is the interleaved pixel type, a
+ * scalar or a glm vector, and every tap is converted to the matching floating point type FT (same
+ * number of channels) before interpolating, so the channel count is known at compile time.
+ */
 template <typename T>
 void upsample(ImageUpsampler::IntepolationMethod method, const LayerRAMPrecision<T>& inputImage,
               LayerRAMPrecision<T>& outputImage) {
-    using F = typename float_type<T>::type;
+    using FT = TNM067::resample_float_t<T>;
+    using F = typename util::value_type<FT>::type;
     
     const size2_t inputSize = inputImage.getDimensions();
     const size2_t outputSize = outputImage.getDimensions();
@@ -29,6 +75,59 @@ void upsample(ImageUpsampler::IntepolationMethod method, const LayerRAMPrecision
         pos = glm::clamp(pos, decltype(pos)(0), decltype(pos)(outputSize - size2_t(1)));
         return pos.x + pos.y * outputSize.x;
     };
+    auto sample = [&](ivec2 pos) -> FT { return static_cast<FT>(inPixels[inIndex(pos)]); };
+    auto toPixel = [](const FT& value) -> T { return TNM067::toPixel<T>(value); };
+    
+    // 8 and 16 bit scalar images interpolate with integer weights, see TNM067::FixedPoint
+    auto separable = [&](const auto& tableX, const auto& tableY) {
+        if constexpr (TNM067::FixedPoint::supported<T>) {
+            namespace fp = TNM067::FixedPoint;
+            using Traits = fp::Traits<T>;
+            fp::resample(inPixels, inputSize, outPixels, outputSize,
+                         fp::quantize(tableX, inputSize.x, outputSize.x, Traits::weightBitsX),
+                         fp::quantize(tableY, inputSize.y, outputSize.y, Traits::weightBitsY));
+        } else {
+            upsampleSeparable(inputImage, outputImage, tableX, tableY);
+        }
+    };
+
+    using TNM067::Interpolation::KernelTable;
+    switch (method) {
+        case ImageUpsampler::IntepolationMethod::Bilinear: {
+            if constexpr (TNM067::FixedPoint::supported<T>) {
+                // Same taps as below, floor(c) and floor(c) + 1
+                auto weights = [](F t) { return std::array<F, 2>{1 - t, t}; };
+                separable(KernelTable<2, F>(inputSize.x, outputSize.x, 0.0, 0, weights),
+                          KernelTable<2, F>(inputSize.y, outputSize.y, 0.0, 0, weights));
+                return;
+            }
+            break;
+        }
+        case ImageUpsampler::IntepolationMethod::Biquadratic: {
+            // Move to center of pixels, taps at floor(c), +1 and +2 and quadratic() evaluated at
+            // half the fractional part
+            auto weights = [](F t) { return TNM067::Interpolation::quadraticWeights<F>(t / 2); };
+            separable(KernelTable<3, F>(inputSize.x, outputSize.x, -0.5, 0, weights),
+                      KernelTable<3, F>(inputSize.y, outputSize.y, -0.5, 0, weights));
+            return;
+        }
+        case ImageUpsampler::IntepolationMethod::Bicubic:
+        case ImageUpsampler::IntepolationMethod::CatmullRom:
+        case ImageUpsampler::IntepolationMethod::BSpline: {
+            using TNM067::Interpolation::CubicKernel;
+            const auto kernel =
+                method == ImageUpsampler::IntepolationMethod::Bicubic      ? CubicKernel::Bicubic
+                : method == ImageUpsampler::IntepolationMethod::CatmullRom ? CubicKernel::CatmullRom
+                                                                            : CubicKernel::BSpline;
+            // Taps at floor(c) - 1 ... floor(c) + 2
+            auto weights = [kernel](F t) { return TNM067::Interpolation::cubicWeights(kernel, t); };
+            separable(KernelTable<4, F>(inputSize.x, outputSize.x, 0.0, -1, weights),
+                      KernelTable<4, F>(inputSize.y, outputSize.y, 0.0, -1, weights));
+            return;
+        }
+        default:
+            break;
+    }
     
     util::forEachPixel(outputImage, [&](ivec2 outImageCoords) {
         // outImageCoords: Exact pixel coordinates in the output image currently writing to
@@ -39,10 +138,6 @@ void upsample(ImageUpsampler::IntepolationMethod method, const LayerRAMPrecision
         
         T finalColor(0);
         
-        // DUMMY COLOR, remove or overwrite this bellow
-        //        finalColor = inPixels[inIndex(
-        //            glm::clamp(size2_t(outImageCoords), size2_t(0), size2_t(inputSize - size2_t(1))))];
-        
         switch (method) {
             case ImageUpsampler::IntepolationMethod::PiecewiseConstant: {
                 // Task 6
@@ -57,42 +152,18 @@ void upsample(ImageUpsampler::IntepolationMethod method, const LayerRAMPrecision
                 ivec2 inImageCoords_floor = glm::floor(inImageCoords);
                 
                 // get the color for each pixel adjecent up to the right.
-                std::array<T, 4> values = {
-                    inPixels[inIndex(inImageCoords_floor)],
-                    inPixels[inIndex(inImageCoords_floor + ivec2(1, 0))],
-                    inPixels[inIndex(inImageCoords_floor + ivec2(0, 1))],
-                    inPixels[inIndex(inImageCoords_floor + ivec2(1, 1))]
+                std::array<FT, 4> values = {
+                    sample(inImageCoords_floor),
+                    sample(inImageCoords_floor + ivec2(1, 0)),
+                    sample(inImageCoords_floor + ivec2(0, 1)),
+                    sample(inImageCoords_floor + ivec2(1, 1))
                 };
                 
                 // keep only the decimal so we get a number between 0 and 1
-                double x = inImageCoords.x - floor(inImageCoords.x);
-                double y = inImageCoords.y - floor(inImageCoords.y);
-                
-                finalColor = TNM067::Interpolation::bilinear(values, x, y);
-                
-                break;
-            }
-            case ImageUpsampler::IntepolationMethod::Biquadratic: {
-                // Move to center of pixels
-                inImageCoords -= 0.5;
-                ivec2 samplePos(glm::floor(inImageCoords));
+                F x = static_cast<F>(inImageCoords.x - floor(inImageCoords.x));
+                F y = static_cast<F>(inImageCoords.y - floor(inImageCoords.y));
                 
-                // InPixels handles clamping of values
-                std::array<T, 9> values = {
-                    inPixels[inIndex(samplePos)],
-                    inPixels[inIndex(samplePos + ivec2(1, 0))],
-                    inPixels[inIndex(samplePos + ivec2(2, 0))],
-                    inPixels[inIndex(samplePos + ivec2(0, 1))],
-                    inPixels[inIndex(samplePos + ivec2(1, 1))],
-                    inPixels[inIndex(samplePos + ivec2(2, 1))],
-                    inPixels[inIndex(samplePos + ivec2(0, 2))],
-                    inPixels[inIndex(samplePos + ivec2(1, 2))],
-                    inPixels[inIndex(samplePos + ivec2(2, 2))],
-                };
-
-                double x = (inImageCoords.x - int(inImageCoords.x)) / 2.0;
-                double y = (inImageCoords.y - int(inImageCoords.y)) / 2.0;
-                finalColor = TNM067::Interpolation::biQuadratic(values, x, y);
+                finalColor = toPixel(TNM067::Interpolation::bilinear(values, x, y));
                 
                 break;
             }
@@ -102,18 +173,18 @@ void upsample(ImageUpsampler::IntepolationMethod method, const LayerRAMPrecision
                 ivec2 inImageCoords_floor = glm::floor(inImageCoords);
                 
                 // get the color for each pixel adjecent up to the right.
-                std::array<T, 4> values = {
-                    inPixels[inIndex(inImageCoords_floor)],
-                    inPixels[inIndex(inImageCoords_floor + ivec2(1, 0))],
-                    inPixels[inIndex(inImageCoords_floor + ivec2(0, 1))],
-                    inPixels[inIndex(inImageCoords_floor + ivec2(1, 1))]
+                std::array<FT, 4> values = {
+                    sample(inImageCoords_floor),
+                    sample(inImageCoords_floor + ivec2(1, 0)),
+                    sample(inImageCoords_floor + ivec2(0, 1)),
+                    sample(inImageCoords_floor + ivec2(1, 1))
                 };
                 
                 // keep only the decimal so we get a number between 0 and 1
-                double x = inImageCoords.x - floor(inImageCoords.x);
-                double y = inImageCoords.y - floor(inImageCoords.y);
+                F x = static_cast<F>(inImageCoords.x - floor(inImageCoords.x));
+                F y = static_cast<F>(inImageCoords.y - floor(inImageCoords.y));
                 
-                finalColor = TNM067::Interpolation::barycentric(values, x, y);
+                finalColor = toPixel(TNM067::Interpolation::barycentric(values, x, y));
                 break;
             }
             default:
@@ -146,31 +217,73 @@ ImageUpsampler::ImageUpsampler()
     {"bilinear", "Bilinear", IntepolationMethod::Bilinear},
     {"biquadratic", "Biquadratic", IntepolationMethod::Biquadratic},
     {"barycentric", "Barycentric", IntepolationMethod::Barycentric},
-}) {
+    {"bicubic", "Bicubic", IntepolationMethod::Bicubic},
+    {"catmullrom", "Catmull-Rom", IntepolationMethod::CatmullRom},
+    {"bspline", "Cubic B-Spline", IntepolationMethod::BSpline},
+})
+, reductionFilter_("reductionFilter", "Downsampling Filter",
+                   {
+    {"none", "None (Point Sampled)", TNM067::ReductionFilter::None},
+    {"box", "Box", TNM067::ReductionFilter::Box},
+    {"area", "Area", TNM067::ReductionFilter::Area},
+    {"lanczos3", "Lanczos 3", TNM067::ReductionFilter::Lanczos3},
+}, 2)
+, profiling_("profiling", "Profiling") {
     addPort(inport_);
     addPort(outport_);
     addProperty(interpolationMethod_);
+    addProperty(reductionFilter_);
+    addProperty(profiling_);
 }
 
 void ImageUpsampler::process() {
     auto inputImage = inport_.getData();
-    if (inputImage->getDataFormat()->getComponents() != 1) {
-        LogError("The ImageUpsampler processor does only support single channel images");
-    }
     
-    auto inSize = inport_.getData()->getDimensions();
     auto outDim = outport_.getDimensions();
     
-    auto outputImage = std::make_shared<Image>(outDim, inputImage->getDataFormat());
-    outputImage->getColorLayer()->setSwizzleMask(inputImage->getColorLayer()->getSwizzleMask());
+    auto profile = profiling_.begin();
+    outport_.setData(upsample(*inputImage, outDim, interpolationMethod_.get(),
+                              reductionFilter_.get(), profile, &pool_));
+    profiling_.end();
+}
+
+std::shared_ptr<Image> ImageUpsampler::upsample(const Image& inputImage, size2_t outputSize,
+                                                IntepolationMethod method,
+                                                TNM067::ReductionFilter reduction,
+                                                TNM067::Profile* profile,
+                                                TNM067::BufferPool* pool) {
+    TNM067_PROFILE_SCOPE(profile, "Upsample");
+    const size2_t inputSize = inputImage.getDimensions();
+    // Point sampling aliases when reducing, so axes that shrink are prefiltered with the reduction
+    // filter first. Axes that grow are then interpolated with method, as without reduction.
+    const size2_t reducedSize = reduction == TNM067::ReductionFilter::None
+                                    ? inputSize
+                                    : glm::min(inputSize, outputSize);
+    
+    auto outputImage = pool ? pool->image(outputSize, inputImage.getDataFormat())
+                            : std::make_shared<Image>(outputSize, inputImage.getDataFormat());
+    outputImage->getColorLayer()->setSwizzleMask(inputImage.getColorLayer()->getSwizzleMask());
     outputImage->getColorLayer()
     ->getEditableRepresentation<LayerRAM>()
-    ->dispatch<void, dispatching::filter::Scalars>([&](auto outRep) {
-        auto inRep = inputImage->getColorLayer()->getRepresentation<LayerRAM>();
-        detail::upsample(interpolationMethod_.get(), *(const decltype(outRep))(inRep), *outRep);
+    ->dispatch<void, dispatching::filter::All>([&](auto outRep) {
+        using LayerType = std::remove_pointer_t<decltype(outRep)>;
+        auto inRep = static_cast<const LayerType*>(
+            inputImage.getColorLayer()->getRepresentation<LayerRAM>());
+        if (reducedSize == inputSize) {
+            detail::upsample(method, *inRep, *outRep);
+        } else if (reducedSize == outputSize) {
+            TNM067::resample(inRep->getDataTyped(), inputSize, outRep->getDataTyped(), outputSize,
+                             reduction);
+        } else {
+            LayerType reducedRep(reducedSize);
+            TNM067::resample(inRep->getDataTyped(), inputSize, reducedRep.getDataTyped(),
+                             reducedSize, reduction);
+            detail::upsample(method, reducedRep, *outRep);
+        }
     });
+    TNM067_PROFILE_COUNT(profile, PixelsProcessed, outputSize.x * outputSize.y);
     
-    outport_.setData(outputImage);
+    return outputImage;
 }
 
 dvec2 ImageUpsampler::convertCoordinate(ivec2 outImageCoords, size2_t inputSize, size2_t outputSize) {
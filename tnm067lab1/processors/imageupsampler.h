@@ -6,12 +6,23 @@
 #include <inviwo/core/ports/imageport.h>
 #include <modules/tnm067lab1/utils/scalartocolormapping.h>
 #include <inviwo/core/properties/optionproperty.h>
+#include <modules/tnm067lab1/properties/profilingproperty.h>
+#include <modules/tnm067lab1/utils/resampling.h>
+#include <modules/tnm067lab1/utils/bufferpool.h>
 
 namespace inviwo {
 
 class IVW_MODULE_TNM067LAB1_API ImageUpsampler : public Processor {
 public:
-    enum class IntepolationMethod { PiecewiseConstant, Bilinear, Biquadratic, Barycentric };
+    enum class IntepolationMethod {
+        PiecewiseConstant,
+        Bilinear,
+        Biquadratic,
+        Barycentric,
+        Bicubic,
+        CatmullRom,
+        BSpline
+    };
 
     ImageUpsampler();
     virtual ~ImageUpsampler() = default;
@@ -23,12 +34,30 @@ public:
 
     static dvec2 convertCoordinate(ivec2 inputCoordinates, size2_t inputSize, size2_t outputSize);
 
+    /**
+     * Resamples all channels of the color layer of inputImage to outputSize using the given
+     * interpolation method. If reduction is not None, axes along which the output is smaller than
+     * the input are instead resampled with the reduction filter to avoid aliasing, before the
+     * remaining axes are interpolated with the given method.
+     * This is what process() runs, exposed to allow running it outside of a processor network.
+     * The output image is taken from pool if given.
+     */
+    static std::shared_ptr<Image> upsample(const Image& inputImage, size2_t outputSize,
+                                           IntepolationMethod method,
+                                           TNM067::ReductionFilter reduction =
+                                               TNM067::ReductionFilter::None,
+                                           TNM067::Profile* profile = nullptr,
+                                           TNM067::BufferPool* pool = nullptr);
+
 private:
     ImageInport inport_;
     ImageOutport outport_;
 
     // Interpolation method
     TemplateOptionProperty<IntepolationMethod> interpolationMethod_;
+    TemplateOptionProperty<TNM067::ReductionFilter> reductionFilter_;
+    ProfilingProperty profiling_;
+    TNM067::BufferPool pool_;
 };
 
 }  // namespace inviwo
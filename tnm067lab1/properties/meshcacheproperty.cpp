@@ -0,0 +1,35 @@
+#include <modules/tnm067lab1/properties/meshcacheproperty.h>
+
+namespace inviwo {
+
+const std::string MeshCacheProperty::classIdentifier = "org.inviwo.TNM067.MeshCacheProperty";
+std::string MeshCacheProperty::getClassIdentifier() const { return classIdentifier; }
+
+MeshCacheProperty::MeshCacheProperty(std::string identifier, std::string displayName)
+    : CompositeProperty(identifier, displayName)
+    , enabled_("enabled", "Enabled", false)
+    , directory_("directory", "Cache Directory", "") {
+
+    addProperty(enabled_);
+    addProperty(directory_);
+    setCollapsed(true);
+
+    enabled_.onChange([&]() { directory_.setVisible(enabled_); });
+    directory_.setVisible(enabled_);
+}
+
+MeshCacheProperty::MeshCacheProperty(const MeshCacheProperty& rhs)
+    : CompositeProperty(rhs), enabled_(rhs.enabled_), directory_(rhs.directory_) {
+    addProperty(enabled_);
+    addProperty(directory_);
+
+    enabled_.onChange([&]() { directory_.setVisible(enabled_); });
+}
+
+MeshCacheProperty* MeshCacheProperty::clone() const { return new MeshCacheProperty(*this); }
+
+TNM067::MeshCache MeshCacheProperty::getCache() const {
+    return TNM067::MeshCache(enabled_ ? directory_.get() : std::string{});
+}
+
+}  // namespace inviwo
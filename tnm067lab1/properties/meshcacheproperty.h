@@ -0,0 +1,35 @@
+#pragma once
+
+#include <modules/tnm067lab1/tnm067lab1moduledefine.h>
+#include <modules/tnm067lab1/utils/meshcache.h>
+#include <inviwo/core/properties/compositeproperty.h>
+#include <inviwo/core/properties/boolproperty.h>
+#include <inviwo/core/properties/directoryproperty.h>
+
+namespace inviwo {
+
+/**
+ * \class MeshCacheProperty
+ * \brief Enables and configures a TNM067::MeshCache for a processor.
+ */
+class IVW_MODULE_TNM067LAB1_API MeshCacheProperty : public CompositeProperty {
+public:
+    virtual std::string getClassIdentifier() const override;
+    static const std::string classIdentifier;
+
+    MeshCacheProperty(std::string identifier, std::string displayName);
+    MeshCacheProperty(const MeshCacheProperty& rhs);
+    virtual MeshCacheProperty* clone() const override;
+    virtual ~MeshCacheProperty() = default;
+
+    /**
+     * Returns the cache in the selected directory, or a cache that never hits and never stores
+     * anything if caching is disabled.
+     */
+    TNM067::MeshCache getCache() const;
+
+    BoolProperty enabled_;
+    DirectoryProperty directory_;
+};
+
+}  // namespace inviwo
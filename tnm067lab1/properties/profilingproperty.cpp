@@ -0,0 +1,76 @@
+#include <modules/tnm067lab1/properties/profilingproperty.h>
+#include <inviwo/core/util/logcentral.h>
+
+#include <fstream>
+
+namespace inviwo {
+
+const std::string ProfilingProperty::classIdentifier = "org.inviwo.TNM067.ProfilingProperty";
+std::string ProfilingProperty::getClassIdentifier() const { return classIdentifier; }
+
+ProfilingProperty::ProfilingProperty(std::string identifier, std::string displayName)
+    : CompositeProperty(identifier, displayName, InvalidationLevel::Valid)
+    , summary_("summary", "Summary",
+               TNM067_ENABLE_INSTRUMENTATION ? ""
+                                             : "Disabled, set TNM067_ENABLE_INSTRUMENTATION to 1")
+    , traceFile_("traceFile", "Chrome Trace File", "") {
+
+    summary_.setReadOnly(true);
+    summary_.setSerializationMode(PropertySerializationMode::None);
+    traceFile_.setAcceptMode(AcceptMode::Save);
+    traceFile_.setVisible(TNM067_ENABLE_INSTRUMENTATION != 0);
+
+    addProperty(summary_);
+    addProperty(traceFile_);
+    setCollapsed(true);
+}
+
+ProfilingProperty::ProfilingProperty(const ProfilingProperty& rhs)
+    : CompositeProperty(rhs), summary_(rhs.summary_), traceFile_(rhs.traceFile_), profile_() {
+    addProperty(summary_);
+    addProperty(traceFile_);
+}
+
+ProfilingProperty* ProfilingProperty::clone() const { return new ProfilingProperty(*this); }
+
+TNM067::Profile* ProfilingProperty::begin() {
+#if TNM067_ENABLE_INSTRUMENTATION
+    profile_.begin();
+    return &profile_;
+#else
+    return nullptr;
+#endif
+}
+
+void ProfilingProperty::end() {
+#if TNM067_ENABLE_INSTRUMENTATION
+    profile_.end();
+    report(profile_);
+#endif
+}
+
+std::shared_ptr<TNM067::Profile> ProfilingProperty::beginJob() {
+#if TNM067_ENABLE_INSTRUMENTATION
+    auto profile = std::make_shared<TNM067::Profile>();
+    profile->begin();
+    return profile;
+#else
+    return nullptr;
+#endif
+}
+
+void ProfilingProperty::report(const TNM067::Profile& profile) {
+    summary_.set(profile.summary());
+
+    const std::string& file = traceFile_.get();
+    if (!file.empty()) {
+        std::ofstream out(file);
+        if (out) {
+            out << profile.chromeTrace();
+        } else {
+            LogWarnCustom("ProfilingProperty", "Could not write Chrome trace to " << file);
+        }
+    }
+}
+
+}  // namespace inviwo
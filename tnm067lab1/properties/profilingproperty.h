@@ -0,0 +1,52 @@
+#pragma once
+
+#include <modules/tnm067lab1/tnm067lab1moduledefine.h>
+#include <modules/tnm067lab1/utils/instrumentation.h>
+#include <inviwo/core/properties/compositeproperty.h>
+#include <inviwo/core/properties/stringproperty.h>
+#include <inviwo/core/properties/fileproperty.h>
+
+#include <memory>
+
+namespace inviwo {
+
+/**
+ * \class ProfilingProperty
+ * \brief Owns the TNM067::Profile of a processor and shows its summary.
+ * Call begin() at the start of process() and pass the returned pointer to the instrumented code,
+ * then call end() to update the summary and, if a trace file is set, write a Chrome trace. When
+ * TNM067_ENABLE_INSTRUMENTATION is zero begin() returns nullptr and nothing is recorded.
+ *
+ * Work running in a background job uses a profile of its own from beginJob(), since the job may
+ * still be recording when the next one starts. The job ends that profile itself and the processor
+ * passes it to report() once the job's result is back on the main thread.
+ */
+class IVW_MODULE_TNM067LAB1_API ProfilingProperty : public CompositeProperty {
+public:
+    virtual std::string getClassIdentifier() const override;
+    static const std::string classIdentifier;
+
+    ProfilingProperty(std::string identifier, std::string displayName);
+    ProfilingProperty(const ProfilingProperty& rhs);
+    virtual ProfilingProperty* clone() const override;
+    virtual ~ProfilingProperty() = default;
+
+    TNM067::Profile* begin();
+    void end();
+
+    /**
+     * Returns a new profile that has begun, or nullptr if instrumentation is disabled. Can be
+     * called from any thread, call it at the start of the job.
+     */
+    static std::shared_ptr<TNM067::Profile> beginJob();
+    /// Shows the summary of a profile that has ended and writes its trace file if set
+    void report(const TNM067::Profile& profile);
+
+    StringProperty summary_;
+    FileProperty traceFile_;
+
+private:
+    TNM067::Profile profile_;
+};
+
+}  // namespace inviwo
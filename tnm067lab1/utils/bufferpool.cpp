@@ -0,0 +1,23 @@
+#include <modules/tnm067lab1/utils/bufferpool.h>
+
+namespace inviwo {
+
+namespace TNM067 {
+
+std::shared_ptr<Image> BufferPool::image(size2_t dims, const DataFormatBase* format) {
+    auto& image = images_.items[nextFree(images_)];
+    if (!image || image->getDimensions() != dims || image->getDataFormat() != format) {
+        image = std::make_shared<Image>(dims, format);
+    }
+    return image;
+}
+
+void BufferPool::clear() {
+    scratch_.clear();
+    images_ = {};
+    meshes_.clear();
+}
+
+}  // namespace TNM067
+
+}  // namespace inviwo
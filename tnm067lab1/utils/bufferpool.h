@@ -0,0 +1,137 @@
+#pragma once
+
+#include <modules/tnm067lab1/tnm067lab1moduledefine.h>
+#include <inviwo/core/datastructures/image/image.h>
+#include <inviwo/core/datastructures/geometry/mesh.h>
+#include <inviwo/core/datastructures/buffer/bufferram.h>
+
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <typeindex>
+#include <unordered_map>
+
+namespace inviwo {
+
+namespace TNM067 {
+
+/**
+ * \class BufferPool
+ * \brief Keeps the temporaries and outputs of a processor between evaluations.
+ * Scratch objects such as vectors are kept as they are, so clearing and refilling them reuses
+ * their memory. Images and meshes are kept two per type and used in turns, since the outport and
+ * the processors after it still hold the previous result while the next one is computed. An
+ * output is only handed out again once nothing outside the pool refers to it.
+ *
+ * Every processor should have its own pool, a pool is not thread safe. Jobs that may overlap,
+ * such as a background job and the stale job it replaces, take turns by holding lock().
+ */
+class IVW_MODULE_TNM067LAB1_API BufferPool {
+public:
+    BufferPool() = default;
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /**
+     * Returns the scratch object of type T, default constructed on first use. The object keeps
+     * its contents, callers should clear it before use.
+     */
+    template <typename T>
+    T& scratch() {
+        auto& object = scratch_[std::type_index(typeid(T))];
+        if (!object) object = std::make_shared<T>();
+        return *static_cast<T*>(object.get());
+    }
+
+    /**
+     * Returns an image of size dims and format to write a result to. The contents are undefined.
+     * Reuses one of the earlier images if it is free and has the same size and format.
+     */
+    std::shared_ptr<Image> image(size2_t dims, const DataFormatBase* format);
+
+    /**
+     * Returns a mesh of type M to write a result to. A reused mesh keeps its vertex and index
+     * buffers, with the same meaning as before, but they are emptied while keeping their memory.
+     */
+    template <typename M>
+    std::shared_ptr<M> mesh() {
+        return pooledMesh<M>({std::type_index(typeid(M)), DrawType::NotSpecified,
+                              ConnectivityType::None});
+    }
+
+    /**
+     * Same as mesh() for meshes with one index buffer of draw type dt and connectivity ct, which
+     * new meshes are given. Meshes with different index buffers are kept apart, so a processor
+     * can switch between them without dropping its pooled meshes.
+     */
+    template <typename M>
+    std::shared_ptr<M> mesh(DrawType dt, ConnectivityType ct) {
+        return pooledMesh<M>({std::type_index(typeid(M)), dt, ct});
+    }
+
+    /// Releases everything held by the pool
+    void clear();
+
+    /// Holds the pool until the returned lock is destroyed
+    std::unique_lock<std::mutex> lock() { return std::unique_lock<std::mutex>{mutex_}; }
+
+private:
+    /// Mesh type and the index buffer of new meshes, NotSpecified for none
+    using MeshKey = std::tuple<std::type_index, DrawType, ConnectivityType>;
+
+    template <typename M>
+    std::shared_ptr<M> pooledMesh(const MeshKey& key) {
+        auto& slots = meshes_[key];
+        auto& mesh = slots.items[nextFree(slots)];
+        if (!mesh) {
+            mesh = std::make_shared<M>();
+            if (std::get<1>(key) != DrawType::NotSpecified) {
+                mesh->addIndexBuffer(std::get<1>(key), std::get<2>(key));
+            }
+        } else {
+            for (auto& buffer : mesh->getBuffers()) {
+                buffer.second->getEditableRepresentation<BufferRAM>()->setSize(0);
+            }
+            for (auto& indices : mesh->getIndexBuffers()) {
+                indices.second->getEditableRepresentation<BufferRAM>()->setSize(0);
+            }
+        }
+        return std::static_pointer_cast<M>(mesh);
+    }
+
+    template <typename T>
+    struct Slots {
+        std::array<std::shared_ptr<T>, 2> items;
+        size_t next = 0;
+    };
+
+    /**
+     * Index of a slot that is empty or that nothing outside the pool refers to. If all are in use
+     * the oldest one is emptied, leaving its contents to whoever still refers to it.
+     */
+    template <typename T>
+    static size_t nextFree(Slots<T>& slots) {
+        for (size_t i = 0; i < slots.items.size(); ++i) {
+            const size_t slot = (slots.next + i) % slots.items.size();
+            if (!slots.items[slot] || slots.items[slot].use_count() == 1) {
+                slots.next = (slot + 1) % slots.items.size();
+                return slot;
+            }
+        }
+        const size_t slot = slots.next;
+        slots.items[slot].reset();
+        slots.next = (slot + 1) % slots.items.size();
+        return slot;
+    }
+
+    std::unordered_map<std::type_index, std::shared_ptr<void>> scratch_;
+    Slots<Image> images_;
+    std::map<MeshKey, Slots<Mesh>> meshes_;
+    std::mutex mutex_;
+};
+
+}  // namespace TNM067
+
+}  // namespace inviwo
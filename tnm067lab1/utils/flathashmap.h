@@ -0,0 +1,102 @@
+#pragma once
+
+#include <modules/tnm067lab1/tnm067lab1moduledefine.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace inviwo {
+
+namespace TNM067 {
+
+/**
+ * \class FlatHashMap
+ * \brief Open addressing hash map with linear probing in a single array.
+ * Unlike std::unordered_map, inserting does not allocate a node per element and clear() keeps
+ * the slots, so a map that is cleared and refilled with a similar number of elements does not
+ * allocate at all. Keys and values must be default constructible. Elements can not be erased.
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class FlatHashMap {
+public:
+    FlatHashMap() = default;
+
+    /**
+     * Inserts value for key unless key is already in the map. Returns the value stored for key
+     * and true if it was inserted. The reference is invalidated by the next insertion.
+     */
+    std::pair<Value&, bool> tryEmplace(const Key& key, const Value& value) {
+        if (2 * (size_ + 1) > slots_.size()) grow();
+        const size_t slot = find(key);
+        if (used_[slot]) return {slots_[slot].second, false};
+        used_[slot] = 1;
+        slots_[slot] = {key, value};
+        ++size_;
+        return {slots_[slot].second, true};
+    }
+
+    /// Returns the value stored for key or nullptr
+    const Value* get(const Key& key) const {
+        if (size_ == 0) return nullptr;
+        const size_t slot = find(key);
+        return used_[slot] ? &slots_[slot].second : nullptr;
+    }
+
+    /// Makes room for count elements without growing
+    void reserve(size_t count) {
+        while (2 * count > slots_.size()) grow();
+    }
+
+    /// Removes all elements but keeps the slots
+    void clear() {
+        std::fill(used_.begin(), used_.end(), std::uint8_t{0});
+        size_ = 0;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+private:
+    /// Slot of key or the empty slot where it would be inserted
+    size_t find(const Key& key) const {
+        // Fibonacci hashing spreads hashes that are only unique in their low bits, such as the
+        // identity hash of integers, over the whole table
+        const std::uint64_t h = static_cast<std::uint64_t>(Hash{}(key)) * 0x9e3779b97f4a7c15ULL;
+        const size_t mask = slots_.size() - 1;
+        size_t slot = static_cast<size_t>(h >> shift_);
+        while (used_[slot] && !(slots_[slot].first == key)) slot = (slot + 1) & mask;
+        return slot;
+    }
+
+    void grow() {
+        std::vector<std::pair<Key, Value>> slots;
+        std::vector<std::uint8_t> used;
+        slots.swap(slots_);
+        used.swap(used_);
+
+        const size_t capacity = std::max<size_t>(16, 2 * slots.size());
+        slots_.resize(capacity);
+        used_.assign(capacity, 0);
+        shift_ = 64;
+        for (size_t c = capacity; c > 1; c >>= 1) --shift_;
+
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (!used[i]) continue;
+            const size_t slot = find(slots[i].first);
+            used_[slot] = 1;
+            slots_[slot] = std::move(slots[i]);
+        }
+    }
+
+    std::vector<std::pair<Key, Value>> slots_;
+    std::vector<std::uint8_t> used_;
+    size_t size_ = 0;
+    unsigned shift_ = 64;
+};
+
+}  // namespace TNM067
+
+}  // namespace inviwo
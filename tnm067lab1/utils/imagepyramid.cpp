@@ -0,0 +1,116 @@
+#include <modules/tnm067lab1/utils/imagepyramid.h>
+#include <modules/tnm067lab1/utils/parallelutils.h>
+#include <inviwo/core/datastructures/image/layerram.h>
+#include <inviwo/core/datastructures/image/layerramprecision.h>
+
+#include <numeric>
+
+namespace inviwo {
+
+namespace TNM067 {
+
+namespace {
+
+// Number of levels computed per pass over the tiles, tiles are 2^maxFusedLevels pixels wide
+constexpr size_t maxFusedLevels = 7;
+
+size2_t halfSize(size2_t dims) { return glm::max((dims + size2_t(1)) / size2_t(2), size2_t(1)); }
+
+template <typename T>
+T* typedData(Image& image) {
+    return static_cast<LayerRAMPrecision<T>*>(
+               image.getColorLayer()->getEditableRepresentation<LayerRAM>())
+        ->getDataTyped();
+}
+
+/**
+ * Computes levels first + 1 ... first + count of the pyramid from level first. The pixels of level
+ * first are split into square tiles of 2^count pixels, the levels below a tile only depend on the
+ * tile itself since reads outside of a level are clamped to its last row/column which then lies in
+ * the same tile.
+ */
+template <typename T>
+void averageLevels(std::vector<T*>& data, const std::vector<size2_t>& dims, size_t first,
+                   size_t count) {
+    using FT = resample_float_t<T>;
+    using F = typename util::value_type<FT>::type;
+
+    const size_t tileSize = size_t{1} << count;
+    const size2_t tiles = (dims[first] + size2_t(tileSize - 1)) / size2_t(tileSize);
+
+    forEachRangeParallel(tiles.x * tiles.y, [&](size_t begin, size_t end, size_t) {
+        for (size_t tile = begin; tile < end; ++tile) {
+            const size2_t tilePos{tile % tiles.x, tile / tiles.x};
+            for (size_t level = first + 1; level <= first + count; ++level) {
+                const size_t size = tileSize >> (level - first);
+                const size2_t inDims = dims[level - 1];
+                const size2_t outDims = dims[level];
+                const size2_t from = tilePos * size;
+                const size2_t to = glm::min(from + size2_t(size), outDims);
+
+                const T* in = data[level - 1];
+                T* out = data[level];
+                for (size_t y = from.y; y < to.y; ++y) {
+                    const size_t y0 = 2 * y;
+                    const size_t y1 = std::min(y0 + 1, inDims.y - 1);
+                    for (size_t x = from.x; x < to.x; ++x) {
+                        const size_t x0 = 2 * x;
+                        const size_t x1 = std::min(x0 + 1, inDims.x - 1);
+                        const FT sum = static_cast<FT>(in[x0 + y0 * inDims.x]) +
+                                       static_cast<FT>(in[x1 + y0 * inDims.x]) +
+                                       static_cast<FT>(in[x0 + y1 * inDims.x]) +
+                                       static_cast<FT>(in[x1 + y1 * inDims.x]);
+                        out[x + y * outDims.x] = toPixel<T>(sum * F(0.25));
+                    }
+                }
+            }
+        }
+    });
+}
+
+}  // namespace
+
+std::vector<std::shared_ptr<Image>> buildImagePyramid(const Image& base, size_t levels,
+                                                      ReductionFilter filter, Profile* profile) {
+    TNM067_PROFILE_SCOPE(profile, "Image pyramid");
+    const auto format = base.getDataFormat();
+    const auto swizzleMask = base.getColorLayer()->getSwizzleMask();
+
+    std::vector<std::shared_ptr<Image>> pyramid{std::shared_ptr<Image>(base.clone())};
+    std::vector<size2_t> dims{base.getDimensions()};
+    while (dims.size() < levels && dims.back() != size2_t(1)) {
+        dims.push_back(halfSize(dims.back()));
+        auto image = std::make_shared<Image>(dims.back(), format);
+        image->getColorLayer()->setSwizzleMask(swizzleMask);
+        pyramid.push_back(image);
+    }
+
+    pyramid.front()->getColorLayer()->getEditableRepresentation<LayerRAM>()->dispatch<
+        void, dispatching::filter::All>([&](auto baseRep) {
+        using T = typename std::remove_pointer_t<decltype(baseRep)>::type;
+
+        std::vector<T*> data;
+        for (auto& image : pyramid) data.push_back(typedData<T>(*image));
+
+        if (filter == ReductionFilter::Lanczos3) {
+            for (size_t level = 1; level < pyramid.size(); ++level) {
+                resample(data[level - 1], dims[level - 1], data[level], dims[level], filter);
+            }
+        } else {
+            for (size_t level = 0; level + 1 < pyramid.size(); level += maxFusedLevels) {
+                const size_t count = std::min(maxFusedLevels, pyramid.size() - 1 - level);
+                averageLevels(data, dims, level, count);
+            }
+        }
+    });
+
+    TNM067_PROFILE_COUNT(profile, PixelsProcessed,
+                         std::accumulate(dims.begin() + 1, dims.end(), size_t{0},
+                                         [](size_t sum, size2_t d) { return sum + d.x * d.y; }));
+
+    return pyramid;
+}
+
+}  // namespace TNM067
+
+}  // namespace inviwo
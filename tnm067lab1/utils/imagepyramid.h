@@ -0,0 +1,29 @@
+#pragma once
+
+#include <modules/tnm067lab1/tnm067lab1moduledefine.h>
+#include <modules/tnm067lab1/utils/instrumentation.h>
+#include <modules/tnm067lab1/utils/resampling.h>
+#include <inviwo/core/datastructures/image/image.h>
+
+#include <memory>
+#include <vector>
+
+namespace inviwo {
+
+namespace TNM067 {
+
+/**
+ * Builds an image pyramid of the color layer of base. Level i + 1 has half the size of level i,
+ * rounded up, and is computed from level i. The returned vector starts with a copy of base and has
+ * at most levels entries, it stops early when a level of size 1x1 is reached.
+ *
+ * Box and Area (and None) use a 2x2 average. Up to seven levels are then computed in one pass over
+ * tiles of the image, each tile produces all of its levels while the data is still in cache and the
+ * tiles are processed in parallel. Lanczos3 resamples each level from the previous one separably.
+ */
+IVW_MODULE_TNM067LAB1_API std::vector<std::shared_ptr<Image>> buildImagePyramid(
+    const Image& base, size_t levels, ReductionFilter filter, Profile* profile = nullptr);
+
+}  // namespace TNM067
+
+}  // namespace inviwo
@@ -0,0 +1,163 @@
+#include <modules/tnm067lab1/utils/imagestatistics.h>
+#include <modules/tnm067lab1/utils/parallelutils.h>
+#include <inviwo/core/datastructures/image/layerramprecision.h>
+#include <inviwo/core/util/formatdispatching.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace inviwo {
+
+namespace TNM067 {
+
+namespace {
+
+/**
+ * Flips the sign bit of positive floats and all bits of negative floats, which makes the bit
+ * patterns sort like the values
+ */
+std::uint32_t orderedKey(float value) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+float fromOrderedKey(std::uint32_t key) {
+    const std::uint32_t bits = (key & 0x80000000u) ? (key & 0x7fffffffu) : ~key;
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+struct Partial {
+    std::vector<std::uint32_t> histogram;
+    double min = std::numeric_limits<double>::max();
+    double max = std::numeric_limits<double>::lowest();
+};
+
+}  // namespace
+
+ImageStatistics ImageStatistics::compute(const LayerRAM& layer, Profile* profile) {
+    TNM067_PROFILE_SCOPE(profile, "Image statistics");
+    ImageStatistics stats;
+    const size2_t dims = layer.getDimensions();
+
+    // One histogram per thread rather than per job, they are large
+    const size_t jobs =
+        std::max<size_t>(1, InviwoApplication::getPtr()->getThreadPool().getSize());
+    std::vector<Partial> partials(jobs);
+
+    layer.dispatch<void>([&](const auto rep) {
+        using T = typename util::value_type<util::PrecisionValueType<decltype(rep)>>::type;
+        constexpr bool integer = std::is_integral<T>::value && sizeof(T) <= 2;
+        stats.integer_ = integer;
+        stats.lowest_ = integer ? static_cast<double>(std::numeric_limits<T>::lowest()) : 0.0;
+
+        const auto data = rep->getDataTyped();
+        forEachRangeParallel(
+            dims.y,
+            [&](size_t begin, size_t end, size_t job) {
+                auto& partial = partials[job];
+                partial.histogram.assign(binCount, 0);
+                for (size_t i = begin * dims.x; i < end * dims.x; ++i) {
+                    const T value = util::glmcomp(data[i], 0);
+                    if constexpr (integer) {
+                        // The range follows from the first and last used bins
+                        ++partial.histogram[static_cast<size_t>(
+                            static_cast<std::int32_t>(value) -
+                            static_cast<std::int32_t>(std::numeric_limits<T>::lowest()))];
+                    } else {
+                        const double v = static_cast<double>(value);
+                        if (std::isnan(v)) continue;
+                        ++partial.histogram[orderedKey(static_cast<float>(v)) >> 16];
+                        partial.min = std::min(partial.min, v);
+                        partial.max = std::max(partial.max, v);
+                    }
+                }
+            },
+            jobs);
+    });
+
+    std::vector<std::uint64_t> histogram(binCount, 0);
+    dvec2 range(std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest());
+    for (const auto& partial : partials) {
+        if (partial.histogram.empty()) continue;
+        for (size_t b = 0; b < binCount; ++b) histogram[b] += partial.histogram[b];
+        range.x = std::min(range.x, partial.min);
+        range.y = std::max(range.y, partial.max);
+    }
+
+    stats.cumulative_.resize(binCount + 1);
+    stats.cumulative_[0] = 0;
+    for (size_t b = 0; b < binCount; ++b) {
+        stats.cumulative_[b + 1] = stats.cumulative_[b] + histogram[b];
+    }
+
+    if (stats.getCount() == 0) {
+        stats.range_ = dvec2(0.0);
+    } else if (stats.integer_) {
+        const auto used = [](std::uint64_t count) { return count > 0; };
+        const auto first = std::find_if(histogram.begin(), histogram.end(), used);
+        const auto last = std::find_if(histogram.rbegin(), histogram.rend(), used);
+        stats.range_ = dvec2(stats.lowest_ + (first - histogram.begin()),
+                             stats.lowest_ + (histogram.rend() - last - 1));
+    } else {
+        stats.range_ = range;
+    }
+    return stats;
+}
+
+double ImageStatistics::percentile(double p) const {
+    const auto count = getCount();
+    if (count == 0) return 0.0;
+    if (p <= 0.0) return range_.x;
+    if (p >= 1.0) return range_.y;
+
+    // The first bin reaching the target, it is never empty
+    const double target = p * static_cast<double>(count);
+    const auto it = std::lower_bound(cumulative_.begin() + 1, cumulative_.end(), target,
+                                     [](std::uint64_t c, double t) { return c < t; });
+    const size_t b = static_cast<size_t>(it - cumulative_.begin()) - 1;
+    if (integer_) return lowest_ + static_cast<double>(b);
+
+    const double inBin = static_cast<double>(cumulative_[b + 1] - cumulative_[b]);
+    const dvec2 r = binRange(b);
+    return glm::mix(r.x, r.y, (target - static_cast<double>(cumulative_[b])) / inBin);
+}
+
+double ImageStatistics::cdf(double value) const {
+    const auto count = getCount();
+    if (count == 0 || value < range_.x) return 0.0;
+    if (value > range_.y) return 1.0;
+
+    const size_t b = bin(value);
+    const double inBin = static_cast<double>(cumulative_[b + 1] - cumulative_[b]);
+    double t = 0.5;
+    if (!integer_) {
+        const dvec2 r = binRange(b);
+        if (r.y > r.x) t = glm::clamp((value - r.x) / (r.y - r.x), 0.0, 1.0);
+    }
+    return (static_cast<double>(cumulative_[b]) + t * inBin) / static_cast<double>(count);
+}
+
+size_t ImageStatistics::bin(double value) const {
+    if (integer_) {
+        const double b = std::round(value - lowest_);
+        return static_cast<size_t>(glm::clamp(b, 0.0, static_cast<double>(binCount - 1)));
+    }
+    return orderedKey(static_cast<float>(value)) >> 16;
+}
+
+dvec2 ImageStatistics::binRange(size_t bin) const {
+    const auto key = static_cast<std::uint32_t>(bin) << 16;
+    // The last bins hold infinity and NaN, min before max keeps those inside the range
+    const auto clip = [&](double v) { return std::max(range_.x, std::min(range_.y, v)); };
+    return {clip(fromOrderedKey(key)), clip(fromOrderedKey(key | 0xffffu))};
+}
+
+}  // namespace TNM067
+
+}  // namespace inviwo
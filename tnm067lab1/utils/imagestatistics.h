@@ -0,0 +1,58 @@
+#pragma once
+
+#include <modules/tnm067lab1/tnm067lab1moduledefine.h>
+#include <modules/tnm067lab1/utils/instrumentation.h>
+#include <inviwo/core/datastructures/image/layerram.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace inviwo {
+
+namespace TNM067 {
+
+/**
+ * \class ImageStatistics
+ * \brief Value range, percentiles and histogram of the first channel of a layer.
+ * Everything is gathered in a single parallel pass. Each thread fills its own histogram, and the
+ * histograms are merged at the end. The histogram does not need the value range in advance since
+ * its bins are fixed:
+ *   - 8 and 16 bit integers get one bin per value, so the percentiles are exact.
+ *   - Other types bin the top 16 bits of an order-preserving key of the value as a float, which is
+ *     about 2^-7 relative precision. Within a bin the values are assumed to be evenly spread.
+ * NaN values are ignored.
+ */
+class IVW_MODULE_TNM067LAB1_API ImageStatistics {
+public:
+    static constexpr size_t binCount = 65536;
+
+    static ImageStatistics compute(const LayerRAM& layer, Profile* profile = nullptr);
+
+    /// Smallest and largest value, exact
+    dvec2 getRange() const { return range_; }
+    /// Number of values in the histogram
+    std::uint64_t getCount() const { return cumulative_.back(); }
+    /// True if every histogram bin holds a single integer value
+    bool isInteger() const { return integer_; }
+
+    /// Value below which the fraction p of the values lie, p in [0, 1]
+    double percentile(double p) const;
+    /// Fraction of the values below value, counting values equal to it as half
+    double cdf(double value) const;
+
+private:
+    ImageStatistics() = default;
+
+    size_t bin(double value) const;
+    /// Range of values of a bin clipped to the value range, only used if not integer
+    dvec2 binRange(size_t bin) const;
+
+    dvec2 range_{0.0};
+    bool integer_ = false;
+    double lowest_ = 0.0;  //!< Value of the first bin if integer
+    std::vector<std::uint64_t> cumulative_;  //!< Count of values in the bins before each bin
+};
+
+}  // namespace TNM067
+
+}  // namespace inviwo
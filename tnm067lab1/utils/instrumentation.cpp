@@ -0,0 +1,182 @@
+#include <modules/tnm067lab1/utils/instrumentation.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+namespace inviwo {
+
+namespace TNM067 {
+
+namespace {
+std::atomic<std::uint64_t> nextSession{1};
+
+double toMicroseconds(Profile::Clock::duration d) {
+    return std::chrono::duration<double, std::micro>(d).count();
+}
+}  // namespace
+
+const char* counterName(Counter counter) {
+    switch (counter) {
+        case Counter::CellsVisited:
+            return "Cells visited";
+        case Counter::ActiveTetrahedra:
+            return "Active tetrahedra";
+        case Counter::ActiveCells:
+            return "Active cells";
+        case Counter::VerticesDeduplicated:
+            return "Vertices deduplicated";
+        case Counter::HashLookups:
+            return "Hash lookups";
+        case Counter::PixelsProcessed:
+            return "Pixels processed";
+        case Counter::VoxelsProcessed:
+            return "Voxels processed";
+        case Counter::OctreeLeaves:
+            return "Octree leaves";
+        case Counter::RaySamples:
+            return "Ray samples";
+        case Counter::MacrocellsSkipped:
+            return "Macrocells skipped";
+        case Counter::SeedsTested:
+            return "Seeds tested";
+        case Counter::StreamlinesPlaced:
+            return "Streamlines placed";
+        default:
+            return "Unknown";
+    }
+}
+
+void Profile::begin() {
+    std::scoped_lock lock{mutex_};
+    threads_.clear();
+    session_ = nextSession++;
+    begin_ = end_ = Clock::now();
+}
+
+void Profile::end() {
+    std::scoped_lock lock{mutex_};
+    end_ = Clock::now();
+}
+
+Profile::ThreadData& Profile::threadData() {
+    struct Entry {
+        std::uint64_t session;
+        ThreadData* data;
+    };
+    // Sessions are globally unique, so entries of old sessions or destroyed profiles never match
+    thread_local std::vector<Entry> entries;
+
+    const auto session = session_.load(std::memory_order_relaxed);
+    for (const auto& entry : entries) {
+        if (entry.session == session) return *entry.data;
+    }
+
+    std::scoped_lock lock{mutex_};
+    threads_.push_back(std::make_unique<ThreadData>());
+    threads_.back()->id = threads_.size() - 1;
+    if (entries.size() >= 16) entries.erase(entries.begin());
+    entries.push_back({session, threads_.back().get()});
+    return *threads_.back();
+}
+
+void Profile::accumulate(std::vector<Stage>& stages, const char* name, Clock::duration duration,
+                         std::uint64_t calls) {
+    auto it = std::find_if(stages.begin(), stages.end(),
+                           [&](const Stage& s) { return std::strcmp(s.name, name) == 0; });
+    if (it == stages.end()) {
+        stages.push_back({name, duration, calls});
+    } else {
+        it->total += duration;
+        it->calls += calls;
+    }
+}
+
+void Profile::addEvent(const char* name, Clock::time_point start, Clock::time_point stop) {
+    auto& data = threadData();
+    data.events.push_back({name, start, stop});
+    accumulate(data.stages, name, stop - start, 1);
+}
+
+void Profile::addStageTime(const char* name, Clock::duration duration) {
+    accumulate(threadData().stages, name, duration, 1);
+}
+
+void Profile::addCount(Counter counter, std::uint64_t count) {
+    threadData().counters[static_cast<size_t>(counter)] += count;
+}
+
+std::vector<Profile::Stage> Profile::mergedStages() const {
+    std::vector<Stage> stages;
+    for (const auto& thread : threads_) {
+        for (const auto& stage : thread->stages) {
+            accumulate(stages, stage.name, stage.total, stage.calls);
+        }
+    }
+    return stages;
+}
+
+std::array<std::uint64_t, static_cast<size_t>(Counter::NumberOfCounters)>
+Profile::mergedCounters() const {
+    std::array<std::uint64_t, static_cast<size_t>(Counter::NumberOfCounters)> counters{};
+    for (const auto& thread : threads_) {
+        for (size_t i = 0; i < counters.size(); ++i) {
+            counters[i] += thread->counters[i];
+        }
+    }
+    return counters;
+}
+
+std::string Profile::summary() const {
+    std::scoped_lock lock{mutex_};
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(3);
+    ss << "Total: " << toMicroseconds(end_ - begin_) / 1000.0 << " ms on " << threads_.size()
+       << " thread(s)\n";
+    for (const auto& stage : mergedStages()) {
+        ss << stage.name << ": " << toMicroseconds(stage.total) / 1000.0 << " ms (" << stage.calls
+           << " calls, summed over threads)\n";
+    }
+    const auto counters = mergedCounters();
+    for (size_t i = 0; i < counters.size(); ++i) {
+        if (counters[i] == 0) continue;
+        ss << counterName(static_cast<Counter>(i)) << ": " << counters[i] << "\n";
+    }
+    return ss.str();
+}
+
+std::string Profile::chromeTrace() const {
+    std::scoped_lock lock{mutex_};
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(3);
+    ss << "{\"traceEvents\":[";
+    bool first = true;
+    auto separator = [&]() {
+        if (!first) ss << ",";
+        first = false;
+        ss << "\n";
+    };
+    for (const auto& thread : threads_) {
+        for (const auto& event : thread->events) {
+            separator();
+            ss << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->id
+               << ",\"ts\":" << toMicroseconds(event.start - begin_)
+               << ",\"dur\":" << toMicroseconds(event.stop - event.start) << "}";
+        }
+    }
+    const auto counters = mergedCounters();
+    for (size_t i = 0; i < counters.size(); ++i) {
+        if (counters[i] == 0) continue;
+        separator();
+        ss << "{\"name\":\"" << counterName(static_cast<Counter>(i))
+           << "\",\"ph\":\"C\",\"pid\":1,\"tid\":0,\"ts\":" << toMicroseconds(end_ - begin_)
+           << ",\"args\":{\"value\":" << counters[i] << "}}";
+    }
+    ss << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return ss.str();
+}
+
+}  // namespace TNM067
+
+}  // namespace inviwo
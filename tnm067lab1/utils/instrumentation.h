@@ -0,0 +1,186 @@
+#pragma once
+
+#include <modules/tnm067lab1/tnm067lab1moduledefine.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Change this to one to enable the timers and counters of the TNM067 processors. When zero all
+// TNM067_PROFILE_* macros expand to nothing. The macros take a Profile pointer which may be null.
+#ifndef TNM067_ENABLE_INSTRUMENTATION
+#define TNM067_ENABLE_INSTRUMENTATION 0
+#endif
+
+namespace inviwo {
+
+namespace TNM067 {
+
+enum class Counter {
+    CellsVisited,
+    ActiveTetrahedra,
+    ActiveCells,
+    VerticesDeduplicated,
+    HashLookups,
+    PixelsProcessed,
+    VoxelsProcessed,
+    OctreeLeaves,
+    RaySamples,
+    MacrocellsSkipped,
+    SeedsTested,
+    StreamlinesPlaced,
+    NumberOfCounters
+};
+
+/**
+ * \class Profile
+ * \brief Collects timings and counters of one processor evaluation.
+ * Every thread writes to its own buffer which is only merged when a summary or trace is requested,
+ * so recording does not need any synchronization after a thread's first access in a session.
+ */
+class IVW_MODULE_TNM067LAB1_API Profile {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Profile() = default;
+    Profile(const Profile&) = delete;
+    Profile& operator=(const Profile&) = delete;
+
+    /**
+     * Starts a new session, discarding everything recorded before.
+     */
+    void begin();
+    /**
+     * Ends the current session, the summary and trace are based on the time between begin and end.
+     */
+    void end();
+
+    /**
+     * Records a timed event that is shown in the trace and accumulated in the summary.
+     */
+    void addEvent(const char* name, Clock::time_point start, Clock::time_point stop);
+    /**
+     * Accumulates time to a stage without adding an event to the trace. Use this for stages that
+     * are entered too often to be shown individually.
+     */
+    void addStageTime(const char* name, Clock::duration duration);
+    void addCount(Counter counter, std::uint64_t count);
+
+    std::string summary() const;
+    /**
+     * Returns the recorded events and counters in Chrome trace event JSON format, which can be
+     * opened in chrome://tracing or https://ui.perfetto.dev.
+     */
+    std::string chromeTrace() const;
+
+private:
+    struct Event {
+        const char* name;
+        Clock::time_point start;
+        Clock::time_point stop;
+    };
+    struct Stage {
+        const char* name;
+        Clock::duration total;
+        std::uint64_t calls;
+    };
+    struct ThreadData {
+        size_t id;
+        std::vector<Event> events;
+        std::vector<Stage> stages;
+        std::array<std::uint64_t, static_cast<size_t>(Counter::NumberOfCounters)> counters{};
+    };
+
+    ThreadData& threadData();
+    std::vector<Stage> mergedStages() const;
+    std::array<std::uint64_t, static_cast<size_t>(Counter::NumberOfCounters)> mergedCounters() const;
+
+    static void accumulate(std::vector<Stage>& stages, const char* name, Clock::duration duration,
+                           std::uint64_t calls);
+
+    std::atomic<std::uint64_t> session_{0};
+    Clock::time_point begin_{};
+    Clock::time_point end_{};
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<ThreadData>> threads_;
+};
+
+IVW_MODULE_TNM067LAB1_API const char* counterName(Counter counter);
+
+/**
+ * Adds an event to the profile covering the lifetime of the timer. Does nothing if profile is null.
+ */
+class ScopedTimer {
+public:
+    ScopedTimer(Profile* profile, const char* name)
+        : profile_(profile)
+        , name_(name)
+        , start_(profile ? Profile::Clock::now() : Profile::Clock::time_point{}) {}
+    ~ScopedTimer() {
+        if (profile_) profile_->addEvent(name_, start_, Profile::Clock::now());
+    }
+
+private:
+    Profile* profile_;
+    const char* name_;
+    Profile::Clock::time_point start_;
+};
+
+/**
+ * Accumulates the time spent between start() and stop() locally and adds it to the profile as a
+ * stage when destroyed. Use this inside hot loops instead of ScopedTimer. Does nothing if profile
+ * is null.
+ */
+class StageTimer {
+public:
+    StageTimer(Profile* profile, const char* name) : profile_(profile), name_(name) {}
+    ~StageTimer() {
+        if (profile_ && calls_ > 0) profile_->addStageTime(name_, total_);
+    }
+    void start() {
+        if (profile_) start_ = Profile::Clock::now();
+    }
+    void stop() {
+        if (!profile_) return;
+        total_ += Profile::Clock::now() - start_;
+        ++calls_;
+    }
+
+private:
+    Profile* profile_;
+    const char* name_;
+    Profile::Clock::time_point start_{};
+    Profile::Clock::duration total_{0};
+    std::uint64_t calls_ = 0;
+};
+
+}  // namespace TNM067
+
+}  // namespace inviwo
+
+#if TNM067_ENABLE_INSTRUMENTATION
+#define TNM067_PROFILE_CONCAT_IMPL(a, b) a##b
+#define TNM067_PROFILE_CONCAT(a, b) TNM067_PROFILE_CONCAT_IMPL(a, b)
+#define TNM067_PROFILE_SCOPE(profile, name)                                           \
+    ::inviwo::TNM067::ScopedTimer TNM067_PROFILE_CONCAT(tnm067ScopedTimer, __LINE__) { \
+        profile, name                                                                 \
+    }
+#define TNM067_PROFILE_STAGE(var, profile, name) ::inviwo::TNM067::StageTimer var{profile, name}
+#define TNM067_PROFILE_STAGE_START(var) var.start()
+#define TNM067_PROFILE_STAGE_STOP(var) var.stop()
+#define TNM067_PROFILE_COUNT(profile, counter, count)                             \
+    do {                                                                            \
+        if (profile) (profile)->addCount(::inviwo::TNM067::Counter::counter, count); \
+    } while (false)
+#else
+#define TNM067_PROFILE_SCOPE(profile, name) static_cast<void>(profile)
+#define TNM067_PROFILE_STAGE(var, profile, name) static_cast<void>(profile)
+#define TNM067_PROFILE_STAGE_START(var) static_cast<void>(0)
+#define TNM067_PROFILE_STAGE_STOP(var) static_cast<void>(0)
+#define TNM067_PROFILE_COUNT(profile, counter, count) static_cast<void>(profile)
+#endif
@@ -3,6 +3,10 @@
 #include <modules/tnm067lab1/tnm067lab1moduledefine.h>
 #include <inviwo/core/util/glm.h>
 
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <vector>
 
 namespace inviwo {
 
@@ -142,9 +146,10 @@ T barycentric(const std::array<T, 4>& v, F x, F y) {
     // alpha and beta are effecivly a division of 2 triangles formed by placing a point p inside the bigger triangle.
     // gamma is calculated from alpha and beta according to the formula: 1.0f - alpha - beta
     
-    F alpha, beta, gamma, fA;
-    F fB = v[1];
-    F fG = v[2];
+    F alpha, beta, gamma;
+    T fA;
+    const T& fB = v[1];
+    const T& fG = v[2];
     
     // acording to the formula a + b + g = 1
     if (x + y < 1.0f) {
@@ -165,6 +170,108 @@ T barycentric(const std::array<T, 4>& v, F x, F y) {
     return alpha * fA + beta * fB + gamma * fG;
 }
 
+// clang-format off
+/*
+ Weights of quadratic() at x, for the samples a, b, c
+ */
+// clang-format on
+template <typename F = double>
+std::array<F, 3> quadraticWeights(F x) {
+    return {(1 - x) * (1 - 2 * x), 4 * x * (1 - x), x * (2 * x - 1)};
+}
+
+enum class CubicKernel {
+    Bicubic,     //!< Keys cubic convolution with a = -0.75, slightly sharper than Catmull-Rom
+    CatmullRom,  //!< Keys cubic convolution with a = -0.5, interpolating
+    BSpline,     //!< Uniform cubic B-spline, smooth but does not interpolate the samples
+};
+
+// clang-format off
+/*
+ a------b------c------d
+ -1     0  x   1      2
+ */
+// clang-format on
+template <typename F = double>
+std::array<F, 4> cubicWeights(CubicKernel kernel, F x) {
+    const F x2 = x * x;
+    const F x3 = x2 * x;
+    if (kernel == CubicKernel::BSpline) {
+        return {(1 - x) * (1 - x) * (1 - x) / 6, (3 * x3 - 6 * x2 + 4) / 6,
+                (-3 * x3 + 3 * x2 + 3 * x + 1) / 6, x3 / 6};
+    }
+    const F a = kernel == CubicKernel::Bicubic ? F(-0.75) : F(-0.5);
+    // Keys kernel, |d| <= 1: (a + 2)|d|^3 - (a + 3)|d|^2 + 1, 1 < |d| < 2: a(|d|^3 - 5|d|^2 + 8|d| - 4)
+    auto inner = [a](F d) { return ((a + 2) * d - (a + 3)) * d * d + 1; };
+    auto outer = [a](F d) { return a * (((d - 5) * d + 8) * d - 4); };
+    return {outer(1 + x), inner(x), inner(1 - x), outer(2 - x)};
+}
+
+/**
+ * Evaluates the tensor product of the N x N samples v (row by row, x fastest) with the weights wx
+ * and wy.
+ */
+template <size_t N, typename T, typename F>
+T separable(const std::array<T, N * N>& v, const std::array<F, N>& wx, const std::array<F, N>& wy) {
+    T result(0);
+    for (size_t j = 0; j < N; ++j) {
+        T row(0);
+        for (size_t i = 0; i < N; ++i) {
+            row += wx[i] * v[i + j * N];
+        }
+        result += wy[j] * row;
+    }
+    return result;
+}
+
+/**
+ * \class KernelTable
+ * \brief Per-phase weights of an N tap kernel along one axis of an upscale from inSize to outSize.
+ * Output coordinate o maps to c = o * inSize / outSize + shift, its taps start at floor(c) +
+ * tapOffset and the weights are weights(c - floor(c)). Since c advances by inSize / g input pixels
+ * every outSize / g output pixels (g = gcd(inSize, outSize)) only outSize / g distinct phases exist,
+ * and for an integer scale factor s only s. These are evaluated once on construction so looking
+ * up the weights of a pixel is a table lookup.
+ */
+template <size_t N, typename F = double>
+class KernelTable {
+public:
+    struct Entry {
+        int first;  //!< Index of the first tap relative to the start of the period
+        std::array<F, N> weights;
+    };
+
+    template <typename Weights>
+    KernelTable(size_t inSize, size_t outSize, double shift, int tapOffset, Weights weights)
+        : period_(outSize / std::gcd(inSize, outSize))
+        , stride_(static_cast<int>(inSize / std::gcd(inSize, outSize))) {
+        entries_.reserve(period_);
+        for (size_t k = 0; k < period_; ++k) {
+            const double c = static_cast<double>(k) * static_cast<double>(inSize) /
+                                 static_cast<double>(outSize) +
+                             shift;
+            const double f = std::floor(c);
+            entries_.push_back({static_cast<int>(f) + tapOffset, weights(static_cast<F>(c - f))});
+        }
+    }
+
+    /**
+     * Returns the weights of output coordinate o and sets first to the index of its first tap
+     */
+    const std::array<F, N>& operator()(size_t o, int& first) const {
+        const auto& entry = entries_[o % period_];
+        first = static_cast<int>(o / period_) * stride_ + entry.first;
+        return entry.weights;
+    }
+
+    size_t phases() const { return period_; }
+
+private:
+    size_t period_;
+    int stride_;
+    std::vector<Entry> entries_;
+};
+
 }  // namespace Interpolation
 }  // namespace TNM067
 }  // namespace inviwo
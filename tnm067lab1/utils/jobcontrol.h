@@ -0,0 +1,43 @@
+#pragma once
+
+#include <modules/tnm067lab1/tnm067lab1moduledefine.h>
+
+#include <functional>
+#include <utility>
+
+namespace inviwo {
+
+namespace TNM067 {
+
+/**
+ * \class JobControl
+ * \brief Lets a long running function report its progress and stop early.
+ * Functions taking a JobControl check stopped() at regular checkpoints, such as once per z-slice
+ * or image row, and return nullptr once it is set since their result is no longer wanted. A
+ * default constructed JobControl never stops and ignores the progress. Both callbacks may be
+ * called from the thread running the function, which need not be the main thread.
+ */
+class JobControl {
+public:
+    JobControl() = default;
+    JobControl(std::function<bool()> stop, std::function<void(float)> progress)
+        : stop_(std::move(stop)), progress_(std::move(progress)) {}
+
+    bool stopped() const { return stop_ && stop_(); }
+
+    /// Reports the fraction of the work done, in [0, 1]
+    void progress(float done) const {
+        if (progress_) progress_(done);
+    }
+    void progress(size_t done, size_t total) const {
+        progress(total > 0 ? static_cast<float>(done) / static_cast<float>(total) : 1.0f);
+    }
+
+private:
+    std::function<bool()> stop_;
+    std::function<void(float)> progress_;
+};
+
+}  // namespace TNM067
+
+}  // namespace inviwo
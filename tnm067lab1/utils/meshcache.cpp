@@ -0,0 +1,332 @@
+#include <modules/tnm067lab1/utils/meshcache.h>
+#include <inviwo/core/datastructures/buffer/bufferram.h>
+#include <inviwo/core/util/logcentral.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#ifdef WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace inviwo {
+
+namespace TNM067 {
+
+namespace {
+
+constexpr std::uint64_t mix(std::uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/// Path next to target that no other store, in this process or another one, writes to
+std::string temporaryPath(const std::string& target) {
+    static std::atomic<std::uint64_t> counter{0};
+#ifdef WIN32
+    const auto pid = static_cast<std::uint64_t>(GetCurrentProcessId());
+#else
+    const auto pid = static_cast<std::uint64_t>(getpid());
+#endif
+    return target + "." + std::to_string(pid) + "." + std::to_string(counter++) + ".tmp";
+}
+
+}  // namespace
+
+Hasher& Hasher::add(const void* data, size_t bytes) {
+    const auto* ptr = static_cast<const unsigned char*>(data);
+    std::uint64_t state = state_;
+    size_t i = 0;
+    for (; i + 8 <= bytes; i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, ptr + i, 8);
+        state = (state ^ word) * 0x9fb21c651e98df25ULL;
+        state ^= state >> 29;
+    }
+    if (i < bytes) {
+        std::uint64_t word = 0;
+        std::memcpy(&word, ptr + i, bytes - i);
+        state = (state ^ word) * 0x9fb21c651e98df25ULL;
+        state ^= state >> 29;
+    }
+    state_ = state;
+    length_ += bytes;
+    return *this;
+}
+
+std::uint64_t Hasher::get() const { return mix(state_ ^ mix(length_)); }
+
+namespace {
+
+constexpr char magic[8] = {'T', 'N', 'M', '0', '6', '7', 'M', 'C'};
+constexpr std::uint32_t version = 1;
+constexpr std::uint64_t alignment = 64;
+
+struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t numBuffers;
+    std::uint32_t numIndexBuffers;
+    std::uint32_t reserved;
+    mat4 modelMatrix;
+    mat4 worldMatrix;
+};
+
+struct BufferEntry {
+    std::uint32_t type;
+    std::int32_t location;
+    std::uint32_t format;
+    std::uint32_t elementSize;
+    std::uint64_t count;
+    std::uint64_t offset;
+};
+
+struct IndexEntry {
+    std::uint32_t drawType;
+    std::uint32_t connectivity;
+    std::uint64_t count;
+    std::uint64_t offset;
+};
+
+constexpr std::uint64_t align(std::uint64_t offset) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * Read only memory mapping of a whole file
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#ifdef WIN32
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) return;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file_, &size) || size.QuadPart == 0) return;
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping_) return;
+        data_ = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+        if (data_) size_ = static_cast<size_t>(size.QuadPart);
+#else
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) return;
+        struct stat st;
+        if (::fstat(fd_, &st) != 0 || st.st_size == 0) return;
+        void* data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (data == MAP_FAILED) return;
+        data_ = data;
+        size_ = static_cast<size_t>(st.st_size);
+#endif
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() {
+#ifdef WIN32
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+#else
+        if (data_) ::munmap(data_, size_);
+        if (fd_ >= 0) ::close(fd_);
+#endif
+    }
+
+    const unsigned char* data() const { return static_cast<const unsigned char*>(data_); }
+    size_t size() const { return size_; }
+
+private:
+#ifdef WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+    void* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+}  // namespace
+
+MeshCache::MeshCache(std::string directory) : directory_(std::move(directory)) {}
+
+std::string MeshCache::path(std::uint64_t key) const {
+    std::stringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << key << ".tnm067mesh";
+    return (std::filesystem::path(directory_) / ss.str()).string();
+}
+
+bool MeshCache::load(std::uint64_t key, Mesh& mesh) const {
+    if (directory_.empty()) return false;
+    MappedFile file(path(key));
+    if (!file.data() || file.size() < sizeof(Header)) return false;
+
+    Header header;
+    std::memcpy(&header, file.data(), sizeof(Header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version ||
+        header.numBuffers != mesh.getNumberOfBuffers() || mesh.getNumberOfIndicies() != 0) {
+        return false;
+    }
+
+    const size_t tableSize =
+        sizeof(Header) + header.numBuffers * sizeof(BufferEntry) +
+        header.numIndexBuffers * sizeof(IndexEntry);
+    if (file.size() < tableSize) return false;
+    const auto* bufferEntries = file.data() + sizeof(Header);
+    const auto* indexEntries = bufferEntries + header.numBuffers * sizeof(BufferEntry);
+
+    auto inFile = [&](std::uint64_t offset, std::uint64_t bytes) {
+        return offset <= file.size() && bytes <= file.size() - offset;
+    };
+
+    // Validate everything before touching the mesh so a bad file leaves it untouched
+    for (std::uint32_t i = 0; i < header.numBuffers; ++i) {
+        BufferEntry entry;
+        std::memcpy(&entry, bufferEntries + i * sizeof(BufferEntry), sizeof(BufferEntry));
+        const auto info = mesh.getBufferInfo(i);
+        const auto buffer = mesh.getBuffer(i);
+        if (entry.type != static_cast<std::uint32_t>(info.type) ||
+            entry.location != info.location ||
+            entry.format != static_cast<std::uint32_t>(buffer->getDataFormat()->getId()) ||
+            entry.elementSize != buffer->getSizeOfElement() ||
+            !inFile(entry.offset, entry.count * entry.elementSize)) {
+            return false;
+        }
+    }
+    for (std::uint32_t i = 0; i < header.numIndexBuffers; ++i) {
+        IndexEntry entry;
+        std::memcpy(&entry, indexEntries + i * sizeof(IndexEntry), sizeof(IndexEntry));
+        if (!inFile(entry.offset, entry.count * sizeof(std::uint32_t))) return false;
+    }
+
+    mesh.setModelMatrix(header.modelMatrix);
+    mesh.setWorldMatrix(header.worldMatrix);
+    for (std::uint32_t i = 0; i < header.numBuffers; ++i) {
+        BufferEntry entry;
+        std::memcpy(&entry, bufferEntries + i * sizeof(BufferEntry), sizeof(BufferEntry));
+        auto ram = mesh.getBuffer(i)->getEditableRepresentation<BufferRAM>();
+        ram->setSize(static_cast<size_t>(entry.count));
+        std::memcpy(ram->getData(), file.data() + entry.offset,
+                    static_cast<size_t>(entry.count * entry.elementSize));
+    }
+    for (std::uint32_t i = 0; i < header.numIndexBuffers; ++i) {
+        IndexEntry entry;
+        std::memcpy(&entry, indexEntries + i * sizeof(IndexEntry), sizeof(IndexEntry));
+        auto indices = mesh.addIndexBuffer(static_cast<DrawType>(entry.drawType),
+                                           static_cast<ConnectivityType>(entry.connectivity));
+        auto& container = indices->getDataContainer();
+        container.resize(static_cast<size_t>(entry.count));
+        std::memcpy(container.data(), file.data() + entry.offset,
+                    static_cast<size_t>(entry.count * sizeof(std::uint32_t)));
+    }
+    return true;
+}
+
+void MeshCache::store(std::uint64_t key, const Mesh& mesh) const {
+    if (directory_.empty()) return;
+
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.numBuffers = static_cast<std::uint32_t>(mesh.getNumberOfBuffers());
+    header.numIndexBuffers = static_cast<std::uint32_t>(mesh.getNumberOfIndicies());
+    header.modelMatrix = mesh.getModelMatrix();
+    header.worldMatrix = mesh.getWorldMatrix();
+
+    std::vector<BufferEntry> bufferEntries;
+    std::vector<IndexEntry> indexEntries;
+    std::vector<const void*> blocks;
+    std::uint64_t offset = align(sizeof(Header) + header.numBuffers * sizeof(BufferEntry) +
+                                 header.numIndexBuffers * sizeof(IndexEntry));
+
+    for (size_t i = 0; i < mesh.getNumberOfBuffers(); ++i) {
+        const auto info = mesh.getBufferInfo(i);
+        const auto buffer = mesh.getBuffer(i);
+        const auto ram = buffer->getRepresentation<BufferRAM>();
+        BufferEntry entry{static_cast<std::uint32_t>(info.type),
+                          info.location,
+                          static_cast<std::uint32_t>(buffer->getDataFormat()->getId()),
+                          static_cast<std::uint32_t>(buffer->getSizeOfElement()),
+                          ram->getSize(),
+                          offset};
+        offset = align(offset + entry.count * entry.elementSize);
+        bufferEntries.push_back(entry);
+        blocks.push_back(ram->getData());
+    }
+    for (size_t i = 0; i < mesh.getNumberOfIndicies(); ++i) {
+        const auto info = mesh.getIndexMeshInfo(i);
+        const auto& indices = mesh.getIndices(i)->getRAMRepresentation()->getDataContainer();
+        IndexEntry entry{static_cast<std::uint32_t>(info.dt), static_cast<std::uint32_t>(info.ct),
+                         indices.size(), offset};
+        offset = align(offset + entry.count * sizeof(std::uint32_t));
+        indexEntries.push_back(entry);
+        blocks.push_back(indices.data());
+    }
+
+    // Write to a temporary file and rename it so a concurrent reader never sees a partial file
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    const auto target = path(key);
+    const auto tmp = temporaryPath(target);
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            LogWarnCustom("MeshCache", "Could not write cache file " << tmp);
+            return;
+        }
+        auto pad = [&](std::uint64_t to) {
+            static const char zeros[alignment] = {};
+            const auto pos = static_cast<std::uint64_t>(out.tellp());
+            out.write(zeros, static_cast<std::streamsize>(to - pos));
+        };
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        out.write(reinterpret_cast<const char*>(bufferEntries.data()),
+                  bufferEntries.size() * sizeof(BufferEntry));
+        out.write(reinterpret_cast<const char*>(indexEntries.data()),
+                  indexEntries.size() * sizeof(IndexEntry));
+
+        size_t block = 0;
+        for (const auto& entry : bufferEntries) {
+            pad(entry.offset);
+            out.write(static_cast<const char*>(blocks[block++]),
+                      static_cast<std::streamsize>(entry.count * entry.elementSize));
+        }
+        for (const auto& entry : indexEntries) {
+            pad(entry.offset);
+            out.write(static_cast<const char*>(blocks[block++]),
+                      static_cast<std::streamsize>(entry.count * sizeof(std::uint32_t)));
+        }
+        if (!out) {
+            LogWarnCustom("MeshCache", "Could not write cache file " << tmp);
+            out.close();
+            std::filesystem::remove(tmp, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(tmp, target, ec);
+    if (ec) {
+        LogWarnCustom("MeshCache", "Could not write cache file " << target << ": " << ec.message());
+        std::filesystem::remove(tmp, ec);
+    }
+}
+
+}  // namespace TNM067
+
+}  // namespace inviwo
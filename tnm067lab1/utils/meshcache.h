@@ -0,0 +1,71 @@
+#pragma once
+
+#include <modules/tnm067lab1/tnm067lab1moduledefine.h>
+#include <inviwo/core/datastructures/geometry/mesh.h>
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace inviwo {
+
+namespace TNM067 {
+
+/**
+ * \class Hasher
+ * \brief 64-bit non-cryptographic hash used for the keys of the MeshCache.
+ * Processes input eight bytes at a time so hashing large volumes is cheap compared to extraction.
+ */
+class IVW_MODULE_TNM067LAB1_API Hasher {
+public:
+    Hasher& add(const void* data, size_t bytes);
+
+    template <typename T, typename = std::enable_if_t<std::is_trivially_copyable_v<T>>>
+    Hasher& add(const T& value) {
+        return add(&value, sizeof(T));
+    }
+    Hasher& add(const std::string& str) { return add(str.data(), str.size()); }
+
+    std::uint64_t get() const;
+
+private:
+    std::uint64_t state_ = 0x9e3779b97f4a7c15ULL;
+    std::uint64_t length_ = 0;
+};
+
+/**
+ * \class MeshCache
+ * \brief Content addressed on-disk cache of meshes.
+ * Each mesh is stored as one flat binary file named by its key, containing the model and world
+ * matrices followed by the raw contents of every vertex and index buffer. Loading maps the file
+ * into memory and copies each array straight into the corresponding mesh buffer without parsing.
+ */
+class IVW_MODULE_TNM067LAB1_API MeshCache {
+public:
+    explicit MeshCache(std::string directory);
+
+    /**
+     * Fills mesh from the cache entry of key. mesh should be newly constructed and of the same
+     * type as the stored mesh, i.e. have the same vertex buffers and no index buffers.
+     * @return false if there is no valid entry for key or it does not match the buffers of mesh
+     */
+    bool load(std::uint64_t key, Mesh& mesh) const;
+
+    /**
+     * Stores mesh under key, replacing any existing entry. Failures are logged and ignored since
+     * the cache is only an optimization.
+     */
+    void store(std::uint64_t key, const Mesh& mesh) const;
+
+    /// False for a cache that never hits and never stores anything, keys need not be computed
+    bool isEnabled() const { return !directory_.empty(); }
+
+    std::string path(std::uint64_t key) const;
+
+private:
+    std::string directory_;
+};
+
+}  // namespace TNM067
+
+}  // namespace inviwo
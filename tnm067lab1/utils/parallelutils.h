@@ -0,0 +1,84 @@
+#pragma once
+
+#include <modules/tnm067lab1/tnm067lab1moduledefine.h>
+#include <inviwo/core/common/inviwoapplication.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+namespace inviwo {
+
+namespace TNM067 {
+
+/**
+ * Number of jobs used by forEachRangeParallel when no job count is given. Use this to size
+ * per-job accumulators.
+ */
+inline size_t defaultJobCount() {
+    return 4 * std::max<size_t>(1, InviwoApplication::getPtr()->getThreadPool().getSize());
+}
+
+/**
+ * Splits [0, count) into contiguous ranges and processes them on the Inviwo thread pool. Blocks
+ * until all ranges are done and rethrows the first exception thrown by the callback. The
+ * callback is called as callback(begin, end, job) where job is in [0, jobs) and can be used to
+ * index per-job accumulators.
+ *
+ * The calling thread processes ranges too and never waits for a task that has not started, so
+ * this can be called from a pool thread while all other pool threads are busy, for example with
+ * jobs waiting for a TNM067::BufferPool lock held by the caller.
+ *
+ * @param count number of items to process
+ * @param callback function processing the items in [begin, end)
+ * @param jobs number of ranges, defaults to defaultJobCount()
+ */
+template <typename C>
+void forEachRangeParallel(size_t count, C callback, size_t jobs = 0) {
+    if (jobs == 0) jobs = defaultJobCount();
+    jobs = std::min(jobs, count);
+    if (jobs <= 1) {
+        if (count > 0) callback(size_t{0}, count, size_t{0});
+        return;
+    }
+
+    // Ranges are claimed from a shared counter. A task starting after every range is claimed
+    // returns without touching callback, which may be gone by then.
+    struct State {
+        std::atomic<size_t> next{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+        size_t done = 0;
+        std::exception_ptr exception;
+    };
+    const auto state = std::make_shared<State>();
+    auto work = [state, &callback, count, jobs]() {
+        for (size_t job = state->next++; job < jobs; job = state->next++) {
+            std::exception_ptr exception;
+            try {
+                callback(count * job / jobs, count * (job + 1) / jobs, job);
+            } catch (...) {
+                exception = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (exception && !state->exception) state->exception = exception;
+            if (++state->done == jobs) state->finished.notify_all();
+        }
+    };
+
+    for (size_t task = 1; task < jobs; ++task) {
+        dispatchPool(work);
+    }
+    work();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&]() { return state->done == jobs; });
+    if (state->exception) std::rethrow_exception(state->exception);
+}
+
+}  // namespace TNM067
+
+}  // namespace inviwo
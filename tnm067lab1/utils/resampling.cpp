@@ -0,0 +1,124 @@
+#include <modules/tnm067lab1/utils/resampling.h>
+
+#include <cmath>
+
+namespace inviwo {
+
+namespace TNM067 {
+
+namespace {
+
+double sinc(double x) {
+    if (std::abs(x) < 1e-8) return 1.0;
+    const double px = glm::pi<double>() * x;
+    return std::sin(px) / px;
+}
+
+}  // namespace
+
+AxisWeights computeAxisWeights(size_t inSize, size_t outSize, ReductionFilter filter) {
+    AxisWeights axis;
+    axis.offsets.reserve(outSize + 1);
+    axis.offsets.push_back(0);
+
+    const double scale = static_cast<double>(inSize) / static_cast<double>(outSize);
+    const bool reduce = scale > 1.0 && filter != ReductionFilter::None;
+    const auto last = static_cast<std::int64_t>(inSize) - 1;
+
+    auto addTap = [&](std::int64_t i, double w) {
+        if (w == 0.0) return;
+        axis.indices.push_back(static_cast<std::uint32_t>(glm::clamp<std::int64_t>(i, 0, last)));
+        axis.weights.push_back(static_cast<float>(w));
+    };
+
+    for (size_t o = 0; o < outSize; ++o) {
+        const size_t first = axis.weights.size();
+        // Center of output pixel o in input pixel coordinates
+        const double center = (static_cast<double>(o) + 0.5) * scale - 0.5;
+
+        if (!reduce) {
+            const double f = std::floor(center);
+            const double t = center - f;
+            const auto i = static_cast<std::int64_t>(f);
+            addTap(i, 1.0 - t);
+            addTap(i + 1, t);
+        } else if (filter == ReductionFilter::Box) {
+            const double radius = 0.5 * scale;
+            const auto begin = static_cast<std::int64_t>(std::ceil(center - radius));
+            const auto end = static_cast<std::int64_t>(std::floor(center + radius));
+            for (auto i = begin; i <= end; ++i) addTap(i, 1.0);
+        } else if (filter == ReductionFilter::Area) {
+            const double lo = static_cast<double>(o) * scale;
+            const double hi = lo + scale;
+            const auto begin = static_cast<std::int64_t>(std::floor(lo));
+            const auto end = static_cast<std::int64_t>(std::ceil(hi));
+            for (auto i = begin; i < end; ++i) {
+                const double overlap = std::min(hi, static_cast<double>(i + 1)) -
+                                       std::max(lo, static_cast<double>(i));
+                addTap(i, std::max(overlap, 0.0));
+            }
+        } else {
+            constexpr double lobes = 3.0;
+            const double radius = lobes * scale;
+            const auto begin = static_cast<std::int64_t>(std::ceil(center - radius));
+            const auto end = static_cast<std::int64_t>(std::floor(center + radius));
+            for (auto i = begin; i <= end; ++i) {
+                const double x = (static_cast<double>(i) - center) / scale;
+                if (std::abs(x) < lobes) addTap(i, sinc(x) * sinc(x / lobes));
+            }
+        }
+
+        double sum = 0.0;
+        for (size_t k = first; k < axis.weights.size(); ++k) sum += axis.weights[k];
+        if (sum != 0.0) {
+            for (size_t k = first; k < axis.weights.size(); ++k) {
+                axis.weights[k] = static_cast<float>(axis.weights[k] / sum);
+            }
+        }
+        axis.offsets.push_back(axis.weights.size());
+    }
+    return axis;
+}
+
+AxisWeights computeAxisWeights(size_t inSize, size_t outSize, InterpolationKernel kernel) {
+    AxisWeights axis;
+    const size_t taps = kernel == InterpolationKernel::Nearest  ? 1
+                        : kernel == InterpolationKernel::Linear ? 2
+                                                                : 4;
+    axis.offsets.reserve(outSize + 1);
+    axis.indices.reserve(outSize * taps);
+    axis.weights.reserve(outSize * taps);
+    axis.offsets.push_back(0);
+
+    const double scale = static_cast<double>(inSize) / static_cast<double>(outSize);
+    const auto last = static_cast<std::int64_t>(inSize) - 1;
+
+    auto addTap = [&](std::int64_t i, double w) {
+        axis.indices.push_back(static_cast<std::uint32_t>(glm::clamp<std::int64_t>(i, 0, last)));
+        axis.weights.push_back(static_cast<float>(w));
+    };
+
+    for (size_t o = 0; o < outSize; ++o) {
+        // Center of output sample o in input sample coordinates
+        const double center = (static_cast<double>(o) + 0.5) * scale - 0.5;
+        const double f = std::floor(center);
+        const double t = center - f;
+        const auto i = static_cast<std::int64_t>(f);
+
+        if (kernel == InterpolationKernel::Nearest) {
+            addTap(t < 0.5 ? i : i + 1, 1.0);
+        } else if (kernel == InterpolationKernel::Linear) {
+            addTap(i, 1.0 - t);
+            addTap(i + 1, t);
+        } else {
+            const auto w = Interpolation::cubicWeights(Interpolation::CubicKernel::CatmullRom, t);
+            for (size_t k = 0; k < 4; ++k) addTap(i - 1 + static_cast<std::int64_t>(k), w[k]);
+        }
+        axis.offsets.push_back(axis.weights.size());
+    }
+    return axis;
+}
+
+}  // namespace TNM067
+
+}  // namespace inviwo
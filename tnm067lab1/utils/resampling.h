@@ -0,0 +1,237 @@
+#pragma once
+
+#include <modules/tnm067lab1/tnm067lab1moduledefine.h>
+#include <modules/tnm067lab1/utils/interpolationmethods.h>
+#include <modules/tnm067lab1/utils/parallelutils.h>
+#include <modules/tnm067lab1/utils/jobcontrol.h>
+#include <inviwo/core/util/glm.h>
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace inviwo {
+
+namespace TNM067 {
+
+/**
+ * Floating point type used when resampling pixels of type T, a scalar or a vector with the same
+ * number of channels as T.
+ */
+template <typename T>
+using resample_float_t =
+    util::same_extent_t<T, typename float_type<typename util::value_type<T>::type>::type>;
+
+/**
+ * Converts a resampled value back to the pixel type T, rounding and clamping integer types.
+ */
+template <typename T, typename FT>
+T toPixel(const FT& value) {
+    using P = typename util::value_type<T>::type;
+    if constexpr (std::is_integral_v<P>) {
+        using F = typename util::value_type<FT>::type;
+        constexpr auto lowest = static_cast<F>(std::numeric_limits<P>::lowest());
+        constexpr auto highest = static_cast<F>(std::numeric_limits<P>::max());
+        return static_cast<T>(glm::clamp(glm::round(value), FT(lowest), FT(highest)));
+    } else {
+        return static_cast<T>(value);
+    }
+}
+
+enum class ReductionFilter {
+    None,      //!< No prefiltering, output pixels are interpolated at a single point
+    Box,       //!< Average of the input pixels with their center inside the output pixel
+    Area,      //!< Input pixels weighted by how much of them the output pixel covers
+    Lanczos3,  //!< Lanczos windowed sinc with three lobes, sharpest but may ring
+};
+
+enum class InterpolationKernel {
+    Nearest,  //!< Closest input sample
+    Linear,   //!< Linear interpolation between the two closest samples
+    Cubic,    //!< Catmull-Rom cubic through the four closest samples
+};
+
+/**
+ * \struct AxisWeights
+ * \brief Precomputed filter taps along one axis.
+ * The taps of output coordinate i are indices[offsets[i]] ... indices[offsets[i + 1] - 1] with the
+ * corresponding weights. Indices are clamped to the input and weights are normalized to sum to one.
+ */
+struct IVW_MODULE_TNM067LAB1_API AxisWeights {
+    std::vector<size_t> offsets;
+    std::vector<std::uint32_t> indices;
+    std::vector<float> weights;
+
+    size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+};
+
+/**
+ * Computes the taps for resampling an axis of inSize pixels to outSize pixels using pixel center
+ * alignment. Axes that are magnified rather than reduced use linear interpolation regardless of
+ * the filter.
+ */
+IVW_MODULE_TNM067LAB1_API AxisWeights computeAxisWeights(size_t inSize, size_t outSize,
+                                                         ReductionFilter filter);
+
+/**
+ * Computes the taps for interpolating an axis of inSize samples at outSize points using pixel
+ * center alignment, with 1, 2 or 4 taps per output depending on the kernel. There is no
+ * prefiltering, so reduced axes may alias.
+ */
+IVW_MODULE_TNM067LAB1_API AxisWeights computeAxisWeights(size_t inSize, size_t outSize,
+                                                         InterpolationKernel kernel);
+
+/**
+ * Separable resampling of the interleaved image in to out using precomputed per-axis weights. The
+ * horizontal pass writes one intermediate row per input row, the vertical pass then combines whole
+ * rows, both passes run in parallel over rows.
+ */
+template <typename T>
+void resample(const T* in, size2_t inDims, T* out, size2_t outDims, const AxisWeights& wx,
+              const AxisWeights& wy) {
+    using FT = resample_float_t<T>;
+    using F = typename util::value_type<FT>::type;
+
+    std::vector<FT> tmp(inDims.y * outDims.x);
+    forEachRangeParallel(inDims.y, [&](size_t begin, size_t end, size_t) {
+        for (size_t y = begin; y < end; ++y) {
+            const T* inRow = in + y * inDims.x;
+            FT* tmpRow = tmp.data() + y * outDims.x;
+            for (size_t x = 0; x < outDims.x; ++x) {
+                FT sum(0);
+                for (size_t k = wx.offsets[x]; k < wx.offsets[x + 1]; ++k) {
+                    sum += static_cast<F>(wx.weights[k]) * static_cast<FT>(inRow[wx.indices[k]]);
+                }
+                tmpRow[x] = sum;
+            }
+        }
+    });
+
+    forEachRangeParallel(outDims.y, [&](size_t begin, size_t end, size_t) {
+        std::vector<FT> row(outDims.x);
+        for (size_t y = begin; y < end; ++y) {
+            std::fill(row.begin(), row.end(), FT(0));
+            for (size_t k = wy.offsets[y]; k < wy.offsets[y + 1]; ++k) {
+                const F w = static_cast<F>(wy.weights[k]);
+                const FT* tmpRow = tmp.data() + wy.indices[k] * outDims.x;
+                for (size_t x = 0; x < outDims.x; ++x) {
+                    row[x] += w * tmpRow[x];
+                }
+            }
+            T* outRow = out + y * outDims.x;
+            for (size_t x = 0; x < outDims.x; ++x) {
+                outRow[x] = toPixel<T>(row[x]);
+            }
+        }
+    });
+}
+
+template <typename T>
+void resample(const T* in, size2_t inDims, T* out, size2_t outDims, ReductionFilter filter) {
+    resample(in, inDims, out, outDims, computeAxisWeights(inDims.x, outDims.x, filter),
+             computeAxisWeights(inDims.y, outDims.y, filter));
+}
+
+/**
+ * Separable resampling of the volume in to out using precomputed per-axis weights. The output is
+ * split into bricks of brickSize^3 voxels which are processed in parallel. Each brick filters the
+ * box of input voxels its taps touch along x, then y, then z, so the temporaries of a brick are
+ * bounded by the brick size and the tap extent rather than the volume size. Returns false if
+ * control is stopped, which is checked once per brick.
+ */
+template <typename T>
+bool resample(const T* in, size3_t inDims, T* out, size3_t outDims, const AxisWeights& wx,
+              const AxisWeights& wy, const AxisWeights& wz, size_t brickSize = 32,
+              const JobControl* control = nullptr) {
+    using FT = resample_float_t<T>;
+    using F = typename util::value_type<FT>::type;
+
+    const size3_t bricks = (outDims + size3_t(brickSize - 1)) / size3_t(brickSize);
+    const size_t brickCount = bricks.x * bricks.y * bricks.z;
+
+    // Input samples touched by the taps of outputs [begin, end) along an axis
+    const auto footprint = [](const AxisWeights& w, size_t begin, size_t end) {
+        std::uint32_t lo = std::numeric_limits<std::uint32_t>::max();
+        std::uint32_t hi = 0;
+        for (size_t k = w.offsets[begin]; k < w.offsets[end]; ++k) {
+            lo = std::min(lo, w.indices[k]);
+            hi = std::max(hi, w.indices[k]);
+        }
+        return std::make_pair(size_t{lo}, size_t{hi} + 1);
+    };
+
+    std::atomic<size_t> bricksDone{0};
+    std::atomic<bool> stopped{false};
+    forEachRangeParallel(brickCount, [&](size_t begin, size_t end, size_t) {
+        std::vector<FT> tmpX;
+        std::vector<FT> tmpY;
+        std::vector<FT> row;
+        for (size_t b = begin; b < end; ++b) {
+            if (stopped || (control && control->stopped())) {
+                stopped = true;
+                return;
+            }
+            const size3_t brick{b % bricks.x, (b / bricks.x) % bricks.y,
+                                b / (bricks.x * bricks.y)};
+            const size3_t o0 = brick * brickSize;
+            const size3_t o1 = glm::min(o0 + size3_t(brickSize), outDims);
+            const size_t nx = o1.x - o0.x;
+            const size_t ny = o1.y - o0.y;
+            const auto [y0, y1] = footprint(wy, o0.y, o1.y);
+            const auto [z0, z1] = footprint(wz, o0.z, o1.z);
+            const size_t inY = y1 - y0;
+
+            // x pass, one row of nx values per input row of the footprint
+            tmpX.resize(nx * inY * (z1 - z0));
+            for (size_t z = z0; z < z1; ++z) {
+                for (size_t y = y0; y < y1; ++y) {
+                    const T* inRow = in + (y + z * inDims.y) * inDims.x;
+                    FT* tmpRow = tmpX.data() + nx * ((y - y0) + inY * (z - z0));
+                    for (size_t x = 0; x < nx; ++x) {
+                        FT sum(0);
+                        for (size_t k = wx.offsets[o0.x + x]; k < wx.offsets[o0.x + x + 1]; ++k) {
+                            sum += static_cast<F>(wx.weights[k]) *
+                                   static_cast<FT>(inRow[wx.indices[k]]);
+                        }
+                        tmpRow[x] = sum;
+                    }
+                }
+            }
+
+            // y pass, combines whole rows of the x pass
+            tmpY.assign(nx * ny * (z1 - z0), FT(0));
+            for (size_t z = z0; z < z1; ++z) {
+                for (size_t y = 0; y < ny; ++y) {
+                    FT* tmpRow = tmpY.data() + nx * (y + ny * (z - z0));
+                    for (size_t k = wy.offsets[o0.y + y]; k < wy.offsets[o0.y + y + 1]; ++k) {
+                        const F w = static_cast<F>(wy.weights[k]);
+                        const FT* src = tmpX.data() + nx * ((wy.indices[k] - y0) + inY * (z - z0));
+                        for (size_t x = 0; x < nx; ++x) tmpRow[x] += w * src[x];
+                    }
+                }
+            }
+
+            // z pass, combines whole rows of the y pass into the output
+            row.resize(nx);
+            for (size_t z = o0.z; z < o1.z; ++z) {
+                for (size_t y = 0; y < ny; ++y) {
+                    std::fill(row.begin(), row.end(), FT(0));
+                    for (size_t k = wz.offsets[z]; k < wz.offsets[z + 1]; ++k) {
+                        const F w = static_cast<F>(wz.weights[k]);
+                        const FT* src = tmpY.data() + nx * (y + ny * (wz.indices[k] - z0));
+                        for (size_t x = 0; x < nx; ++x) row[x] += w * src[x];
+                    }
+                    T* outRow = out + o0.x + ((o0.y + y) + z * outDims.y) * outDims.x;
+                    for (size_t x = 0; x < nx; ++x) outRow[x] = toPixel<T>(row[x]);
+                }
+            }
+            if (control) control->progress(++bricksDone, brickCount);
+        }
+    });
+    return !stopped;
+}
+
+}  // namespace TNM067
+
+}  // namespace inviwo
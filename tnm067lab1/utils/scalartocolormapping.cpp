@@ -15,10 +15,8 @@ vec4 ScalarToColorMapping::sample(float t) const {
     int right = ceil((baseColors_.size() - 1) * t);
     int left = floor((baseColors_.size() - 1) * t);
     
-    //    if(right == left) {
-    //        right = right + 1;
-    //        left = left - 1;
-    //    }
+    // Exactly on a base color, also avoids dividing by zero below
+    if (right == left) return baseColors_[left];
     
     // Normalize t
     float min = left / float(baseColors_.size() - 1);
@@ -27,10 +25,11 @@ vec4 ScalarToColorMapping::sample(float t) const {
     t = (t - min) / (max - min);
     
     // TODO: Interpolate colors in baseColors_ and set dummy color to result
+    // Alpha is interpolated as well so the mapping can be used as a transfer function
     vec4 finalColor(vec4(baseColors_[left]).r + (vec4(baseColors_[right]).r - vec4(baseColors_[left]).r) * t,
                     vec4(baseColors_[left]).g + (vec4(baseColors_[right]).g - vec4(baseColors_[left]).g) * t,
                     vec4(baseColors_[left]).b + (vec4(baseColors_[right]).b - vec4(baseColors_[left]).b) * t,
-                    1);  // dummy color
+                    vec4(baseColors_[left]).a + (vec4(baseColors_[right]).a - vec4(baseColors_[left]).a) * t);
     
     return finalColor;
 }
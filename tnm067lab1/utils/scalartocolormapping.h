@@ -13,7 +13,7 @@ namespace inviwo {
 /**
  * \class ScalarToColorMapping
  * \brief Scalar to color mapping
- * Colors are interpolated from the baseColors_.
+ * Colors, including alpha, are interpolated from the baseColors_.
  */
 class IVW_MODULE_TNM067LAB1_API ScalarToColorMapping {
 public:
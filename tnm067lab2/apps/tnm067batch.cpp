@@ -0,0 +1,475 @@
+/**
+ * Headless batch runner for the TNM067 processors.
+ *
+ * Runs the processor logic directly, without a processor network or an OpenGL context, on every
+ * input file given on the command line or found in a given directory:
+ *
+ *   tnm067batch upsample    --size 1024x1024 --method bilinear   -o out inputs...
+ *   tnm067batch colormap    --colors 000000,ff0000,ffffff        -o out inputs...
+ *   tnm067batch heightfield --height-scale 0.2 --mesh-format obj -o out inputs...
+ *   tnm067batch isosurface  --iso 0.01 --dims 256x256x256 --type float32 -o out inputs...
+ *   tnm067batch isosurface  --iso 0.01 --stream -o out huge.dat
+ *
+ * Images can be any format supported by the registered readers (e.g. png) or .raw together with
+ * --dims WxH and --type. Volumes can be .dat or .raw together with --dims WxHxD and --type. Images
+ * are written as png, meshes as ply (default) or obj. With --stream iso surfaces are written to the
+ * ply file while they are extracted, without ever holding the whole mesh in memory.
+ *
+ * Inputs are processed by --jobs worker threads. Each job reserves an estimate of its memory use
+ * from --memory-budget (MB) before it starts, a job larger than the whole budget runs alone.
+ *
+ * No build target is defined for this file, it has to be added as an executable linking the
+ * tnm067lab1, tnm067lab2, base and cimg modules.
+ */
+
+#include <modules/tnm067lab1/processors/imagemappingcpu.h>
+#include <modules/tnm067lab1/processors/imagetoheightfield.h>
+#include <modules/tnm067lab1/processors/imageupsampler.h>
+#include <modules/tnm067lab1/utils/scalartocolormapping.h>
+#include <modules/tnm067lab2/processors/marchingtetrahedra.h>
+#include <modules/tnm067lab2/utils/meshexport.h>
+
+#include <inviwo/core/common/coremodulesharedlibrary.h>
+#include <inviwo/core/common/inviwoapplication.h>
+#include <inviwo/core/datastructures/image/image.h>
+#include <inviwo/core/datastructures/image/layerram.h>
+#include <inviwo/core/datastructures/volume/volume.h>
+#include <inviwo/core/datastructures/volume/volumeram.h>
+#include <inviwo/core/io/datareaderfactory.h>
+#include <inviwo/core/io/datawriterfactory.h>
+#include <inviwo/core/util/consolelogger.h>
+#include <inviwo/core/util/logcentral.h>
+#include <inviwo/core/util/stringconversion.h>
+#include <modules/base/algorithm/dataminmax.h>
+#include <modules/base/basemodulesharedlibrary.h>
+#include <modules/cimg/cimgmodulesharedlibrary.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace inviwo {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+struct Options {
+    std::string command;
+    std::vector<fs::path> inputs;
+    fs::path outputDir = ".";
+    size_t jobs = std::max(1u, std::thread::hardware_concurrency());
+    size_t memoryBudget = size_t{4096} << 20;
+
+    std::string type = "float32";
+    size3_t dims{0};
+
+    size2_t size{0};
+    ImageUpsampler::IntepolationMethod method = ImageUpsampler::IntepolationMethod::Bilinear;
+    std::vector<vec4> colors{vec4(0.0f, 0.0f, 0.0f, 1.0f), vec4(1.0f)};
+    float heightScale = 1.0f;
+    std::string meshFormat = "ply";
+    std::optional<float> iso;
+    MarchingTetrahedra::Engine engine = MarchingTetrahedra::Engine::Tetrahedra;
+    bool stream = false;
+};
+
+void printUsage() {
+    std::cout
+        << "Usage: tnm067batch <upsample|colormap|heightfield|isosurface> [options] inputs...\n"
+           "  -o, --output <dir>        output directory (default .)\n"
+           "  --jobs <n>                number of inputs processed in parallel\n"
+           "  --memory-budget <MB>      memory budget of jobs in flight (default 4096)\n"
+           "  --dims <WxH|WxHxD>        dimensions of .raw inputs\n"
+           "  --type <uint8|uint16|float32|...>  data type of .raw inputs (default float32)\n"
+           "  --size <WxH>              upsample: output size\n"
+           "  --method <piecewiseconstant|bilinear|biquadratic|barycentric|bicubic|catmullrom|bspline>\n"
+           "  --colors <rrggbb,...>     colormap/heightfield: base colors\n"
+           "  --height-scale <f>        heightfield: height scale factor\n"
+           "  --iso <f>                 isosurface: iso value (default middle of value range)\n"
+           "  --engine <tetrahedra|cubes>  isosurface: extraction engine (default tetrahedra)\n"
+           "  --mesh-format <ply|obj>   heightfield/isosurface: mesh output format\n"
+           "  --stream                  isosurface: write the ply file while extracting\n";
+}
+
+std::vector<size_t> parseDims(const std::string& str) {
+    std::vector<size_t> dims;
+    for (const auto& part : splitString(toLower(str), 'x')) {
+        dims.push_back(std::stoull(part));
+    }
+    return dims;
+}
+
+vec4 parseColor(std::string str) {
+    if (!str.empty() && str.front() == '#') str.erase(0, 1);
+    if (str.size() != 6) throw Exception("Invalid color " + str, IVW_CONTEXT_CUSTOM("tnm067batch"));
+    const auto value = std::stoul(str, nullptr, 16);
+    return vec4((value >> 16) & 0xff, (value >> 8) & 0xff, value & 0xff, 255) / 255.0f;
+}
+
+ImageUpsampler::IntepolationMethod parseMethod(const std::string& str) {
+    using M = ImageUpsampler::IntepolationMethod;
+    const std::map<std::string, M> methods{{"piecewiseconstant", M::PiecewiseConstant},
+                                           {"bilinear", M::Bilinear},
+                                           {"biquadratic", M::Biquadratic},
+                                           {"barycentric", M::Barycentric},
+                                           {"bicubic", M::Bicubic},
+                                           {"catmullrom", M::CatmullRom},
+                                           {"bspline", M::BSpline}};
+    auto it = methods.find(toLower(str));
+    if (it == methods.end()) {
+        throw Exception("Unknown interpolation method " + str, IVW_CONTEXT_CUSTOM("tnm067batch"));
+    }
+    return it->second;
+}
+
+Options parseArguments(int argc, char** argv) {
+    if (argc < 2) throw Exception("Missing command", IVW_CONTEXT_CUSTOM("tnm067batch"));
+
+    Options opts;
+    opts.command = toLower(argv[1]);
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw Exception("Missing value for " + arg, IVW_CONTEXT_CUSTOM("tnm067batch"));
+            }
+            return argv[++i];
+        };
+
+        if (arg == "-o" || arg == "--output") {
+            opts.outputDir = value();
+        } else if (arg == "--jobs") {
+            opts.jobs = std::max<size_t>(1, std::stoull(value()));
+        } else if (arg == "--memory-budget") {
+            opts.memoryBudget = std::stoull(value()) << 20;
+        } else if (arg == "--dims") {
+            const auto dims = parseDims(value());
+            for (size_t d = 0; d < std::min<size_t>(3, dims.size()); ++d) opts.dims[d] = dims[d];
+            if (dims.size() == 2) opts.dims.z = 1;
+        } else if (arg == "--type") {
+            opts.type = toLower(value());
+        } else if (arg == "--size") {
+            const auto dims = parseDims(value());
+            if (dims.size() != 2) {
+                throw Exception("--size expects WxH", IVW_CONTEXT_CUSTOM("tnm067batch"));
+            }
+            opts.size = size2_t(dims[0], dims[1]);
+        } else if (arg == "--method") {
+            opts.method = parseMethod(value());
+        } else if (arg == "--colors") {
+            opts.colors.clear();
+            for (const auto& c : splitString(value(), ',')) opts.colors.push_back(parseColor(c));
+        } else if (arg == "--height-scale") {
+            opts.heightScale = std::stof(value());
+        } else if (arg == "--iso") {
+            opts.iso = std::stof(value());
+        } else if (arg == "--engine") {
+            const auto engine = toLower(value());
+            if (engine != "tetrahedra" && engine != "cubes") {
+                throw Exception("Unknown engine " + engine, IVW_CONTEXT_CUSTOM("tnm067batch"));
+            }
+            opts.engine = engine == "cubes" ? MarchingTetrahedra::Engine::Cubes
+                                            : MarchingTetrahedra::Engine::Tetrahedra;
+        } else if (arg == "--mesh-format") {
+            opts.meshFormat = toLower(value());
+        } else if (arg == "--stream") {
+            opts.stream = true;
+        } else if (!arg.empty() && arg.front() == '-') {
+            throw Exception("Unknown option " + arg, IVW_CONTEXT_CUSTOM("tnm067batch"));
+        } else if (fs::is_directory(arg)) {
+            for (const auto& entry : fs::directory_iterator(arg)) {
+                if (entry.is_regular_file()) opts.inputs.push_back(entry.path());
+            }
+        } else {
+            opts.inputs.push_back(arg);
+        }
+    }
+    if (opts.stream && opts.meshFormat != "ply") {
+        throw Exception("--stream only supports ply output", IVW_CONTEXT_CUSTOM("tnm067batch"));
+    }
+    std::sort(opts.inputs.begin(), opts.inputs.end());
+    return opts;
+}
+
+const DataFormatBase* rawFormat(const Options& opts) {
+    auto format = DataFormatBase::get(toUpper(opts.type));
+    if (!format) throw Exception("Unknown type " + opts.type, IVW_CONTEXT_CUSTOM("tnm067batch"));
+    return format;
+}
+
+void readRaw(const fs::path& path, void* dst, size_t bytes) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.read(static_cast<char*>(dst), static_cast<std::streamsize>(bytes))) {
+        throw FileException("Could not read " + std::to_string(bytes) + " bytes from " +
+                                path.string(),
+                            IVW_CONTEXT_CUSTOM("tnm067batch"));
+    }
+}
+
+std::string extension(const fs::path& path) {
+    auto ext = toLower(path.extension().string());
+    return ext.empty() ? ext : ext.substr(1);
+}
+
+std::shared_ptr<Image> loadImage(InviwoApplication& app, const fs::path& path,
+                                 const Options& opts) {
+    const auto ext = extension(path);
+    if (ext == "raw") {
+        const size2_t dims(opts.dims);
+        if (dims.x == 0 || dims.y == 0) {
+            throw Exception("--dims WxH is required for raw images", IVW_CONTEXT_CUSTOM("tnm067batch"));
+        }
+        const auto format = rawFormat(opts);
+        auto image = std::make_shared<Image>(dims, format);
+        auto ram = image->getColorLayer()->getEditableRepresentation<LayerRAM>();
+        readRaw(path, ram->getData(), dims.x * dims.y * format->getSize());
+        return image;
+    }
+
+    auto reader = app.getDataReaderFactory()->getReaderForTypeAndExtension<Layer>(ext);
+    if (!reader) {
+        throw Exception("No image reader for " + path.string(), IVW_CONTEXT_CUSTOM("tnm067batch"));
+    }
+    return std::make_shared<Image>(reader->readData(path.string()));
+}
+
+std::shared_ptr<Volume> loadVolume(InviwoApplication& app, const fs::path& path,
+                                   const Options& opts) {
+    const auto ext = extension(path);
+    if (ext == "raw") {
+        if (glm::compMul(opts.dims) == 0) {
+            throw Exception("--dims WxHxD is required for raw volumes",
+                            IVW_CONTEXT_CUSTOM("tnm067batch"));
+        }
+        const auto format = rawFormat(opts);
+        auto volume = std::make_shared<Volume>(opts.dims, format);
+        auto ram = volume->getEditableRepresentation<VolumeRAM>();
+        readRaw(path, ram->getData(), glm::compMul(opts.dims) * format->getSize());
+        const auto minMax = util::volumeMinMax(ram);
+        volume->dataMap_.dataRange = volume->dataMap_.valueRange =
+            dvec2(minMax.first.x, minMax.second.x);
+        return volume;
+    }
+
+    auto reader = app.getDataReaderFactory()->getReaderForTypeAndExtension<Volume>(ext);
+    if (!reader) {
+        throw Exception("No volume reader for " + path.string(), IVW_CONTEXT_CUSTOM("tnm067batch"));
+    }
+    return reader->readData(path.string());
+}
+
+void saveImage(InviwoApplication& app, const Image& image, const fs::path& path) {
+    auto writer = app.getDataWriterFactory()->getWriterForTypeAndExtension<Layer>("png");
+    if (!writer) throw Exception("No png writer available", IVW_CONTEXT_CUSTOM("tnm067batch"));
+    fs::remove(path);
+    writer->writeData(image.getColorLayer(), path.string());
+}
+
+void saveMesh(const Mesh& mesh, const fs::path& path, const std::string& format) {
+    if (format == "obj") {
+        TNM067::writeOBJ(mesh, path.string());
+    } else {
+        TNM067::writePLY(mesh, path.string());
+    }
+}
+
+ScalarToColorMapping colorMap(const Options& opts) {
+    ScalarToColorMapping map;
+    for (const auto& c : opts.colors) map.addBaseColors(c);
+    return map;
+}
+
+/**
+ * Estimated peak memory of processing one input, used to keep the jobs in flight within the
+ * memory budget. Compressed images are assumed to expand four times when decoded.
+ */
+size_t estimateMemory(const fs::path& path, const Options& opts) {
+    const size_t fileSize = static_cast<size_t>(fs::file_size(path));
+    const size_t inputSize = extension(path) == "raw" ? fileSize : 4 * fileSize;
+
+    if (opts.command == "upsample") {
+        const size_t outPixels = opts.size.x * opts.size.y;
+        return inputSize + outPixels * 16;
+    } else if (opts.command == "colormap") {
+        return 2 * inputSize;
+    } else if (opts.command == "heightfield") {
+        // 24 vertices and indices per pixel, held both in a vector and in the mesh buffers
+        return inputSize + inputSize * 2 * 24 *
+                               (sizeof(ImageToHeightfield::HFMesh::Vertex) + sizeof(std::uint32_t));
+    } else if (opts.stream) {
+        // Only a window of two voxel slices of vertices is held besides the volume
+        return inputSize;
+    } else {
+        return 3 * inputSize;
+    }
+}
+
+/**
+ * Counting semaphore over bytes. A request larger than the whole budget is granted when nothing
+ * else is in flight so it can still run, alone.
+ */
+class MemoryBudget {
+public:
+    explicit MemoryBudget(size_t budget) : budget_(budget) {}
+
+    void acquire(size_t bytes) {
+        std::unique_lock lock{mutex_};
+        cv_.wait(lock, [&]() { return used_ == 0 || used_ + bytes <= budget_; });
+        used_ += bytes;
+    }
+    void release(size_t bytes) {
+        {
+            std::scoped_lock lock{mutex_};
+            used_ -= bytes;
+        }
+        cv_.notify_all();
+    }
+
+private:
+    size_t budget_;
+    size_t used_ = 0;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+void processInput(InviwoApplication& app, const fs::path& path, const Options& opts) {
+    const auto stem = path.stem().string();
+    if (opts.command == "upsample") {
+        auto image = loadImage(app, path, opts);
+        const size2_t size = opts.size == size2_t(0) ? image->getDimensions() * size_t(2) : opts.size;
+        auto result = ImageUpsampler::upsample(*image, size, opts.method);
+        saveImage(app, *result, opts.outputDir / (stem + "_upsampled.png"));
+    } else if (opts.command == "colormap") {
+        auto image = loadImage(app, path, opts);
+        auto result = ImageMappingCPU::mapImage(*image, colorMap(opts));
+        saveImage(app, *result, opts.outputDir / (stem + "_colormapped.png"));
+    } else if (opts.command == "heightfield") {
+        auto image = loadImage(app, path, opts);
+        auto layer = image->getColorLayer()->getRepresentation<LayerRAM>();
+        auto mesh = ImageToHeightfield::buildMesh(*layer, colorMap(opts), opts.heightScale);
+        saveMesh(*mesh, opts.outputDir / (stem + "_heightfield." + opts.meshFormat),
+                 opts.meshFormat);
+    } else if (opts.command == "isosurface") {
+        auto volume = loadVolume(app, path, opts);
+        const auto range = volume->dataMap_.valueRange;
+        const float iso = opts.iso.value_or(static_cast<float>(0.5 * (range.x + range.y)));
+        if (opts.stream) {
+            const auto output = opts.outputDir / (stem + "_isosurface.ply");
+            MarchingTetrahedra::extractToPLY(volume, iso, output.string(), opts.engine);
+            return;
+        }
+        auto mesh = MarchingTetrahedra::extract(volume, iso, opts.engine);
+        saveMesh(*mesh, opts.outputDir / (stem + "_isosurface." + opts.meshFormat),
+                 opts.meshFormat);
+    } else {
+        throw Exception("Unknown command " + opts.command, IVW_CONTEXT_CUSTOM("tnm067batch"));
+    }
+}
+
+}  // namespace
+
+}  // namespace inviwo
+
+int main(int argc, char** argv) {
+    using namespace inviwo;
+    using Clock = std::chrono::steady_clock;
+
+    LogCentral::init();
+    auto logger = std::make_shared<ConsoleLogger>();
+    LogCentral::getPtr()->setVerbosity(LogVerbosity::Warn);
+    LogCentral::getPtr()->registerLogger(logger);
+
+    Options opts;
+    try {
+        opts = parseArguments(argc, argv);
+    } catch (const Exception& e) {
+        std::cerr << e.getMessage() << "\n";
+        printUsage();
+        return 1;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        printUsage();
+        return 1;
+    }
+    if (opts.inputs.empty()) {
+        printUsage();
+        return 1;
+    }
+    fs::create_directories(opts.outputDir);
+
+    // The app is only created for its thread pool and data readers and writers, argv is not
+    // forwarded since the batch options are not Inviwo options
+    char* appArgv[] = {argv[0]};
+    InviwoApplication app(1, appArgv, "TNM067-Batch");
+    {
+        std::vector<std::unique_ptr<InviwoModuleFactoryObject>> modules;
+        modules.emplace_back(createInviwoCore());
+        modules.emplace_back(createBaseModule());
+        modules.emplace_back(createCImgModule());
+        app.registerModules(std::move(modules));
+    }
+
+    MemoryBudget budget(opts.memoryBudget);
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> failed{0};
+    std::atomic<size_t> bytesRead{0};
+    std::mutex outputMutex;
+
+    const auto start = Clock::now();
+    auto worker = [&]() {
+        for (size_t i = next++; i < opts.inputs.size(); i = next++) {
+            const auto& path = opts.inputs[i];
+            const auto jobStart = Clock::now();
+            std::string error;
+            size_t bytes = 0;
+            try {
+                bytes = estimateMemory(path, opts);
+                budget.acquire(bytes);
+                try {
+                    processInput(app, path, opts);
+                } catch (...) {
+                    budget.release(bytes);
+                    throw;
+                }
+                budget.release(bytes);
+                bytesRead += static_cast<size_t>(fs::file_size(path));
+            } catch (const Exception& e) {
+                error = e.getMessage();
+            } catch (const std::exception& e) {
+                error = e.what();
+            }
+
+            const auto ms = std::chrono::duration<double, std::milli>(Clock::now() - jobStart);
+            std::scoped_lock lock{outputMutex};
+            if (error.empty()) {
+                std::cout << path.string() << ": " << ms.count() << " ms\n";
+            } else {
+                ++failed;
+                std::cerr << path.string() << ": failed, " << error << "\n";
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < std::min(opts.jobs, opts.inputs.size()); ++i) {
+        workers.emplace_back(worker);
+    }
+    for (auto& w : workers) w.join();
+
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    const size_t done = opts.inputs.size() - failed;
+    std::cout << done << " of " << opts.inputs.size() << " inputs in " << seconds << " s, "
+              << done / seconds << " inputs/s, " << (bytesRead / double(1 << 20)) / seconds
+              << " MB/s read\n";
+
+    return failed == 0 ? 0 : 1;
+}
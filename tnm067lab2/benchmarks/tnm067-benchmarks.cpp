@@ -0,0 +1,367 @@
+/**
+ * Benchmarks for the TNM067 processors using Google Benchmark.
+ *
+ * All inputs are synthetic and generated from fixed seeds so results are comparable between
+ * revisions. Results are written as JSON to stdout unless another --benchmark_format is given, use
+ * --benchmark_out=<file> to also write them to a file.
+ *
+ * No build target is defined for this file, it has to be added as an executable linking the
+ * tnm067lab1 and tnm067lab2 modules and benchmark::benchmark.
+ */
+
+#include <modules/tnm067lab1/processors/imagemappingcpu.h>
+#include <modules/tnm067lab1/processors/imagetoheightfield.h>
+#include <modules/tnm067lab1/processors/imageupsampler.h>
+#include <modules/tnm067lab1/utils/scalartocolormapping.h>
+#include <modules/tnm067lab2/processors/hydrogengenerator.h>
+#include <modules/tnm067lab2/processors/marchingsquares.h>
+#include <modules/tnm067lab2/processors/marchingtetrahedra.h>
+#include <modules/tnm067lab2/processors/volumeraycastercpu.h>
+#include <modules/tnm067lab2/processors/volumeresampler.h>
+#include <modules/tnm067lab2/utils/brickedvolume.h>
+#include <modules/tnm067lab2/utils/quadricdecimation.h>
+
+#include <inviwo/core/common/coremodulesharedlibrary.h>
+#include <inviwo/core/common/inviwoapplication.h>
+#include <inviwo/core/datastructures/camera/perspectivecamera.h>
+#include <inviwo/core/datastructures/image/image.h>
+#include <inviwo/core/datastructures/image/layerramprecision.h>
+#include <inviwo/core/datastructures/volume/volume.h>
+#include <inviwo/core/util/consolelogger.h>
+#include <inviwo/core/util/logcentral.h>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <map>
+
+namespace inviwo {
+
+namespace {
+
+constexpr std::uint32_t seed = 67;
+
+std::uint32_t hash(std::uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+/**
+ * Smooth gradient with some noise on top, values in [0 1]. Gives the interpolation and mapping
+ * code a mix of flat and varying regions.
+ */
+double syntheticValue(size2_t pos, size2_t dims) {
+    const dvec2 p = dvec2(pos) / dvec2(glm::max(dims, size2_t(2)) - size2_t(1));
+    const double noise =
+        (hash(static_cast<std::uint32_t>(pos.x + pos.y * dims.x) ^ seed) >> 8) / 16777216.0;
+    return glm::clamp(0.4 * p.x + 0.4 * p.y + 0.2 * noise, 0.0, 1.0);
+}
+
+std::shared_ptr<Image> syntheticImage(size2_t dims, const DataFormatBase* format) {
+    auto image = std::make_shared<Image>(dims, format);
+    image->getColorLayer()
+        ->getEditableRepresentation<LayerRAM>()
+        ->dispatch<void, dispatching::filter::Scalars>([&](auto rep) {
+            using T = util::PrecisionValueType<decltype(rep)>;
+            T* data = rep->getDataTyped();
+            for (size_t y = 0; y < dims.y; ++y) {
+                for (size_t x = 0; x < dims.x; ++x) {
+                    const double v = syntheticValue({x, y}, dims);
+                    if constexpr (std::is_floating_point_v<T>) {
+                        data[x + y * dims.x] = static_cast<T>(v);
+                    } else {
+                        data[x + y * dims.x] =
+                            static_cast<T>(v * static_cast<double>(std::numeric_limits<T>::max()));
+                    }
+                }
+            }
+        });
+    return image;
+}
+
+ScalarToColorMapping syntheticColorMap() {
+    ScalarToColorMapping map;
+    map.addBaseColors(vec4(0.0f, 0.0f, 0.5f, 1.0f));
+    map.addBaseColors(vec4(0.0f, 1.0f, 1.0f, 1.0f));
+    map.addBaseColors(vec4(1.0f, 1.0f, 0.0f, 1.0f));
+    map.addBaseColors(vec4(0.5f, 0.0f, 0.0f, 1.0f));
+    return map;
+}
+
+const std::vector<const DataFormatBase*>& imageFormats() {
+    static const std::vector<const DataFormatBase*> formats{
+        DataUInt8::get(), DataUInt16::get(), DataFloat32::get(), DataFloat64::get()};
+    return formats;
+}
+
+std::shared_ptr<const Volume> hydrogenVolume(
+    size_t size, HydrogenGenerator::OutputFormat format = HydrogenGenerator::OutputFormat::Float32) {
+    static std::map<std::pair<size_t, HydrogenGenerator::OutputFormat>,
+                    std::shared_ptr<const Volume>>
+        cache;
+    auto& vol = cache[{size, format}];
+    if (!vol) vol = HydrogenGenerator::generate(size, format);
+    return vol;
+}
+
+}  // namespace
+
+void ImageUpsamplerBenchmark(benchmark::State& state) {
+    const auto method = static_cast<ImageUpsampler::IntepolationMethod>(state.range(0));
+    const size_t scale = static_cast<size_t>(state.range(1));
+    const auto input = syntheticImage(size2_t(256), DataUInt8::get());
+    const size2_t outputSize = input->getDimensions() * scale;
+
+    for (auto _ : state) {
+        auto output = ImageUpsampler::upsample(*input, outputSize, method);
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetItemsProcessed(state.iterations() * outputSize.x * outputSize.y);
+}
+BENCHMARK(ImageUpsamplerBenchmark)
+    ->ArgNames({"method", "scale"})
+    ->ArgsProduct({{0, 1, 2, 3, 4, 5, 6}, {2, 4, 8}})
+    ->Unit(benchmark::kMillisecond);
+
+void ImageMappingCPUBenchmark(benchmark::State& state) {
+    const auto format = imageFormats()[static_cast<size_t>(state.range(0))];
+    const auto input = syntheticImage(size2_t(2048), format);
+    const auto map = syntheticColorMap();
+    state.SetLabel(format->getString());
+
+    for (auto _ : state) {
+        auto output = ImageMappingCPU::mapImage(*input, map);
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetItemsProcessed(state.iterations() * 2048 * 2048);
+}
+BENCHMARK(ImageMappingCPUBenchmark)
+    ->ArgName("format")
+    ->DenseRange(0, 3)
+    ->Unit(benchmark::kMillisecond);
+
+void ImageToHeightfieldBenchmark(benchmark::State& state) {
+    const size_t size = static_cast<size_t>(state.range(0));
+    const auto input = syntheticImage(size2_t(size), DataFloat32::get());
+    const auto layer = input->getColorLayer()->getRepresentation<LayerRAM>();
+    const auto map = syntheticColorMap();
+
+    for (auto _ : state) {
+        auto mesh = ImageToHeightfield::buildMesh(*layer, map, 0.5f);
+        benchmark::DoNotOptimize(mesh);
+    }
+    state.SetItemsProcessed(state.iterations() * size * size);
+}
+BENCHMARK(ImageToHeightfieldBenchmark)
+    ->ArgName("size")
+    ->RangeMultiplier(2)
+    ->Range(64, 512)
+    ->Unit(benchmark::kMillisecond);
+
+void MarchingSquaresBenchmark(benchmark::State& state) {
+    const size_t size = static_cast<size_t>(state.range(0));
+    const size_t levels = static_cast<size_t>(state.range(1));
+    const auto input = syntheticImage(size2_t(size), DataFloat32::get());
+    const auto layer = input->getColorLayer()->getRepresentation<LayerRAM>();
+    const auto map = syntheticColorMap();
+    // Pooled like in the processor, so repeated runs do not allocate
+    TNM067::BufferPool pool;
+
+    size_t indices = 0;
+    for (auto _ : state) {
+        auto mesh = MarchingSquares::extract(*layer, levels, map, nullptr, &pool);
+        indices = mesh->getIndices(0)->getSize();
+        benchmark::DoNotOptimize(mesh);
+    }
+    state.counters["indices"] = static_cast<double>(indices);
+    state.SetItemsProcessed(state.iterations() * size * size);
+}
+BENCHMARK(MarchingSquaresBenchmark)
+    ->ArgNames({"size", "levels"})
+    ->ArgsProduct({{1024, 4096, 7680}, {1, 16}})
+    ->Unit(benchmark::kMillisecond);
+
+void HydrogenGeneratorBenchmark(benchmark::State& state) {
+    const size_t size = static_cast<size_t>(state.range(0));
+    const auto format = static_cast<HydrogenGenerator::OutputFormat>(state.range(1));
+
+    for (auto _ : state) {
+        auto volume = HydrogenGenerator::generate(size, format);
+        benchmark::DoNotOptimize(volume);
+    }
+    state.SetItemsProcessed(state.iterations() * size * size * size);
+}
+BENCHMARK(HydrogenGeneratorBenchmark)
+    ->ArgNames({"size", "format"})
+    ->ArgsProduct({{64, 128, 256, 512}, {0, 1, 2, 3}})
+    ->Unit(benchmark::kMillisecond);
+
+void VolumeResamplerBenchmark(benchmark::State& state) {
+    const auto kernel = static_cast<TNM067::InterpolationKernel>(state.range(0));
+    const size_t size = static_cast<size_t>(state.range(1));
+    const auto volume = hydrogenVolume(128);
+
+    for (auto _ : state) {
+        auto output = VolumeResampler::resample(*volume, size3_t(size), kernel);
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetItemsProcessed(state.iterations() * size * size * size);
+}
+BENCHMARK(VolumeResamplerBenchmark)
+    ->ArgNames({"kernel", "size"})
+    ->ArgsProduct({{0, 1, 2}, {64, 256, 512}})
+    ->Unit(benchmark::kMillisecond);
+
+void VolumeRaycasterCPUBenchmark(benchmark::State& state) {
+    const size_t size = static_cast<size_t>(state.range(0));
+    const bool skipEmptySpace = state.range(1) != 0;
+    const auto prepared = VolumeRaycasterCPU::prepare(*hydrogenVolume(128));
+    const PerspectiveCamera camera(vec3(0.5f, 0.5f, 2.5f), vec3(0.5f), vec3(0.0f, 1.0f, 0.0f),
+                                   0.1f, 10.0f, 38.0f, 1.0f);
+    // Most of the volume is close to zero, which the transparent first color makes empty space
+    ScalarToColorMapping map;
+    map.addBaseColors(vec4(0.0f));
+    map.addBaseColors(vec4(1.0f, 0.5f, 0.0f, 0.05f));
+    map.addBaseColors(vec4(1.0f, 1.0f, 1.0f, 0.5f));
+
+    for (auto _ : state) {
+        auto image = VolumeRaycasterCPU::render(*prepared, camera, map, size2_t(size), 2.0f,
+                                                skipEmptySpace);
+        benchmark::DoNotOptimize(image);
+    }
+    state.SetItemsProcessed(state.iterations() * size * size);
+}
+BENCHMARK(VolumeRaycasterCPUBenchmark)
+    ->ArgNames({"size", "skip"})
+    ->ArgsProduct({{256, 512, 1024}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+void MarchingTetrahedraBenchmark(benchmark::State& state) {
+    const size_t size = static_cast<size_t>(state.range(0));
+    const auto engine = static_cast<MarchingTetrahedra::Engine>(state.range(1));
+    const auto format = static_cast<HydrogenGenerator::OutputFormat>(state.range(2));
+    const auto volume = hydrogenVolume(size, format);
+    const auto range = volume->dataMap_.valueRange;
+    // A low iso value gives the largest of the hydrogen lobes
+    const float iso = static_cast<float>(range.x + 0.05 * (range.y - range.x));
+
+    size_t triangles = 0;
+    for (auto _ : state) {
+        auto mesh = MarchingTetrahedra::extract(volume, iso, engine);
+        triangles = mesh->getIndices(0)->getSize() / 3;
+        benchmark::DoNotOptimize(mesh);
+    }
+    state.counters["triangles"] = static_cast<double>(triangles);
+    state.SetItemsProcessed(state.iterations() * (size - 1) * (size - 1) * (size - 1));
+}
+BENCHMARK(MarchingTetrahedraBenchmark)
+    ->ArgNames({"size", "engine", "format"})
+    ->ArgsProduct({{64, 128, 256, 512}, {0, 1}, {0, 1, 2, 3}})
+    ->Unit(benchmark::kMillisecond);
+
+void MarchingTetrahedraBrickedBenchmark(benchmark::State& state) {
+    const size_t size = static_cast<size_t>(state.range(0));
+    const size_t brickSize = static_cast<size_t>(state.range(1));
+    const auto volume = hydrogenVolume(size);
+    const auto bricks = TNM067::BrickedVolume::fromVolume(*volume, brickSize);
+    const auto range = volume->dataMap_.valueRange;
+    const float iso = static_cast<float>(range.x + 0.05 * (range.y - range.x));
+
+    size_t triangles = 0;
+    for (auto _ : state) {
+        auto mesh = MarchingTetrahedra::extract(bricks, iso);
+        triangles = mesh->getIndices(0)->getSize() / 3;
+        benchmark::DoNotOptimize(mesh);
+    }
+    state.counters["triangles"] = static_cast<double>(triangles);
+    state.counters["constantBricks"] = static_cast<double>(bricks.getConstantBrickCount());
+    state.SetItemsProcessed(state.iterations() * (size - 1) * (size - 1) * (size - 1));
+}
+BENCHMARK(MarchingTetrahedraBrickedBenchmark)
+    ->ArgNames({"size", "brick"})
+    ->ArgsProduct({{64, 128, 256, 512}, {8, 16}})
+    ->Unit(benchmark::kMillisecond);
+
+void MarchingTetrahedraAdaptiveBenchmark(benchmark::State& state) {
+    const size_t size = static_cast<size_t>(state.range(0));
+    const auto volume = hydrogenVolume(size);
+    const auto range = volume->dataMap_.valueRange;
+    const float iso = static_cast<float>(range.x + 0.05 * (range.y - range.x));
+    // Max error in thousandths of the value range
+    const float maxError = static_cast<float>(state.range(1) * 0.001 * (range.y - range.x));
+
+    size_t triangles = 0;
+    for (auto _ : state) {
+        auto mesh = MarchingTetrahedra::extractAdaptive(volume, iso, maxError);
+        triangles = mesh->getIndices(0)->getSize() / 3;
+        benchmark::DoNotOptimize(mesh);
+    }
+    state.counters["triangles"] = static_cast<double>(triangles);
+    state.SetItemsProcessed(state.iterations() * (size - 1) * (size - 1) * (size - 1));
+}
+BENCHMARK(MarchingTetrahedraAdaptiveBenchmark)
+    ->ArgNames({"size", "error"})
+    ->ArgsProduct({{64, 128, 256, 512}, {0, 5, 20}})
+    ->Unit(benchmark::kMillisecond);
+
+void MeshDecimationBenchmark(benchmark::State& state) {
+    const size_t size = static_cast<size_t>(state.range(0));
+    const auto volume = hydrogenVolume(size);
+    const auto range = volume->dataMap_.valueRange;
+    const float iso = static_cast<float>(range.x + 0.05 * (range.y - range.x));
+    const auto mesh = MarchingTetrahedra::extract(volume, iso);
+    const size_t inputTriangles = mesh->getIndices(0)->getSize() / 3;
+
+    TNM067::DecimationStats stats;
+    for (auto _ : state) {
+        auto decimated = TNM067::decimate(*mesh, inputTriangles / 10,
+                                          std::numeric_limits<double>::infinity(), &stats);
+        benchmark::DoNotOptimize(decimated);
+    }
+    state.counters["triangles"] = static_cast<double>(stats.outputTriangles);
+    state.counters["maxError"] = stats.maxError;
+    state.counters["lockedVertices"] = static_cast<double>(stats.lockedVertices);
+    state.SetItemsProcessed(state.iterations() * inputTriangles);
+}
+BENCHMARK(MeshDecimationBenchmark)->ArgName("size")->Arg(64)->Arg(128)->Unit(benchmark::kMillisecond);
+
+}  // namespace inviwo
+
+int main(int argc, char** argv) {
+    using namespace inviwo;
+
+    LogCentral::init();
+    auto logger = std::make_shared<ConsoleLogger>();
+    LogCentral::getPtr()->setVerbosity(LogVerbosity::Error);
+    LogCentral::getPtr()->registerLogger(logger);
+
+    InviwoApplication app(argc, argv, "TNM067-Benchmarks");
+    {
+        std::vector<std::unique_ptr<InviwoModuleFactoryObject>> modules;
+        modules.emplace_back(createInviwoCore());
+        app.registerModules(std::move(modules));
+    }
+
+    // Default to JSON output so results can be stored and compared between revisions
+    std::vector<char*> args(argv, argv + argc);
+    std::string jsonFormat = "--benchmark_format=json";
+    if (std::none_of(args.begin(), args.end(), [](const char* arg) {
+            return std::strncmp(arg, "--benchmark_format", 18) == 0;
+        })) {
+        args.push_back(jsonFormat.data());
+    }
+    int numArgs = static_cast<int>(args.size());
+
+    benchmark::Initialize(&numArgs, args.data());
+    if (benchmark::ReportUnrecognizedArguments(numArgs, args.data())) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <modules/tnm067lab2/processors/brickedvolumesource.h>
+#include <inviwo/core/util/filesystem.h>
+
+namespace inviwo {
+
+const ProcessorInfo BrickedVolumeSource::processorInfo_{
+    "org.inviwo.BrickedVolumeSource",  // Class identifier
+    "Bricked Volume Source",           // Display name
+    "TNM067",                          // Category
+    CodeState::Experimental,           // Code state
+    Tags::CPU,                         // Tags
+};
+const ProcessorInfo BrickedVolumeSource::getProcessorInfo() const { return processorInfo_; }
+
+BrickedVolumeSource::BrickedVolumeSource()
+    : Processor()
+    , outport_("bricks")
+    , file_("file", "Raw File", "", "volume")
+    , dims_("dims", "Dimensions", size3_t(64), size3_t(2), size3_t(8192))
+    , format_("format", "Data Format",
+              {{"uint8", "UInt8", DataFormatId::UInt8},
+               {"uint16", "UInt16", DataFormatId::UInt16},
+               {"int16", "Int16", DataFormatId::Int16},
+               {"float32", "Float32", DataFormatId::Float32},
+               {"float64", "Float64", DataFormatId::Float64}},
+              3)
+    , brickSize_("brickSize", "Brick Size", {{"8", "8^3", 8}, {"16", "16^3", 16}}, 1)
+    , quantization_("quantization", "Quantization",
+                    {{"none", "None (Float)", TNM067::BrickedVolume::Quantization::None},
+                     {"uint16", "16 bit", TNM067::BrickedVolume::Quantization::UInt16},
+                     {"uint8", "8 bit", TNM067::BrickedVolume::Quantization::UInt8}},
+                    0)
+    , info_("info", "Info", "")
+    , profiling_("profiling", "Profiling") {
+    addPort(outport_);
+
+    file_.addNameFilter("Raw (*.raw)", "*.raw");
+    info_.setReadOnly(true);
+    info_.setSerializationMode(PropertySerializationMode::None);
+
+    addProperty(file_);
+    addProperty(dims_);
+    addProperty(format_);
+    addProperty(brickSize_);
+    addProperty(quantization_);
+    addProperty(info_);
+    addProperty(profiling_);
+}
+
+void BrickedVolumeSource::process() {
+    if (file_.get().empty() || !filesystem::fileExists(file_.get())) {
+        outport_.clear();
+        return;
+    }
+
+    auto profile = profiling_.begin();
+    auto bricks = std::make_shared<TNM067::BrickedVolume>([&]() {
+        TNM067_PROFILE_SCOPE(profile, "Brick compression");
+        return TNM067::BrickedVolume::fromRawFile(file_.get(), dims_.get(),
+                                                  DataFormatBase::get(format_.get()),
+                                                  brickSize_.get(), quantization_.get());
+    }());
+    profiling_.end();
+
+    const auto count = bricks->getBrickCount();
+    const size_t rawBytes = glm::compMul(dims_.get()) * sizeof(float);
+    info_.set(std::to_string(glm::compMul(count)) + " bricks, " +
+              std::to_string(bricks->getConstantBrickCount()) + " constant, " +
+              std::to_string(bricks->getSizeInBytes() / 1024) + " kB (" +
+              std::to_string(100 * bricks->getSizeInBytes() / std::max<size_t>(rawBytes, 1)) +
+              "% of float32)");
+
+    outport_.setData(bricks);
+}
+
+}  // namespace inviwo
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <inviwo/core/processors/processor.h>
+#include <inviwo/core/properties/ordinalproperty.h>
+#include <inviwo/core/properties/optionproperty.h>
+#include <inviwo/core/properties/fileproperty.h>
+#include <inviwo/core/properties/stringproperty.h>
+#include <inviwo/core/ports/dataoutport.h>
+#include <modules/tnm067lab2/utils/brickedvolume.h>
+#include <modules/tnm067lab1/properties/profilingproperty.h>
+
+namespace inviwo {
+
+/**
+ * \class BrickedVolumeSource
+ * \brief Reads a raw volume file into a brick-compressed volume.
+ * The file is streamed one layer of bricks at a time, so volumes that do not fit in memory
+ * uncompressed can be loaded as long as the compressed bricks do.
+ */
+class IVW_MODULE_TNM067LAB2_API BrickedVolumeSource : public Processor {
+public:
+    BrickedVolumeSource();
+    virtual ~BrickedVolumeSource() = default;
+
+    virtual void process() override;
+
+    virtual const ProcessorInfo getProcessorInfo() const override;
+    static const ProcessorInfo processorInfo_;
+
+private:
+    DataOutport<TNM067::BrickedVolume> outport_;
+
+    FileProperty file_;
+    IntSize3Property dims_;
+    TemplateOptionProperty<DataFormatId> format_;
+    TemplateOptionProperty<size_t> brickSize_;
+    TemplateOptionProperty<TNM067::BrickedVolume::Quantization> quantization_;
+    StringProperty info_;
+    ProfilingProperty profiling_;
+};
+
+}  // namespace inviwo
@@ -1,11 +1,14 @@
 #include <modules/tnm067lab2/processors/hydrogengenerator.h>
 #include <inviwo/core/datastructures/volume/volume.h>
-#include <inviwo/core/util/volumeramutils.h>
 #include <modules/base/algorithm/dataminmax.h>
 #include <inviwo/core/util/indexmapper.h>
 #include <inviwo/core/datastructures/volume/volumeram.h>
+#include <inviwo/core/datastructures/volume/volumeramprecision.h>
 #include <modules/base/algorithm/dataminmax.h>
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <type_traits>
 
 namespace inviwo {
 
@@ -20,27 +23,124 @@ const ProcessorInfo HydrogenGenerator::processorInfo_{
 const ProcessorInfo HydrogenGenerator::getProcessorInfo() const { return processorInfo_; }
 
 HydrogenGenerator::HydrogenGenerator()
-    : Processor(), volume_("volume"), size_("size_", "Volume Size", 16, 4, 256) {
+    : PoolProcessor(pool::Option::KeepOldResults | pool::Option::DelayDispatch)
+    , volume_("volume")
+    , size_("size_", "Volume Size", 16, 4, 256)
+    , format_("format", "Format",
+              {{"float32", "Float32", OutputFormat::Float32},
+               {"float16", "Float16", OutputFormat::Float16},
+               {"uint16", "UInt16", OutputFormat::UInt16},
+               {"uint8", "UInt8", OutputFormat::UInt8}})
+    , background_("background", "Run in Background", true)
+    , profiling_("profiling", "Profiling") {
     addPort(volume_);
     addProperty(size_);
+    addProperty(format_);
+    addProperty(background_);
+    addProperty(profiling_);
 }
 
 void HydrogenGenerator::process() {
-    auto vol = std::make_shared<Volume>(size3_t(size_), DataFloat32::get());
+    const auto generation = ++generation_;
+    if (!background_) {
+        auto profile = profiling_.begin();
+        volume_.setData(generate(size_, format_, profile));
+        profiling_.end();
+        return;
+    }
 
-    auto ram = vol->getEditableRepresentation<VolumeRAM>();
-    auto data = static_cast<float*>(ram->getData());
-    util::IndexMapper3D index(ram->getDimensions());
-
-    util::forEachVoxel(*ram, [&](const size3_t& pos) {
-        vec3 cartesian = idTOCartesian(pos);
-        data[index(pos)] = static_cast<float>(eval(cartesian));
+    auto job = [size = size_.get(), format = format_.get()](pool::Stop stop,
+                                                            pool::Progress progress) {
+        const auto profile = ProfilingProperty::beginJob();
+        const TNM067::JobControl control{[stop]() { return stop(); },
+                                         [progress](float done) { progress(done); }};
+        auto volume = generate(size, format, profile.get(), &control);
+        if (profile) profile->end();
+        return std::make_pair(volume, profile);
+    };
+    dispatchOne(job, [this, generation](auto result) {
+        if (!result.first || generation != generation_) return;
+        if (result.second) profiling_.report(*result.second);
+        volume_.setData(result.first);
+        newResults();
     });
+}
+
+namespace {
+
+/**
+ * Writes the density of every voxel of a size^3 volume to data. Integer types are quantized over
+ * [0, HydrogenGenerator::maxDensity()] to their full range. Returns false if control is stopped.
+ */
+template <typename T>
+bool evaluate(T* data, size_t size, const TNM067::JobControl* control) {
+    double typeMax = 0.0;
+    if constexpr (std::is_integral_v<T>) typeMax = std::numeric_limits<T>::max();
+    const double scale = typeMax / HydrogenGenerator::maxDensity();
+    util::IndexMapper3D index(size3_t(size));
+
+    size3_t pos{};
+    for (pos.z = 0; pos.z < size; ++pos.z) {
+        if (control && control->stopped()) return false;
+        for (pos.y = 0; pos.y < size; ++pos.y) {
+            for (pos.x = 0; pos.x < size; ++pos.x) {
+                const double density =
+                    HydrogenGenerator::eval(HydrogenGenerator::idTOCartesian(pos, size));
+                if constexpr (std::is_integral_v<T>) {
+                    data[index(pos)] = static_cast<T>(std::min(density * scale + 0.5, typeMax));
+                } else {
+                    data[index(pos)] = static_cast<T>(static_cast<float>(density));
+                }
+            }
+        }
+        if (control) control->progress(pos.z + 1, size);
+    }
+    return true;
+}
 
-    auto minMax = util::volumeMinMax(ram);
-    vol->dataMap_.dataRange = vol->dataMap_.valueRange = dvec2(minMax.first.x, minMax.second.x);
+}  // namespace
 
-    volume_.setData(vol);
+std::shared_ptr<Volume> HydrogenGenerator::generate(size_t size, OutputFormat format,
+                                                    TNM067::Profile* profile,
+                                                    const TNM067::JobControl* control) {
+    TNM067_PROFILE_SCOPE(profile, "Generate");
+    auto create = [&](auto dataFormat, auto* tag) -> std::shared_ptr<Volume> {
+        using T = std::remove_pointer_t<decltype(tag)>;
+        auto vol = std::make_shared<Volume>(size3_t(size), dataFormat);
+        auto ram =
+            static_cast<VolumeRAMPrecision<T>*>(vol->getEditableRepresentation<VolumeRAM>());
+
+        {
+            TNM067_PROFILE_SCOPE(profile, "Evaluate");
+            if (!evaluate(ram->getDataTyped(), size, control)) return nullptr;
+            TNM067_PROFILE_COUNT(profile, VoxelsProcessed, size * size * size);
+        }
+
+        // The range of the density is only known once every voxel is evaluated, so the integer
+        // formats are quantized against its bound instead
+        if constexpr (std::is_integral_v<T>) {
+            vol->dataMap_.dataRange = dvec2(0.0, std::numeric_limits<T>::max());
+            vol->dataMap_.valueRange = dvec2(0.0, maxDensity());
+        } else {
+            TNM067_PROFILE_SCOPE(profile, "Min/max");
+            auto minMax = util::volumeMinMax(ram);
+            vol->dataMap_.dataRange = vol->dataMap_.valueRange =
+                dvec2(minMax.first.x, minMax.second.x);
+        }
+        return vol;
+    };
+
+    switch (format) {
+        case OutputFormat::Float16:
+            return create(DataFloat16::get(), static_cast<f16*>(nullptr));
+        case OutputFormat::UInt16:
+            return create(DataUInt16::get(), static_cast<std::uint16_t*>(nullptr));
+        case OutputFormat::UInt8:
+            return create(DataUInt8::get(), static_cast<std::uint8_t*>(nullptr));
+        case OutputFormat::Float32:
+        default:
+            return create(DataFloat32::get(), static_cast<float*>(nullptr));
+    }
 }
 
 vec3 HydrogenGenerator::cartesianToSpherical(vec3 cartesian) {
@@ -74,9 +174,17 @@ double HydrogenGenerator::eval(vec3 cartesian) {
     return density;
 }
 
-vec3 HydrogenGenerator::idTOCartesian(size3_t pos) {
+double HydrogenGenerator::maxDensity() {
+    // r^2 e^(-r/3) is largest at r = 6 and |3 cos^2(theta) - 1| at theta = 0
+    const double value = 2.0 * 36.0 * std::exp(-2.0) / (81.0 * std::sqrt(6.0 * M_PI));
+    return value * value;
+}
+
+vec3 HydrogenGenerator::idTOCartesian(size3_t pos) { return idTOCartesian(pos, size_); }
+
+vec3 HydrogenGenerator::idTOCartesian(size3_t pos, size_t size) {
     vec3 p(pos);
-    p /= size_ - 1;
+    p /= size - 1;
     return p * (36.0f) - 18.0f;
 }
 
@@ -1,15 +1,31 @@
 #pragma once
 
 #include <modules/tnm067lab2/tnm067lab2moduledefine.h>
-#include <inviwo/core/processors/processor.h>
+#include <inviwo/core/processors/poolprocessor.h>
 #include <inviwo/core/properties/ordinalproperty.h>
+#include <inviwo/core/properties/boolproperty.h>
+#include <inviwo/core/properties/optionproperty.h>
 #include <inviwo/core/ports/imageport.h>
 #include <inviwo/core/ports/volumeport.h>
+#include <modules/tnm067lab1/properties/profilingproperty.h>
+#include <modules/tnm067lab1/utils/jobcontrol.h>
 
 namespace inviwo {
 
-class IVW_MODULE_TNM067LAB2_API HydrogenGenerator : public Processor {
+/**
+ * \class HydrogenGenerator
+ * \brief Generates a volume of the hydrogen density.
+ * With Run in Background set the volume is generated on the thread pool. A size change stops the
+ * job in flight and the previous volume stays on the outport until the new one is done.
+ */
+class IVW_MODULE_TNM067LAB2_API HydrogenGenerator : public PoolProcessor {
 public:
+    /**
+     * Float32 and Float16 store the density, UInt16 and UInt8 store it quantized against
+     * [0, maxDensity()], the value range of the volume
+     */
+    enum class OutputFormat { Float32, Float16, UInt16, UInt8 };
+
     HydrogenGenerator();
     virtual ~HydrogenGenerator() = default;
 
@@ -20,13 +36,31 @@ public:
 
     static vec3 cartesianToSpherical(vec3 cartesian);
     static double eval(vec3 cartesian);
+    /// Upper bound of eval(), the density on the z axis at radius 6
+    static double maxDensity();
 
     vec3 idTOCartesian(size3_t pos);
+    static vec3 idTOCartesian(size3_t pos, size_t size);
+
+    /**
+     * Generates a size^3 volume of the hydrogen density, written directly in format. The data
+     * range of the integer formats is the range of the type, mapped to the value range
+     * [0, maxDensity()]. This is what process() runs, exposed to allow running it outside of a
+     * processor network. Returns nullptr if control is stopped, which is checked once per z-slice.
+     */
+    static std::shared_ptr<Volume> generate(size_t size,
+                                            OutputFormat format = OutputFormat::Float32,
+                                            TNM067::Profile* profile = nullptr,
+                                            const TNM067::JobControl* control = nullptr);
 
 private:
     VolumeOutport volume_;
 
     IntSizeTProperty size_;
+    TemplateOptionProperty<OutputFormat> format_;
+    BoolProperty background_;
+    ProfilingProperty profiling_;
+    size_t generation_ = 0;  //!< Counts process() calls, results of older jobs are dropped
 };
 
 }  // namespace inviwo
@@ -0,0 +1,472 @@
+#include <modules/tnm067lab2/processors/marchingsquares.h>
+#include <modules/tnm067lab1/utils/parallelutils.h>
+#include <modules/tnm067lab1/utils/flathashmap.h>
+#include <inviwo/core/datastructures/image/layerramprecision.h>
+#include <inviwo/core/util/formatdispatching.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace inviwo {
+
+const ProcessorInfo MarchingSquares::processorInfo_{
+    "org.inviwo.MarchingSquares",  // Class identifier
+    "Marching Squares",            // Display name
+    "TNM067",                      // Category
+    CodeState::Experimental,       // Code state
+    Tags::CPU,                     // Tags
+};
+
+const ProcessorInfo MarchingSquares::getProcessorInfo() const { return processorInfo_; }
+
+MarchingSquares::MarchingSquares()
+    : PoolProcessor(pool::Option::KeepOldResults | pool::Option::DelayDispatch)
+    , imageInport_("imageInport", true)
+    , meshOutport_("meshOutport")
+    , levelCount_("levelCount", "Number of Levels", 10, 1, 256)
+    , numColors_("numColors", "Number of colors", 2, 1, 10)
+    , colors_(
+          {FloatVec4Property{"color1", "Color 1", util::ordinalColor(0.0f, 0.0f, 1.0f, 1.0f)},
+           FloatVec4Property{"color2", "Color 2", util::ordinalColor(1.0f, 0.0f, 0.0f, 1.0f)},
+           FloatVec4Property{"color3", "Color 3", util::ordinalColor(1.0f, 1.0f, 1.0f, 1.0f)},
+           FloatVec4Property{"color4", "Color 4", util::ordinalColor(1.0f, 1.0f, 1.0f, 1.0f)},
+           FloatVec4Property{"color5", "Color 5", util::ordinalColor(1.0f, 1.0f, 1.0f, 1.0f)},
+           FloatVec4Property{"color6", "Color 6", util::ordinalColor(1.0f, 1.0f, 1.0f, 1.0f)},
+           FloatVec4Property{"color7", "Color 7", util::ordinalColor(1.0f, 1.0f, 1.0f, 1.0f)},
+           FloatVec4Property{"color8", "Color 8", util::ordinalColor(1.0f, 1.0f, 1.0f, 1.0f)},
+           FloatVec4Property{"color9", "Color 9", util::ordinalColor(1.0f, 1.0f, 1.0f, 1.0f)},
+           FloatVec4Property{"color10", "Color 10", util::ordinalColor(1.0f, 1.0f, 1.0f, 1.0f)}})
+    , background_("background", "Run in Background", true)
+    , profiling_("profiling", "Profiling")
+    , pool_(std::make_shared<TNM067::BufferPool>()) {
+
+    addPort(imageInport_);
+    addPort(meshOutport_);
+    addProperty(levelCount_);
+
+    addProperty(numColors_);
+    for (auto& c : colors_) {
+        addProperty(c);
+    }
+    addProperty(background_);
+    addProperty(profiling_);
+
+    auto colorVisibility = [&]() {
+        for (size_t i = 0; i < 10; i++) {
+            colors_[i].setVisible(i < numColors_);
+        }
+    };
+
+    numColors_.onChange(colorVisibility);
+    colorVisibility();
+}
+
+namespace {
+using ContourMesh = MarchingSquares::ContourMesh;
+
+constexpr auto none = std::numeric_limits<std::uint32_t>::max();
+
+/**
+ * Contours of the cell rows [firstRow, endRow). Vertices are deduplicated within the band by the
+ * key of their edge. The vertices on the first pixel row are shared with the band before, which
+ * owns them, and are listed in seams. The band before has no vertex on an edge whose cell there
+ * was skipped for a NaN corner, such vertices are owned by this band and left out of seams.
+ */
+struct Band {
+    size_t firstRow = 0;
+    size_t endRow = 0;
+    TNM067::FlatHashMap<std::uint64_t, std::uint32_t> edgeToVertex;
+    std::vector<std::uint64_t> vertexEdges;  //!< Edge key of every vertex
+    std::vector<vec2> positions;             //!< In pixel coordinates
+    std::vector<std::uint32_t> seams;
+    std::vector<std::uint32_t> seamOwners;  //!< Vertex in the band before of every seam
+    std::vector<std::uint32_t> segments;  //!< Pairs of vertices
+    std::vector<std::uint32_t> global;    //!< Index of every vertex in the mesh
+    size_t firstGlobal = 0;               //!< Index in the mesh of the first owned vertex
+};
+
+std::shared_ptr<ContourMesh> outputMesh(TNM067::BufferPool* pool) {
+    if (pool) return pool->mesh<ContourMesh>(DrawType::Lines, ConnectivityType::Strip);
+    auto mesh = std::make_shared<ContourMesh>();
+    mesh->addIndexBuffer(DrawType::Lines, ConnectivityType::Strip);
+    return mesh;
+}
+
+}  // namespace
+
+std::shared_ptr<MarchingSquares::ContourMesh> MarchingSquares::extract(
+    const LayerRAM& image, size_t levelCount, const ScalarToColorMapping& map,
+    TNM067::Profile* profile, TNM067::BufferPool* pool, const TNM067::JobControl* control) {
+    TNM067_PROFILE_SCOPE(profile, "Extract contours");
+    const size2_t dims = image.getDimensions();
+
+    auto mesh = outputMesh(pool);
+    auto& indices =
+        mesh->getIndexBuffers().front().second->getEditableRAMRepresentation()->getDataContainer();
+
+    std::vector<float> ownValues;
+    std::vector<Band> ownBands;
+    std::vector<ContourMesh::Vertex> ownVertices;
+    std::vector<std::array<std::uint32_t, 2>> ownLinks;
+    auto& values = pool ? pool->scratch<std::vector<float>>() : ownValues;
+    auto& bands = pool ? pool->scratch<std::vector<Band>>() : ownBands;
+    auto& vertices = pool ? pool->scratch<std::vector<ContourMesh::Vertex>>() : ownVertices;
+    auto& links = pool ? pool->scratch<std::vector<std::array<std::uint32_t, 2>>>() : ownLinks;
+    values.resize(dims.x * dims.y);
+    vertices.clear();
+
+    std::atomic<bool> stopped{false};
+    auto checkpoint = [&]() {
+        if (control && control->stopped()) stopped = true;
+        return !stopped;
+    };
+
+    // First channel as floats and its value range, NaN values are left out of the range
+    float lowest = std::numeric_limits<float>::max();
+    float highest = std::numeric_limits<float>::lowest();
+    {
+        TNM067_PROFILE_SCOPE(profile, "Values");
+        const size_t jobs = TNM067::defaultJobCount();
+        std::vector<vec2> ranges(jobs, vec2(lowest, highest));
+        image.dispatch<void>([&](const auto rep) {
+            const auto data = rep->getDataTyped();
+            TNM067::forEachRangeParallel(
+                values.size(),
+                [&](size_t begin, size_t end, size_t job) {
+                    vec2 range = ranges[job];
+                    for (size_t i = begin; i < end; ++i) {
+                        const float v = static_cast<float>(util::glmcomp(data[i], 0));
+                        values[i] = v;
+                        if (v < range.x) range.x = v;
+                        if (v > range.y) range.y = v;
+                    }
+                    ranges[job] = range;
+                },
+                jobs);
+        });
+        for (const auto& range : ranges) {
+            lowest = std::min(lowest, range.x);
+            highest = std::max(highest, range.y);
+        }
+        TNM067_PROFILE_COUNT(profile, PixelsProcessed, dims.x * dims.y);
+    }
+    if (dims.x < 2 || dims.y < 2 || !(highest > lowest) || levelCount == 0) return mesh;
+
+    std::vector<float> levels(levelCount);
+    std::vector<vec4> levelColors(levelCount);
+    for (size_t i = 0; i < levelCount; ++i) {
+        const float t = static_cast<float>(i + 1) / static_cast<float>(levelCount + 1);
+        levels[i] = lowest + t * (highest - lowest);
+        levelColors[i] = map.sample(t);
+    }
+    const float levelsPerValue = static_cast<float>(levelCount + 1) / (highest - lowest);
+    // Number of levels at or below v. The levels are evenly spaced, so the estimate is at most
+    // one off from rounding and the loops make it exact.
+    auto levelsBelow = [&](float v) {
+        auto i = static_cast<size_t>(glm::clamp((v - lowest) * levelsPerValue, 0.0f,
+                                                static_cast<float>(levelCount)));
+        while (i > 0 && levels[i - 1] > v) --i;
+        while (i < levelCount && levels[i] <= v) ++i;
+        return i;
+    };
+
+    // Edges are keyed by level, the pixel at their start and if they are vertical
+    const std::uint64_t edgesPerLevel = 2 * static_cast<std::uint64_t>(dims.x) * dims.y;
+    auto edgeKey = [&](size_t level, size_t x, size_t y, bool vertical) {
+        return level * edgesPerLevel + 2 * (x + y * dims.x) + (vertical ? 1 : 0);
+    };
+
+    const size_t cellRows = dims.y - 1;
+    const size_t bandCount = std::min(TNM067::defaultJobCount(), cellRows);
+    bands.resize(bandCount);
+    std::atomic<size_t> rowsDone{0};
+    {
+        TNM067_PROFILE_SCOPE(profile, "Contouring");
+        TNM067::forEachRangeParallel(
+            bandCount,
+            [&](size_t b, size_t, size_t) {
+                Band& band = bands[b];
+                band.firstRow = cellRows * b / bandCount;
+                band.endRow = cellRows * (b + 1) / bandCount;
+                band.edgeToVertex.clear();
+                band.vertexEdges.clear();
+                band.positions.clear();
+                band.seams.clear();
+                band.segments.clear();
+                size_t activeCells = 0;
+                size_t deduplicated = 0;
+
+                auto addVertex = [&](std::uint64_t key, vec2 pos, bool seam) {
+                    const auto id = static_cast<std::uint32_t>(band.positions.size());
+                    const auto inserted = band.edgeToVertex.tryEmplace(key, id);
+                    if (!inserted.second) {
+                        ++deduplicated;
+                        return inserted.first;
+                    }
+                    band.vertexEdges.push_back(key);
+                    band.positions.push_back(pos);
+                    if (seam) band.seams.push_back(id);
+                    return id;
+                };
+
+                for (size_t y = band.firstRow; y < band.endRow && checkpoint(); ++y) {
+                    const float* row0 = values.data() + y * dims.x;
+                    const float* row1 = row0 + dims.x;
+                    const bool seamRow = b > 0 && y == band.firstRow;
+                    for (size_t x = 0; x + 1 < dims.x; ++x) {
+                        const float v00 = row0[x];
+                        const float v10 = row0[x + 1];
+                        const float v01 = row1[x];
+                        const float v11 = row1[x + 1];
+                        if (std::isnan(v00 + v10 + v01 + v11)) continue;
+                        const float lo = std::min(std::min(v00, v10), std::min(v01, v11));
+                        const float hi = std::max(std::max(v00, v10), std::max(v01, v11));
+                        // The levels in (lo, hi] cross the cell
+                        const size_t first = levelsBelow(lo);
+                        const size_t end = levelsBelow(hi);
+                        if (first == end) continue;
+                        ++activeCells;
+
+                        for (size_t level = first; level < end; ++level) {
+                            const float iso = levels[level];
+                            const int caseId = (v00 >= iso ? 1 : 0) | (v10 >= iso ? 2 : 0) |
+                                               (v11 >= iso ? 4 : 0) | (v01 >= iso ? 8 : 0);
+
+                            // Edges 0 - 3 are the bottom, right, top and left edge of the cell
+                            auto vertex = [&](int edge) {
+                                switch (edge) {
+                                    case 0:
+                                        return addVertex(
+                                            edgeKey(level, x, y, false),
+                                            vec2(x + (iso - v00) / (v10 - v00), y), seamRow);
+                                    case 1:
+                                        return addVertex(
+                                            edgeKey(level, x + 1, y, true),
+                                            vec2(x + 1, y + (iso - v10) / (v11 - v10)), false);
+                                    case 2:
+                                        return addVertex(
+                                            edgeKey(level, x, y + 1, false),
+                                            vec2(x + (iso - v01) / (v11 - v01), y + 1), false);
+                                    default:
+                                        return addVertex(
+                                            edgeKey(level, x, y, true),
+                                            vec2(x, y + (iso - v00) / (v01 - v00)), false);
+                                }
+                            };
+                            auto segment = [&](int e0, int e1) {
+                                band.segments.push_back(vertex(e0));
+                                band.segments.push_back(vertex(e1));
+                            };
+
+                            // Saddles, either the corners below or those above iso are cut off
+                            // depending on the value at the center
+                            const bool centerAbove = 0.25f * (v00 + v10 + v01 + v11) >= iso;
+                            switch (caseId) {
+                                case 1:
+                                case 14:
+                                    segment(3, 0);
+                                    break;
+                                case 2:
+                                case 13:
+                                    segment(0, 1);
+                                    break;
+                                case 3:
+                                case 12:
+                                    segment(3, 1);
+                                    break;
+                                case 4:
+                                case 11:
+                                    segment(1, 2);
+                                    break;
+                                case 6:
+                                case 9:
+                                    segment(0, 2);
+                                    break;
+                                case 7:
+                                case 8:
+                                    segment(3, 2);
+                                    break;
+                                case 5:
+                                case 10:
+                                    if (centerAbove == (caseId == 5)) {
+                                        segment(0, 1);
+                                        segment(2, 3);
+                                    } else {
+                                        segment(3, 0);
+                                        segment(1, 2);
+                                    }
+                                    break;
+                            }
+                        }
+                    }
+                    if (control) control->progress(++rowsDone, cellRows);
+                }
+                TNM067_PROFILE_COUNT(profile, ActiveCells, activeCells);
+                TNM067_PROFILE_COUNT(profile, VerticesDeduplicated, deduplicated);
+            },
+            bandCount);
+    }
+    if (stopped) return nullptr;
+
+    {
+        TNM067_PROFILE_SCOPE(profile, "Stitch bands");
+        TNM067::forEachRangeParallel(
+            bandCount,
+            [&](size_t b, size_t, size_t) {
+                Band& band = bands[b];
+                band.seamOwners.clear();
+                if (b == 0) return;
+                const Band& before = bands[b - 1];
+                size_t kept = 0;
+                for (const auto v : band.seams) {
+                    if (const auto owner = before.edgeToVertex.get(band.vertexEdges[v])) {
+                        band.seams[kept++] = v;
+                        band.seamOwners.push_back(*owner);
+                    }
+                }
+                band.seams.resize(kept);
+            },
+            bandCount);
+
+        size_t vertexCount = 0;
+        for (auto& band : bands) {
+            band.firstGlobal = vertexCount;
+            vertexCount += band.positions.size() - band.seams.size();
+        }
+        vertices.resize(vertexCount);
+
+        // Owned vertices first, then the seam vertices of each band take the index their edge
+        // has in the band before
+        const vec2 toUnit = 1.0f / vec2(dims);
+        TNM067::forEachRangeParallel(
+            bandCount,
+            [&](size_t b, size_t, size_t) {
+                Band& band = bands[b];
+                band.global.assign(band.positions.size(), 0);
+                for (const auto v : band.seams) band.global[v] = none;
+                auto next = static_cast<std::uint32_t>(band.firstGlobal);
+                for (size_t v = 0; v < band.positions.size(); ++v) {
+                    if (band.global[v] == none) continue;
+                    band.global[v] = next;
+                    vertices[next++] =
+                        ContourMesh::Vertex(vec3((band.positions[v] + 0.5f) * toUnit, 0.0f),
+                                            levelColors[band.vertexEdges[v] / edgesPerLevel]);
+                }
+            },
+            bandCount);
+        TNM067::forEachRangeParallel(
+            bandCount,
+            [&](size_t b, size_t, size_t) {
+                Band& band = bands[b];
+                if (b == 0) return;
+                const Band& before = bands[b - 1];
+                for (size_t i = 0; i < band.seams.size(); ++i) {
+                    band.global[band.seams[i]] = before.global[band.seamOwners[i]];
+                }
+                TNM067_PROFILE_COUNT(profile, VerticesDeduplicated, band.seams.size());
+            },
+            bandCount);
+    }
+
+    {
+        TNM067_PROFILE_SCOPE(profile, "Join polylines");
+        // Every vertex is on a cell edge, which is shared by at most two cells that add one
+        // segment each to it, so each vertex has at most two neighbors
+        links.assign(vertices.size(), {none, none});
+        size_t segmentCount = 0;
+        for (const auto& band : bands) {
+            for (size_t s = 0; s < band.segments.size(); s += 2) {
+                const auto a = band.global[band.segments[s]];
+                const auto b = band.global[band.segments[s + 1]];
+                (links[a][0] == none ? links[a][0] : links[a][1]) = b;
+                (links[b][0] == none ? links[b][0] : links[b][1]) = a;
+            }
+            segmentCount += band.segments.size() / 2;
+        }
+
+        constexpr auto restart = std::numeric_limits<std::uint32_t>::max();
+        indices.clear();
+        indices.reserve(2 * segmentCount);
+        std::vector<std::uint8_t> visited(vertices.size(), 0);
+        auto walk = [&](std::uint32_t start) {
+            if (!indices.empty()) indices.push_back(restart);
+            std::uint32_t previous = none;
+            std::uint32_t current = start;
+            while (current != none) {
+                indices.push_back(current);
+                visited[current] = 1;
+                const auto& l = links[current];
+                const std::uint32_t next = l[0] != previous ? l[0] : l[1];
+                previous = current;
+                current = next;
+                if (current == start) {
+                    indices.push_back(start);
+                    break;
+                }
+            }
+        };
+        // Open contours start at one of their ends, the vertices left are on closed contours
+        for (std::uint32_t v = 0; v < vertices.size(); ++v) {
+            if (!visited[v] && links[v][1] == none) walk(v);
+        }
+        for (std::uint32_t v = 0; v < vertices.size(); ++v) {
+            if (!visited[v]) walk(v);
+        }
+    }
+
+    TNM067_PROFILE_SCOPE(profile, "Add vertices");
+    mesh->addVertices(vertices);
+
+    return mesh;
+}
+
+void MarchingSquares::process() {
+    const auto image = imageInport_.getData();
+    const auto layer = image->getColorLayer()->getRepresentation<LayerRAM>();
+
+    ScalarToColorMapping map;
+    for (size_t i = 0; i < numColors_.get(); i++) {
+        map.addBaseColors(colors_[i].get());
+    }
+
+    const auto generation = ++generation_;
+    auto build = [layer, map, levelCount = levelCount_.get()](TNM067::Profile* profile,
+                                                              TNM067::BufferPool* pool,
+                                                              const TNM067::JobControl* control) {
+        return extract(*layer, levelCount, map, profile, pool, control);
+    };
+
+    if (!background_) {
+        // A stale background job may still be using the pool
+        const auto lock = pool_->lock();
+        auto profile = profiling_.begin();
+        const auto mesh = build(profile, pool_.get(), nullptr);
+        profiling_.end();
+
+        meshOutport_.setData(mesh);
+        return;
+    }
+
+    // The image is captured to keep the layer alive while the job runs
+    auto job = [image, build, buffers = pool_](pool::Stop stop, pool::Progress progress) {
+        const auto lock = buffers->lock();
+        const auto profile = ProfilingProperty::beginJob();
+        const TNM067::JobControl control{[stop]() { return stop(); },
+                                         [progress](float done) { progress(done); }};
+        auto mesh = build(profile.get(), buffers.get(), &control);
+        if (profile) profile->end();
+        return std::make_pair(mesh, profile);
+    };
+    dispatchOne(job, [this, generation](auto result) {
+        if (!result.first || generation != generation_) return;
+        if (result.second) profiling_.report(*result.second);
+        meshOutport_.setData(result.first);
+        newResults();
+    });
+}
+
+}  // namespace inviwo
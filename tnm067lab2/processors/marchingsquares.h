@@ -0,0 +1,70 @@
+#pragma once
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <inviwo/core/processors/poolprocessor.h>
+#include <inviwo/core/properties/ordinalproperty.h>
+#include <inviwo/core/properties/boolproperty.h>
+#include <inviwo/core/ports/imageport.h>
+#include <inviwo/core/ports/meshport.h>
+#include <inviwo/core/datastructures/geometry/typedmesh.h>
+#include <modules/tnm067lab1/utils/scalartocolormapping.h>
+#include <modules/tnm067lab1/properties/profilingproperty.h>
+#include <modules/tnm067lab1/utils/bufferpool.h>
+#include <modules/tnm067lab1/utils/jobcontrol.h>
+
+#include <array>
+
+namespace inviwo {
+
+/**
+ * \class MarchingSquares
+ * \brief Extracts iso contours of the first channel of an image at several iso levels.
+ * The image rows are split into bands that are contoured in parallel, all levels in one pass over
+ * the cells. The output is one line strip per contour.
+ * With Run in Background set the contours are extracted on the thread pool. A new image or
+ * property change stops the job in flight and the previous contours stay on the outport until
+ * the new ones are done.
+ */
+class IVW_MODULE_TNM067LAB2_API MarchingSquares : public PoolProcessor {
+public:
+    using ContourMesh = TypedMesh<buffertraits::PositionsBuffer, buffertraits::ColorsBuffer>;
+
+    MarchingSquares();
+    virtual ~MarchingSquares() = default;
+
+    virtual void process() override;
+
+    virtual const ProcessorInfo getProcessorInfo() const override;
+    static const ProcessorInfo processorInfo_;
+
+    /**
+     * Extracts the contours of image at levelCount iso levels spread evenly inside its value
+     * range, level i at the fraction (i + 1) / (levelCount + 1) of the range and colored by map
+     * at that fraction. Cells with a saddle are split by the value at their center. Vertices are
+     * placed in the unit square like the pixel centers, at z = 0. Every contour is a line strip
+     * ending in a restart index 0xFFFFFFFF except the last, and closed contours repeat their
+     * first vertex. This is what process() runs, exposed to allow running it outside of a
+     * processor network. The mesh and temporaries are taken from pool if given. Returns nullptr
+     * if control is stopped, which is checked once per row of cells.
+     */
+    static std::shared_ptr<ContourMesh> extract(const LayerRAM& image, size_t levelCount,
+                                                const ScalarToColorMapping& map,
+                                                TNM067::Profile* profile = nullptr,
+                                                TNM067::BufferPool* pool = nullptr,
+                                                const TNM067::JobControl* control = nullptr);
+
+private:
+    ImageInport imageInport_;
+    MeshOutport meshOutport_;
+    IntSizeTProperty levelCount_;
+
+    IntSizeTProperty numColors_;
+    std::array<FloatVec4Property, 10> colors_;
+    BoolProperty background_;
+    ProfilingProperty profiling_;
+    // Shared with the background jobs, which may outlive a process() call
+    std::shared_ptr<TNM067::BufferPool> pool_;
+    size_t generation_ = 0;  //!< Counts process() calls, results of older jobs are dropped
+};
+
+}  // namespace inviwo
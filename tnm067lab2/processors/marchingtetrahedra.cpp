@@ -2,13 +2,20 @@
 #include <inviwo/core/datastructures/geometry/basicmesh.h>
 #include <inviwo/core/datastructures/volume/volumeram.h>
 #include <inviwo/core/util/indexmapper.h>
+#include <inviwo/core/util/formatdispatching.h>
 #include <inviwo/core/util/assertion.h>
 #include <inviwo/core/network/networklock.h>
 #include <modules/tnm067lab1/utils/interpolationmethods.h>
+#include <modules/tnm067lab2/utils/marchingcubestables.h>
+#include <modules/tnm067lab2/utils/isooctree.h>
+#include <modules/tnm067lab2/utils/meshexport.h>
 
-namespace inviwo {
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <type_traits>
 
-size_t MarchingTetrahedra::HashFunc::max = 1;
+namespace inviwo {
 
 const ProcessorInfo MarchingTetrahedra::processorInfo_{
     "org.inviwo.MarchingTetrahedra",  // Class identifier
@@ -20,58 +27,367 @@ const ProcessorInfo MarchingTetrahedra::processorInfo_{
 const ProcessorInfo MarchingTetrahedra::getProcessorInfo() const { return processorInfo_; }
 
 MarchingTetrahedra::MarchingTetrahedra()
-: Processor()
+: PoolProcessor(pool::Option::KeepOldResults | pool::Option::DelayDispatch)
 , volume_("volume")
+, bricks_("bricks")
 , mesh_("mesh")
-, isoValue_("isoValue", "ISO value", 0.5f, 0.0f, 1.0f) {
+, isoValue_("isoValue", "ISO value", 0.5f, 0.0f, 1.0f)
+, engine_("engine", "Engine",
+          {{"tetrahedra", "Marching Tetrahedra", Engine::Tetrahedra},
+           {"cubes", "Marching Cubes", Engine::Cubes}},
+          0)
+, normals_("normals", "Normals",
+           {{"faces", "Accumulated Face Normals", Normals::Faces},
+            {"gradient", "Volume Gradient", Normals::Gradient}},
+           0)
+, adaptive_("adaptive", "Adaptive Octree", false)
+, adaptiveError_("adaptiveError", "Adaptive Max Error", 0.01f, 0.0f, 0.25f, 0.001f)
+, background_("background", "Run in Background", true)
+, meshCache_("meshCache", "Mesh Cache")
+, profiling_("profiling", "Profiling")
+, pool_(std::make_shared<TNM067::BufferPool>()) {
     
     addPort(volume_);
+    addPort(bricks_);
     addPort(mesh_);
     
+    // Either a dense or a brick-compressed volume is used, the latter if both are connected
+    volume_.setOptional(true);
+    bricks_.setOptional(true);
+    
     addProperty(isoValue_);
+    addProperty(engine_);
+    addProperty(normals_);
+    addProperty(adaptive_);
+    addProperty(adaptiveError_);
+    addProperty(background_);
+    addProperty(meshCache_);
+    addProperty(profiling_);
     
     isoValue_.setSerializationMode(PropertySerializationMode::All);
     
-    volume_.onChange([&]() {
-        if (!volume_.hasData()) {
-            return;
-        }
+    // The octree always splits its leaves into tetrahedra
+    auto visibility = [this]() {
+        engine_.setVisible(!adaptive_);
+        adaptiveError_.setVisible(adaptive_);
+    };
+    adaptive_.onChange(visibility);
+    visibility();
+    
+    auto updateIsoRange = [this](dvec2 vr) {
         NetworkLock lock(getNetwork());
         float iso = (isoValue_.get() - isoValue_.getMinValue()) /
         (isoValue_.getMaxValue() - isoValue_.getMinValue());
-        const auto vr = volume_.getData()->dataMap_.valueRange;
         isoValue_.setMinValue(static_cast<float>(vr.x));
         isoValue_.setMaxValue(static_cast<float>(vr.y));
         isoValue_.setIncrement(static_cast<float>(glm::abs(vr.y - vr.x) / 50.0));
         isoValue_.set(static_cast<float>(iso * (vr.y - vr.x) + vr.x));
         isoValue_.setCurrentStateAsDefault();
+    };
+    
+    volume_.onChange([this, updateIsoRange]() {
+        if (!volume_.hasData()) {
+            return;
+        }
+        updateIsoRange(volume_.getData()->dataMap_.valueRange);
+    });
+    bricks_.onChange([this, updateIsoRange]() {
+        if (!bricks_.hasData()) {
+            return;
+        }
+        updateIsoRange(bricks_.getData()->valueRange);
     });
 }
 
 void MarchingTetrahedra::process() {
-    auto volume = volume_.getData()->getRepresentation<VolumeRAM>();
-    MeshHelper mesh(volume_.getData());
+    ++generation_;
+    if (bricks_.hasData()) {
+        run([bricks = bricks_.getData(), iso = isoValue_.get(), engine = engine_.get(),
+             normals = normals_.get()](TNM067::Profile* profile, TNM067::BufferPool* pool,
+                                       const TNM067::JobControl* control) {
+                return extract(*bricks, iso, engine, normals, profile, pool, control);
+            },
+            [](const BasicMesh&) {});
+        return;
+    }
+    if (!volume_.hasData()) {
+        return;
+    }
     
-    const auto& dims = volume->getDimensions();
-    MarchingTetrahedra::HashFunc::max = dims.x * dims.y * dims.z;
+    const auto volume = volume_.getData();
+    const auto ram = volume->getRepresentation<VolumeRAM>();
     
-    const float iso = isoValue_.get();
+    // The cache key covers everything the mesh depends on. It hashes the whole volume, so it is
+    // only computed with the cache enabled.
+    const auto cache = meshCache_.getCache();
+    std::uint64_t key = 0;
+    if (cache.isEnabled()) {
+        key = TNM067::Hasher{}
+                  .add(std::string("MarchingTetrahedra.v4"))
+                  .add(ram->getDimensions())
+                  .add(ram->getDataFormatId())
+                  .add(ram->getData(),
+                       glm::compMul(ram->getDimensions()) * ram->getDataFormat()->getSize())
+                  .add(volume->dataMap_.dataRange)
+                  .add(volume->dataMap_.valueRange)
+                  .add(volume->getModelMatrix())
+                  .add(volume->getWorldMatrix())
+                  .add(isoValue_.get())
+                  .add(engine_.get())
+                  .add(normals_.get())
+                  .add(adaptive_.get())
+                  .add(adaptiveError_.get())
+                  .get();
+        
+        auto cached = std::make_shared<BasicMesh>();
+        if (cache.load(key, *cached)) {
+            mesh_.setData(cached);
+            return;
+        }
+    }
     
-    util::IndexMapper3D indexInVolume(dims);
+    // The max error is given relative to the value range of the volume
+    const auto range = volume->dataMap_.valueRange;
+    const float maxError = adaptiveError_.get() * static_cast<float>(range.y - range.x);
+    // The RAM representation is created above, so the job only reads it
+    run([volume, iso = isoValue_.get(), engine = engine_.get(), normals = normals_.get(),
+         adaptive = adaptive_.get(), maxError](TNM067::Profile* profile, TNM067::BufferPool* pool,
+                                               const TNM067::JobControl* control) {
+            if (adaptive) {
+                return extractAdaptive(volume, iso, maxError, normals, profile, pool, control);
+            }
+            return extract(volume, iso, engine, normals, profile, pool, control);
+        },
+        [cache, key](const BasicMesh& mesh) { cache.store(key, mesh); });
+}
+
+template <typename Extraction, typename Store>
+void MarchingTetrahedra::run(Extraction extraction, Store store) {
+    if (!background_) {
+        // A stale background job may still be using the pool
+        const auto lock = pool_->lock();
+        auto profile = profiling_.begin();
+        const auto mesh = extraction(profile, pool_.get(), nullptr);
+        profiling_.end();
+        store(*mesh);
+        mesh_.setData(mesh);
+        return;
+    }
     
+    auto job = [extraction, store, buffers = pool_](pool::Stop stop, pool::Progress progress) {
+        const auto lock = buffers->lock();
+        const auto profile = ProfilingProperty::beginJob();
+        const TNM067::JobControl control{[stop]() { return stop(); },
+                                         [progress](float done) { progress(done); }};
+        auto mesh = extraction(profile.get(), buffers.get(), &control);
+        if (profile) profile->end();
+        if (mesh) store(*mesh);
+        return std::make_pair(mesh, profile);
+    };
+    dispatchOne(job, [this, generation = generation_](auto result) {
+        if (!result.first || generation != generation_) return;
+        if (result.second) profiling_.report(*result.second);
+        mesh_.setData(result.first);
+        newResults();
+    });
+}
+
+namespace {
+
+/**
+ * Voxels of type T of a volume, or of a brick of it starting at voxel origin, of size dims. Values
+ * are in the data range of the volume like the iso value given to the marching functions.
+ * below(voxel) compares a voxel with iso on the stored type, integer types with iso rounded up,
+ * which classifies it the same as comparing its value.
+ */
+template <typename T>
+class VoxelSampler {
+public:
+    VoxelSampler(const T* data, size3_t origin, size3_t dims, float iso)
+        : data_(data), origin_(origin), index_(dims), threshold_(toThreshold(iso)) {}
+
+    float operator()(size3_t voxel) const { return static_cast<float>(at(voxel)); }
+    bool below(size3_t voxel) const { return static_cast<Threshold>(at(voxel)) < threshold_; }
+
+private:
+    using Threshold = std::conditional_t<std::is_integral_v<T>, std::int64_t, float>;
+
+    static Threshold toThreshold(float iso) {
+        if constexpr (std::is_integral_v<T>) {
+            return static_cast<std::int64_t>(std::clamp(std::ceil(iso), -1e18f, 1e18f));
+        } else {
+            return iso;
+        }
+    }
+
+    const T& at(size3_t voxel) const { return data_[index_(voxel - origin_)]; }
+
+    const T* data_;
+    size3_t origin_;
+    util::IndexMapper3D index_;
+    Threshold threshold_;
+};
+
+/// iso mapped from the value range of vol to its data range, the units of its voxels
+float isoInData(const Volume& vol, float iso) {
+    return static_cast<float>(vol.dataMap_.mapFromValueToData(static_cast<double>(iso)));
+}
+
+/**
+ * Case index of the cell with its first corner at pos, bit i is set if corner i is below iso. The
+ * corners are classified on the stored voxels, so cells the surface does not pass through are
+ * skipped without converting any of them.
+ */
+template <typename Sampler>
+size_t cellCase(const Sampler& sample, size3_t pos) {
+    size_t caseId = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        if (sample.below(pos + size3_t(i & 1, (i >> 1) & 1, (i >> 2) & 1))) {
+            caseId |= size_t{1} << i;
+        }
+    }
+    return caseId;
+}
+
+/**
+ * Case index of a tetrahedron, bit i is set if corner i is below iso
+ */
+int tetrahedronCase(const MarchingTetrahedra::Tetrahedra& tetrahedra, float iso) {
+    int caseId = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        if (tetrahedra.dataPoints[i].value < iso) caseId |= 1 << i;
+    }
+    return caseId;
+}
+
+/**
+ * Adds the triangles of a tetrahedron with case index caseId to mesh, a MeshHelper or anything
+ * else with its addVertex and addTriangle. caseId must not be 0 or 15.
+ */
+template <typename Output>
+void emitTetrahedron(Output& mesh, const MarchingTetrahedra::Tetrahedra& tetrahedra, int caseId,
+                     float iso) {
+    const auto& p = tetrahedra.dataPoints;
+
+    // The tetrahedra differ in handedness, so the winding is chosen such that the normals point
+    // from the centroid of the corners above the iso value towards the centroid of those below it
+    vec3 below(0.0f);
+    vec3 above(0.0f);
+    int belowCount = 0;
+    for (const auto& t : p) {
+        if (t.value < iso) {
+            below += t.pos;
+            ++belowCount;
+        } else {
+            above += t.pos;
+        }
+    }
+    const vec3 towardsBelow = below / static_cast<float>(belowCount) -
+                              above / static_cast<float>(4 - belowCount);
+
+    // Vertex on the edge between corner a and b
+    auto vertex = [&](size_t a, size_t b) {
+        const float t = (iso - p[a].value) / (p[b].value - p[a].value);
+        const vec3 pos = p[a].pos + (p[b].pos - p[a].pos) * t;
+        return std::make_pair(pos, mesh.addVertex(pos, p[a].index, p[b].index, t));
+    };
+    auto triangle = [&](auto v0, auto v1, auto v2) {
+        const vec3 n = glm::cross(v1.first - v0.first, v2.first - v0.first);
+        if (glm::dot(n, towardsBelow) < 0.0f) std::swap(v1, v2);
+        mesh.addTriangle(v0.second, v1.second, v2.second);
+    };
+    // v0 - v3 in order around the quad
+    auto quad = [&](auto v0, auto v1, auto v2, auto v3) {
+        const vec3 n = glm::cross(v2.first - v0.first, v3.first - v1.first);
+        if (glm::dot(n, towardsBelow) < 0.0f) std::swap(v1, v3);
+        mesh.addTriangle(v0.second, v1.second, v2.second);
+        mesh.addTriangle(v0.second, v2.second, v3.second);
+    };
+
+    switch (caseId) {
+        // One corner separated from the others, a triangle around that corner
+        case 1:
+        case 14: {
+            triangle(vertex(0, 1), vertex(0, 3), vertex(0, 2));
+            break;
+        }
+
+        case 2:
+        case 13: {
+            triangle(vertex(1, 0), vertex(1, 2), vertex(1, 3));
+            break;
+        }
+
+        case 4:
+        case 11: {
+            triangle(vertex(2, 0), vertex(2, 1), vertex(2, 3));
+            break;
+        }
+
+        case 7:
+        case 8: {
+            triangle(vertex(3, 0), vertex(3, 1), vertex(3, 2));
+            break;
+        }
+
+        // Two corners on each side, a quad between the two pairs
+        case 3:
+        case 12: {
+            quad(vertex(0, 2), vertex(0, 3), vertex(1, 3), vertex(1, 2));
+            break;
+        }
+
+        case 5:
+        case 10: {
+            quad(vertex(0, 1), vertex(0, 3), vertex(2, 3), vertex(2, 1));
+            break;
+        }
+
+        case 6:
+        case 9: {
+            quad(vertex(1, 0), vertex(1, 3), vertex(2, 3), vertex(2, 0));
+            break;
+        }
+    }
+}
+
+/**
+ * Marches the cells with their first corner in [begin, end) of a volume of size dims, splitting
+ * each cell into six tetrahedra. sample is a VoxelSampler, only the voxels of cells the surface
+ * passes through are converted to values.
+ */
+template <typename Output, typename Sampler>
+void marchTetrahedra(Output& mesh, size3_t dims, size3_t begin, size3_t end, float iso,
+                     const Sampler& sample, TNM067::Profile* profile) {
     const static size_t tetrahedraIds[6][4] = {{0, 1, 2, 5}, {1, 3, 2, 5}, {3, 2, 5, 7},
         {0, 2, 4, 5}, {6, 4, 2, 5}, {6, 7, 5, 2}};
     
+    util::IndexMapper3D indexInVolume(dims);
+    
+    TNM067_PROFILE_STAGE(samplingTimer, profile, "Sampling");
+    TNM067_PROFILE_STAGE(classificationTimer, profile, "Classification");
+    TNM067_PROFILE_STAGE(emissionTimer, profile, "Triangle emission");
+    
     size3_t pos{};
-    for (pos.z = 0; pos.z < dims.z - 1; ++pos.z) {
-        for (pos.y = 0; pos.y < dims.y - 1; ++pos.y) {
-            for (pos.x = 0; pos.x < dims.x - 1; ++pos.x) {
+    for (pos.z = begin.z; pos.z < end.z; ++pos.z) {
+        for (pos.y = begin.y; pos.y < end.y; ++pos.y) {
+            for (pos.x = begin.x; pos.x < end.x; ++pos.x) {
+                // None of the tetrahedra of a cell with all corners on one side are active
+                TNM067_PROFILE_STAGE_START(classificationTimer);
+                const size_t cellId = cellCase(sample, pos);
+                TNM067_PROFILE_STAGE_STOP(classificationTimer);
+                if (cellId == 0 || cellId == 255) {
+                    continue;
+                }
+
                 // Step 1: create current cell
                 
-                // The DataPoint index should be the 1D-index for the DataPoint in the cell
-                // Use volume->getAsDouble to query values from the volume
+                // The DataPoint index is the 1D-index of the voxel in the volume, so vertices on
+                // edges shared with neighboring cells are only added once
+                // Use sample to query values from the volume
                 // Spatial position should be between 0 and 1
-                Cell c;
+                TNM067_PROFILE_STAGE_START(samplingTimer);
+                MarchingTetrahedra::Cell c;
                 size_t index = 0;
                 
                 for (size_t z = 0; z < 2; ++z) {
@@ -79,15 +395,13 @@ void MarchingTetrahedra::process() {
                         for (size_t x = 0; x < 2; ++x) {
                             vec3 cellPos(x, y, z);
                             
-                            vec3 scaledCellPos = calculateDataPointPos(pos, cellPos, dims);
-                            size_t cellIndex = calculateDataPointIndexInCell(cellPos);
-                            float value = volume->getAsDouble(vec3{pos.x + x, pos.y + y, pos.z + z});
-                            
-//                            c.dataPoints[cellIndex] = MarchingTetrahedra::DataPoint{scaledCellPos, value, cellIndex};
+                            vec3 scaledCellPos = MarchingTetrahedra::calculateDataPointPos(pos, cellPos, dims);
+                            const size3_t voxel{pos.x + x, pos.y + y, pos.z + z};
+                            float value = sample(voxel);
                             
                             c.dataPoints[index].pos = scaledCellPos;
                             c.dataPoints[index].value = value;
-                            c.dataPoints[index].index = cellIndex;
+                            c.dataPoints[index].index = indexInVolume(voxel);
 
                             index++;
                         }
@@ -96,113 +410,524 @@ void MarchingTetrahedra::process() {
                 
                 
                 
-                // Step 2: Subdivide cell into tetrahedra (hint: use tetrahedraIds)
-                std::vector<Tetrahedra> tetrahedras;
+                TNM067_PROFILE_STAGE_STOP(samplingTimer);
                 
-                // Temporary tetrahedra
-                Tetrahedra tetra;
+                // Step 2: Subdivide cell into tetrahedra (hint: use tetrahedraIds)
+                // A fixed size array, so marching does not allocate per cell
+                std::array<MarchingTetrahedra::Tetrahedra, 6> tetrahedras;
                 
                 // Go through all types of tetrahedra to assign 6 of them per cell
                 for (size_t i = 0; i < 6; i++) {
                     // Go though all 4 indexies for each tetrahedra and assign the correct cell index, value and position.
                     for (size_t j = 0; j < 4; j++) {
-                        tetra.dataPoints[j] = c.dataPoints[tetrahedraIds[i][j]];
+                        tetrahedras[i].dataPoints[j] = c.dataPoints[tetrahedraIds[i][j]];
                     }
-                    
-                    // Save all 6 tetrahedra in the vector (the vector will contain 6 * 8 tetrahedras)
-                    tetrahedras.push_back(tetra);
                 }
                 
-                for (const Tetrahedra& tetrahedra : tetrahedras) {
+                for (const MarchingTetrahedra::Tetrahedra& tetrahedra : tetrahedras) {
                     // Step three: Calculate for tetra case index
-                    int caseId = 0;
-                    
-                    size_t tI0 = tetrahedra.dataPoints[0].index;
-                    size_t tI1 = tetrahedra.dataPoints[1].index;
-                    size_t tI2 = tetrahedra.dataPoints[2].index;
-                    size_t tI3 = tetrahedra.dataPoints[3].index;
-                    
-                    
-
-                    float tV0 = tetrahedra.dataPoints[0].value;
-                    float tV1 = tetrahedra.dataPoints[1].value;
-                    float tV2 = tetrahedra.dataPoints[2].value;
-                    float tV3 = tetrahedra.dataPoints[3].value;
-
-                    vec3 tPos0 = tetrahedra.dataPoints[0].pos;
-                    vec3 tPos1 = tetrahedra.dataPoints[1].pos;
-                    vec3 tPos2 = tetrahedra.dataPoints[2].pos;
-                    vec3 tPos3 = tetrahedra.dataPoints[3].pos;
-                    
-                    
-                    size_t i = 0;
-                    for(auto& t : tetrahedra.dataPoints) {
-                        if (t.value < iso) caseId += pow(2, i);
-                        i++;
+                    TNM067_PROFILE_STAGE_START(classificationTimer);
+                    const int caseId = tetrahedronCase(tetrahedra, iso);
+                    TNM067_PROFILE_STAGE_STOP(classificationTimer);
+                    if (caseId == 0 || caseId == 15) {
+                        continue;
                     }
+                    TNM067_PROFILE_COUNT(profile, ActiveTetrahedra, 1);
                     
                     // step four: Extract triangles
-                    
-                    switch (caseId) {
-                        case 0:
-                        case 15:
-                            break;
-                            
-                        case 1:
-                        case 14: {
-                            vec3 interpolatedValue0 = tPos0 + (tPos1 - tPos0) * (iso - tV0) / (tV1 - tV0);
-                            vec3 interpolatedValue1 = tPos0 + (tPos3 - tPos0) * (iso - tV0) / (tV3 - tV0);
-                            vec3 interpolatedValue2 = tPos0 + (tPos2 - tPos0) * (iso - tV0) / (tV2 - tV0);
-                            
-                            auto _tI0 = mesh.addVertex(interpolatedValue0, tI0, tI1);
-                            auto _tI1 = mesh.addVertex(interpolatedValue1, tI0, tI3);
-                            auto _tI2 = mesh.addVertex(interpolatedValue2, tI0, tI2);
-                            
-                            if (caseId == 1) {
-                                mesh.addTriangle(_tI0, _tI1, _tI2);
-                            } else {
-                                mesh.addTriangle(_tI0, _tI2, _tI1);
-                            }
-                            
-                            break;
-                        }
-                            
-                        case 2:
-                        case 13: {
-                            break;
-                        }
-                            
-                        case 3:
-                        case 12: {
-                            break;
-                        }
-                            
-                        case 4:
-                        case 11: {
-                            break;
-                        }
-                            
-                        case 5:
-                        case 10: {
-                            break;
-                        }
-                            
-                        case 6:
-                        case 9: {
-                            break;
-                        }
-                            
-                        case 7:
-                        case 8: {
-                            break;
+                    TNM067_PROFILE_STAGE_START(emissionTimer);
+                    emitTetrahedron(mesh, tetrahedra, caseId, iso);
+                    TNM067_PROFILE_STAGE_STOP(emissionTimer);
+                }
+            }
+        }
+    }
+    
+    
+    TNM067_PROFILE_COUNT(profile, CellsVisited, glm::compMul(end - begin));
+}
+
+/**
+ * Same as marchTetrahedra but triangulates each cell as a whole using the marching cubes tables
+ */
+template <typename Output, typename Sampler>
+void marchCubes(Output& mesh, size3_t dims, size3_t begin, size3_t end, float iso,
+                const Sampler& sample, TNM067::Profile* profile) {
+    using namespace TNM067::MarchingCubes;
+    
+    util::IndexMapper3D indexInVolume(dims);
+    
+    TNM067_PROFILE_STAGE(samplingTimer, profile, "Sampling");
+    TNM067_PROFILE_STAGE(classificationTimer, profile, "Classification");
+    TNM067_PROFILE_STAGE(emissionTimer, profile, "Triangle emission");
+    
+    MarchingTetrahedra::Cell c;
+    std::array<std::uint32_t, 12> edgeVertices;
+    
+    size3_t pos{};
+    for (pos.z = begin.z; pos.z < end.z; ++pos.z) {
+        for (pos.y = begin.y; pos.y < end.y; ++pos.y) {
+            for (pos.x = begin.x; pos.x < end.x; ++pos.x) {
+                TNM067_PROFILE_STAGE_START(classificationTimer);
+                const size_t caseId = cellCase(sample, pos);
+                const auto edges = edgeTable[caseId];
+                TNM067_PROFILE_STAGE_STOP(classificationTimer);
+                if (edges == 0) {
+                    continue;
+                }
+                TNM067_PROFILE_COUNT(profile, ActiveCells, 1);
+
+                TNM067_PROFILE_STAGE_START(samplingTimer);
+                for (size_t i = 0; i < 8; ++i) {
+                    const ivec3 cellPos((i & 1), (i >> 1) & 1, (i >> 2) & 1);
+                    const size3_t voxel = pos + size3_t(cellPos);
+                    c.dataPoints[i].pos =
+                        MarchingTetrahedra::calculateDataPointPos(pos, cellPos, dims);
+                    c.dataPoints[i].value = sample(voxel);
+                    c.dataPoints[i].index = indexInVolume(voxel);
+                }
+                TNM067_PROFILE_STAGE_STOP(samplingTimer);
+                
+                TNM067_PROFILE_STAGE_START(emissionTimer);
+                for (size_t e = 0; e < 12; ++e) {
+                    if ((edges & (1 << e)) == 0) continue;
+                    const auto& a = c.dataPoints[edgeCorners[e][0]];
+                    const auto& b = c.dataPoints[edgeCorners[e][1]];
+                    const float t = (iso - a.value) / (b.value - a.value);
+                    edgeVertices[e] =
+                        mesh.addVertex(a.pos + (b.pos - a.pos) * t, a.index, b.index, t);
+                }
+                const auto& triangles = triTable[caseId];
+                for (size_t t = 0; triangles[t] != -1; t += 3) {
+                    mesh.addTriangle(edgeVertices[triangles[t]], edgeVertices[triangles[t + 1]],
+                                     edgeVertices[triangles[t + 2]]);
+                }
+                TNM067_PROFILE_STAGE_STOP(emissionTimer);
+            }
+        }
+    }
+    
+    TNM067_PROFILE_COUNT(profile, CellsVisited, glm::compMul(end - begin));
+}
+
+/**
+ * Gradient of the volume at voxel in the normalized [0 1] coordinates of the mesh, using central
+ * differences within [lo, hi] and one-sided differences at its borders
+ */
+template <typename Sample>
+vec3 gradient(Sample sample, size3_t dims, size3_t voxel, size3_t lo, size3_t hi) {
+    vec3 g(0.0f);
+    for (size_t axis = 0; axis < 3; ++axis) {
+        size3_t prev = voxel;
+        size3_t next = voxel;
+        prev[axis] = voxel[axis] > lo[axis] ? voxel[axis] - 1 : voxel[axis];
+        next[axis] = voxel[axis] < hi[axis] ? voxel[axis] + 1 : voxel[axis];
+        if (next[axis] == prev[axis]) continue;
+        g[axis] = (sample(next) - sample(prev)) / static_cast<float>(next[axis] - prev[axis]) *
+                  static_cast<float>(dims[axis] - 1);
+    }
+    return g;
+}
+
+size3_t voxelFromIndex(size_t index, size3_t dims) {
+    return {index % dims.x, (index / dims.x) % dims.y, index / (dims.x * dims.y)};
+}
+
+template <typename Output, typename Sampler>
+void march(MarchingTetrahedra::Engine engine, Output& mesh, size3_t dims, size3_t begin,
+           size3_t end, float iso, const Sampler& sample, TNM067::Profile* profile) {
+    if (engine == MarchingTetrahedra::Engine::Cubes) {
+        marchCubes(mesh, dims, begin, end, iso, sample, profile);
+    } else {
+        marchTetrahedra(mesh, dims, begin, end, iso, sample, profile);
+    }
+}
+
+/**
+ * Output of the marching functions for extractToPLY, which writes every vertex and triangle to a
+ * TNM067::PLYStreamWriter as soon as it is created. Vertices are deduplicated within the two voxel
+ * slices of the current slab of cells only: edges in the bottom slice were shared with the
+ * previous slab, edges in the top slice are kept for the next one and edges between the slices
+ * are only seen by this slab. The normal of a vertex is the negated gradient interpolated along
+ * its edge, so a vertex is final when it is created.
+ */
+template <typename Sample>
+class SlabWriter {
+public:
+    SlabWriter(TNM067::PLYStreamWriter& writer, size3_t dims, Sample sample,
+               TNM067::Profile* profile)
+        : writer_(writer)
+        , dims_(dims)
+        , sample_(sample)
+#if TNM067_ENABLE_INSTRUMENTATION
+        , profile_(profile)
+#endif
+    {
+        static_cast<void>(profile);  // Only used with instrumentation
+    }
+
+    /// Starts the slab of cells between voxel slices z and z + 1
+    void beginSlab(size_t z) { topStart_ = (z + 1) * dims_.x * dims_.y; }
+
+    /// Writes the vertices and triangles of the slab and moves the window up one slice
+    void endSlab() {
+        writer_.flush();
+        std::swap(bottom_, top_);
+        top_.clear();
+        between_.clear();
+    }
+
+    std::uint32_t addVertex(vec3 pos, size_t i, size_t j, float t) {
+        if (j < i) {
+            std::swap(i, j);
+            t = 1.0f - t;
+        }
+        auto& edges = i >= topStart_ ? top_ : j < topStart_ ? bottom_ : between_;
+        if (const auto* vertex = edges.get({i, j})) {
+            TNM067_PROFILE_COUNT(profile(), VerticesDeduplicated, 1);
+            return *vertex;
+        }
+        const vec3 g = glm::mix(voxelGradient(i), voxelGradient(j), t);
+        const auto vertex = writer_.addVertex(pos, -g);
+        edges.tryEmplace({i, j}, vertex);
+        return vertex;
+    }
+
+    void addTriangle(size_t i0, size_t i1, size_t i2) {
+        writer_.addTriangle(static_cast<std::uint32_t>(i0), static_cast<std::uint32_t>(i1),
+                            static_cast<std::uint32_t>(i2));
+    }
+
+private:
+    using EdgeMap = TNM067::FlatHashMap<std::pair<size_t, size_t>, std::uint32_t,
+                                        MarchingTetrahedra::HashFunc>;
+
+    /// The profile to record to, always null when instrumentation is compiled out
+    TNM067::Profile* profile() const {
+#if TNM067_ENABLE_INSTRUMENTATION
+        return profile_;
+#else
+        return nullptr;
+#endif
+    }
+
+    vec3 voxelGradient(size_t index) const {
+        return gradient(sample_, dims_, voxelFromIndex(index, dims_), size3_t(0),
+                        dims_ - size3_t(1));
+    }
+
+    TNM067::PLYStreamWriter& writer_;
+    size3_t dims_;
+    Sample sample_;
+#if TNM067_ENABLE_INSTRUMENTATION
+    TNM067::Profile* profile_;
+#endif
+    size_t topStart_ = 0;  //!< Index of the first voxel of the top slice
+    EdgeMap bottom_;
+    EdgeMap between_;
+    EdgeMap top_;
+};
+
+/**
+ * Marches the active leaves of an octree. Every leaf is split into tetrahedra spanned by its center
+ * and a triangulation of each of its faces. A face is split into four like the finer leaves across
+ * it, and edges touched by finer leaves get their midpoint, so the two leaves sharing a face always
+ * triangulate it the same way and the surface has no cracks between levels. Larger leaves use the
+ * voxel at their center, single cells the average of their corners. Returns false if control was
+ * stopped.
+ */
+template <typename Sample>
+bool marchOctree(MarchingTetrahedra::MeshHelper& mesh, const TNM067::IsoOctree& octree, float iso,
+                 Sample sample, TNM067::Profile* profile, const TNM067::JobControl* control) {
+    const size3_t dims = octree.getDimensions();
+    util::IndexMapper3D indexInVolume(dims);
+    const size_t voxelCount = glm::compMul(dims);
+
+    TNM067_PROFILE_STAGE(classificationTimer, profile, "Classification");
+    TNM067_PROFILE_STAGE(emissionTimer, profile, "Triangle emission");
+
+    auto dataPoint = [&](size3_t voxel) {
+        return MarchingTetrahedra::DataPoint{
+            MarchingTetrahedra::calculateDataPointPos(voxel, ivec3(0), dims), sample(voxel),
+            indexInVolume(voxel)};
+    };
+
+    // The first corner is the center of the current leaf
+    MarchingTetrahedra::Tetrahedra tetrahedra;
+    auto tetrahedron = [&](size3_t a, size3_t b, size3_t c) {
+        tetrahedra.dataPoints[1] = dataPoint(a);
+        tetrahedra.dataPoints[2] = dataPoint(b);
+        tetrahedra.dataPoints[3] = dataPoint(c);
+        TNM067_PROFILE_STAGE_START(classificationTimer);
+        const int caseId = tetrahedronCase(tetrahedra, iso);
+        TNM067_PROFILE_STAGE_STOP(classificationTimer);
+        if (caseId == 0 || caseId == 15) return;
+        TNM067_PROFILE_COUNT(profile, ActiveTetrahedra, 1);
+
+        TNM067_PROFILE_STAGE_START(emissionTimer);
+        emitTetrahedron(mesh, tetrahedra, caseId, iso);
+        TNM067_PROFILE_STAGE_STOP(emissionTimer);
+    };
+    // Corners in order around the square, always split along the diagonal from the first corner,
+    // the one with the smallest coordinates, so both sides of a face pick the same diagonal
+    auto square = [&](size3_t a, size3_t b, size3_t c, size3_t d) {
+        tetrahedron(a, b, c);
+        tetrahedron(a, c, d);
+    };
+
+    const auto& leaves = octree.getLeaves();
+    for (size_t l = 0; l < leaves.size(); ++l) {
+        if (control && l % 4096 == 0) {
+            if (control->stopped()) return false;
+            control->progress(l, leaves.size());
+        }
+        const auto& leaf = leaves[l];
+        if (!leaf.active) continue;
+        const size_t size = leaf.size();
+
+        auto& center = tetrahedra.dataPoints[0];
+        if (size == 1) {
+            center.value = 0.0f;
+            for (size_t i = 0; i < 8; ++i) {
+                center.value += sample(leaf.origin + size3_t(i & 1, (i >> 1) & 1, (i >> 2) & 1));
+            }
+            center.value /= 8.0f;
+            center.pos = (vec3(leaf.origin) + vec3(0.5f)) / vec3(dims - size3_t(1));
+            center.index = voxelCount + indexInVolume(leaf.origin);
+        } else {
+            center = dataPoint(leaf.origin + size3_t(size / 2));
+        }
+
+        for (size_t axis = 0; axis < 3; ++axis) {
+            const size_t u = (axis + 1) % 3;
+            const size_t v = (axis + 2) % 3;
+            ivec3 du(0);
+            ivec3 dv(0);
+            du[u] = 1;
+            dv[v] = 1;
+
+            for (size_t side = 0; side < 2; ++side) {
+                ivec3 across(0);
+                across[axis] = side == 0 ? -1 : 1;
+
+                // Point on the face, i and j in half leaf sizes along u and v
+                auto point = [&](size_t i, size_t j) {
+                    size3_t p = leaf.origin;
+                    p[axis] += side * size;
+                    p[u] += i * size / 2;
+                    p[v] += j * size / 2;
+                    return p;
+                };
+
+                if (octree.isSplit(leaf, across)) {
+                    for (size_t j = 0; j < 2; ++j) {
+                        for (size_t i = 0; i < 2; ++i) {
+                            square(point(i, j), point(i + 1, j), point(i + 1, j + 1),
+                                   point(i, j + 1));
                         }
                     }
+                    continue;
+                }
+
+                // The edges of the face in order around it, an edge is split if any of the other
+                // nodes at this level sharing it is split
+                const std::array<ivec3, 4> towardsEdge{-dv, du, dv, -du};
+                const std::array<size3_t, 4> corners{point(0, 0), point(2, 0), point(2, 2),
+                                                     point(0, 2)};
+                const std::array<size3_t, 4> midpoints{point(1, 0), point(2, 1), point(1, 2),
+                                                       point(0, 1)};
+                std::array<bool, 4> edgeSplit;
+                for (size_t k = 0; k < 4; ++k) {
+                    edgeSplit[k] = octree.isSplit(leaf, towardsEdge[k]) ||
+                                   octree.isSplit(leaf, across + towardsEdge[k]);
+                }
+                if (std::none_of(edgeSplit.begin(), edgeSplit.end(), [](bool b) { return b; })) {
+                    square(corners[0], corners[1], corners[2], corners[3]);
+                    continue;
+                }
+
+                // Fan around the face center through the corners and the split edge midpoints
+                const size3_t faceCenter = point(1, 1);
+                for (size_t k = 0; k < 4; ++k) {
+                    const auto& next = corners[(k + 1) % 4];
+                    if (edgeSplit[k]) {
+                        tetrahedron(faceCenter, corners[k], midpoints[k]);
+                        tetrahedron(faceCenter, midpoints[k], next);
+                    } else {
+                        tetrahedron(faceCenter, corners[k], next);
+                    }
                 }
             }
         }
     }
+
+    TNM067_PROFILE_COUNT(profile, ActiveCells, octree.getActiveLeafCount());
+    return true;
+}
+
+}  // namespace
+
+std::shared_ptr<BasicMesh> MarchingTetrahedra::extract(std::shared_ptr<const Volume> vol,
+                                                       float iso, Engine engine,
+                                                       Normals normals, TNM067::Profile* profile,
+                                                       TNM067::BufferPool* pool,
+                                                       const TNM067::JobControl* control) {
+    TNM067_PROFILE_SCOPE(profile, "Extract");
+    auto volume = vol->getRepresentation<VolumeRAM>();
+    MeshHelper mesh(vol, normals, profile, pool);
+    
+    const auto& dims = volume->getDimensions();
+    
+    // The voxels are read as stored, the iso value is mapped to them instead
+    const float isoData = isoInData(*vol, iso);
+    auto marchTyped = [&](const auto vrprecision) {
+        using T = util::PrecisionValueType<decltype(vrprecision)>;
+        const VoxelSampler<T> sample(vrprecision->getDataTyped(), size3_t(0), dims, isoData);
+        const size3_t cells = dims - size3_t(1);
+        if (!control) {
+            march(engine, mesh, dims, size3_t(0), cells, isoData, sample, profile);
+        } else {
+            // One slice of cells at a time to check control in between
+            for (size_t z = 0; z < cells.z; ++z) {
+                if (control->stopped()) return false;
+                march(engine, mesh, dims, size3_t(0, 0, z), size3_t(cells.x, cells.y, z + 1),
+                      isoData, sample, profile);
+                control->progress(z + 1, cells.z);
+            }
+        }
+        
+        if (normals == Normals::Gradient) {
+            mesh.computeGradientNormals(0, [&](size_t index) {
+                return gradient(sample, dims, voxelFromIndex(index, dims), size3_t(0),
+                                dims - size3_t(1));
+            });
+        }
+        return true;
+    };
+    if (!volume->dispatch<bool, dispatching::filter::Scalars>(marchTyped)) return nullptr;
     
-    mesh_.setData(mesh.toBasicMesh());
+    return mesh.toBasicMesh();
+}
+
+bool MarchingTetrahedra::extractToPLY(std::shared_ptr<const Volume> vol, float iso,
+                                      const std::string& path, Engine engine,
+                                      TNM067::Profile* profile,
+                                      const TNM067::JobControl* control) {
+    TNM067_PROFILE_SCOPE(profile, "Extract to file");
+    auto volume = vol->getRepresentation<VolumeRAM>();
+    const auto& dims = volume->getDimensions();
+
+    TNM067::PLYStreamWriter writer(path, vol->getWorldMatrix() * vol->getModelMatrix());
+    const float isoData = isoInData(*vol, iso);
+    return volume->dispatch<bool, dispatching::filter::Scalars>([&](const auto vrprecision) {
+        using T = util::PrecisionValueType<decltype(vrprecision)>;
+        const VoxelSampler<T> sample(vrprecision->getDataTyped(), size3_t(0), dims, isoData);
+        SlabWriter<VoxelSampler<T>> slabs(writer, dims, sample, profile);
+
+        const size3_t cells = dims - size3_t(1);
+        for (size_t z = 0; z < cells.z; ++z) {
+            if (control && control->stopped()) return false;
+            slabs.beginSlab(z);
+            march(engine, slabs, dims, size3_t(0, 0, z), size3_t(cells.x, cells.y, z + 1),
+                  isoData, sample, profile);
+            slabs.endSlab();
+            if (control) control->progress(z + 1, cells.z);
+        }
+        writer.finish();
+        return true;
+    });
+}
+
+std::shared_ptr<BasicMesh> MarchingTetrahedra::extractAdaptive(std::shared_ptr<const Volume> vol,
+                                                               float iso, float maxError,
+                                                               Normals normals,
+                                                               TNM067::Profile* profile,
+                                                               TNM067::BufferPool* pool,
+                                                               const TNM067::JobControl* control) {
+    TNM067_PROFILE_SCOPE(profile, "Extract adaptive");
+    auto volume = vol->getRepresentation<VolumeRAM>();
+    MeshHelper mesh(vol, normals, profile, pool);
+
+    const auto& dims = volume->getDimensions();
+    const size_t voxelCount = glm::compMul(dims);
+
+    // The octree and the marching read the voxels as stored, iso and maxError are mapped to them
+    const float isoData = isoInData(*vol, iso);
+    const float maxErrorData = std::abs(isoInData(*vol, iso + maxError) - isoData);
+    const auto octree = TNM067::IsoOctree::build(*volume, isoData, maxErrorData, profile);
+    auto marchTyped = [&](const auto vrprecision) {
+        using T = util::PrecisionValueType<decltype(vrprecision)>;
+        const VoxelSampler<T> sample(vrprecision->getDataTyped(), size3_t(0), dims, isoData);
+        if (!marchOctree(mesh, octree, isoData, sample, profile, control)) return false;
+
+        if (normals == Normals::Gradient) {
+            auto voxelGradient = [&](size3_t voxel) {
+                return gradient(sample, dims, voxel, size3_t(0), dims - size3_t(1));
+            };
+            mesh.computeGradientNormals(0, [&](size_t index) {
+                if (index < voxelCount) return voxelGradient(voxelFromIndex(index, dims));
+
+                // Center of a single cell, see marchOctree
+                const size3_t cell = voxelFromIndex(index - voxelCount, dims);
+                vec3 g(0.0f);
+                for (size_t i = 0; i < 8; ++i) {
+                    g += voxelGradient(cell + size3_t(i & 1, (i >> 1) & 1, (i >> 2) & 1));
+                }
+                return g / 8.0f;
+            });
+        }
+        return true;
+    };
+    if (!volume->dispatch<bool, dispatching::filter::Scalars>(marchTyped)) return nullptr;
+
+    return mesh.toBasicMesh();
+}
+
+std::shared_ptr<BasicMesh> MarchingTetrahedra::extract(const TNM067::BrickedVolume& vol, float iso,
+                                                       Engine engine, Normals normals,
+                                                       TNM067::Profile* profile,
+                                                       TNM067::BufferPool* pool,
+                                                       const TNM067::JobControl* control) {
+    TNM067_PROFILE_SCOPE(profile, "Extract bricked");
+    MeshHelper mesh(vol.modelMatrix, vol.worldMatrix, normals, profile, pool);
+    
+    const auto dims = vol.getDimensions();
+    
+    const size_t stored = vol.getStoredSize();
+    const size3_t brickCount = vol.getBrickCount();
+    std::vector<float> values;
+    size3_t brick{};
+    for (brick.z = 0; brick.z < brickCount.z; ++brick.z) {
+        for (brick.y = 0; brick.y < brickCount.y; ++brick.y) {
+            for (brick.x = 0; brick.x < brickCount.x; ++brick.x) {
+                if (control) {
+                    if (control->stopped()) return nullptr;
+                    control->progress(brick.x + brickCount.x * (brick.y + brickCount.y * brick.z),
+                                      glm::compMul(brickCount));
+                }
+                // Only bricks the iso surface passes through are decompressed
+                if (!vol.intersects(brick, iso)) continue;
+                
+                vol.decompress(brick, values);
+                const size3_t origin = vol.getBrickOrigin(brick);
+                const size3_t end = glm::min(origin + size3_t(vol.getBrickSize()), dims - size3_t(1));
+                const VoxelSampler<float> sample(values.data(), origin, size3_t(stored), iso);
+                const size_t firstVertex = mesh.getVertexCount();
+                march(engine, mesh, dims, origin, end, iso, sample, profile);
+                
+                // Vertices are computed while their brick is decompressed, differences are
+                // one-sided at the brick borders
+                if (normals == Normals::Gradient) {
+                    mesh.computeGradientNormals(firstVertex, [&](size_t index) {
+                        return gradient(sample, dims, voxelFromIndex(index, dims), origin,
+                                        glm::min(origin + size3_t(stored - 1), dims - size3_t(1)));
+                    });
+                }
+            }
+        }
+    }
+    
+    return mesh.toBasicMesh();
 }
 
 int MarchingTetrahedra::calculateDataPointIndexInCell(ivec3 index3D) {
@@ -231,13 +956,40 @@ vec3 MarchingTetrahedra::calculateDataPointPos(size3_t posVolume, ivec3 posCell,
     return vec3(x, y, z);
 }
 
-MarchingTetrahedra::MeshHelper::MeshHelper(std::shared_ptr<const Volume> vol)
-: edgeToVertex_()
-, vertices_()
-, mesh_(std::make_shared<BasicMesh>())
-, indexBuffer_(mesh_->addIndexBuffer(DrawType::Triangles, ConnectivityType::None)) {
-    mesh_->setModelMatrix(vol->getModelMatrix());
-    mesh_->setWorldMatrix(vol->getWorldMatrix());
+MarchingTetrahedra::MeshHelper::MeshHelper(std::shared_ptr<const Volume> vol, Normals normals,
+                                           TNM067::Profile* profile, TNM067::BufferPool* pool)
+: MeshHelper(vol->getModelMatrix(), vol->getWorldMatrix(), normals, profile, pool) {}
+
+MarchingTetrahedra::MeshHelper::MeshHelper(const mat4& modelMatrix, const mat4& worldMatrix,
+                                           Normals normals, TNM067::Profile* profile,
+                                           TNM067::BufferPool* pool)
+: normals_(normals)
+, ownStorage_(pool ? nullptr : std::make_unique<Storage>())
+, storage_(pool ? pool->scratch<Storage>() : *ownStorage_)
+, vertexEdges_(storage_.vertexEdges)
+, edgeToVertex_(storage_.edgeToVertex)
+, vertices_(storage_.vertices)
+, mesh_(pool ? pool->mesh<BasicMesh>() : std::make_shared<BasicMesh>())
+, indexBuffer_(nullptr)
+#if TNM067_ENABLE_INSTRUMENTATION
+, profile_(profile)
+, dedupTimer_(profile, "Vertex dedup")
+#endif
+{
+    static_cast<void>(profile);  // Only used with instrumentation
+
+    // Pooled storage still holds the previous extraction
+    vertexEdges_.clear();
+    edgeToVertex_.clear();
+    vertices_.clear();
+    
+    // A reused mesh already has its (emptied) index buffer
+    if (mesh_->getNumberOfIndicies() == 0) {
+        mesh_->addIndexBuffer(DrawType::Triangles, ConnectivityType::None);
+    }
+    indexBuffer_ = mesh_->getIndexBuffers().front().second->getEditableRAMRepresentation();
+    mesh_->setModelMatrix(modelMatrix);
+    mesh_->setWorldMatrix(worldMatrix);
 }
 
 void MarchingTetrahedra::MeshHelper::addTriangle(size_t i0, size_t i1, size_t i2) {
@@ -249,34 +1001,56 @@ void MarchingTetrahedra::MeshHelper::addTriangle(size_t i0, size_t i1, size_t i2
     indexBuffer_->add(static_cast<glm::uint32_t>(i1));
     indexBuffer_->add(static_cast<glm::uint32_t>(i2));
     
+    if (normals_ == Normals::Gradient) {
+        return;
+    }
+    
     const auto a = std::get<0>(vertices_[i0]);
     const auto b = std::get<0>(vertices_[i1]);
     const auto c = std::get<0>(vertices_[i2]);
     
-    const vec3 n = glm::normalize(glm::cross(b - a, c - a));
+    // Degenerate triangles have no normal and do not contribute
+    const vec3 cross = glm::cross(b - a, c - a);
+    const float length = glm::length(cross);
+    if (length == 0.0f) return;
+    
+    const vec3 n = cross / length;
     std::get<1>(vertices_[i0]) += n;
     std::get<1>(vertices_[i1]) += n;
     std::get<1>(vertices_[i2]) += n;
 }
 
 std::shared_ptr<BasicMesh> MarchingTetrahedra::MeshHelper::toBasicMesh() {
-    for (auto& vertex : vertices_) {
-        // Normalize the normal of the vertex
-        std::get<1>(vertex) = glm::normalize(std::get<1>(vertex));
+    if (normals_ == Normals::Faces) {
+        TNM067_PROFILE_SCOPE(profile(), "Normal normalization");
+        for (auto& vertex : vertices_) {
+            // Normalize the normal of the vertex
+            const float length = glm::length(std::get<1>(vertex));
+            if (length > 0.0f) std::get<1>(vertex) /= length;
+        }
     }
     mesh_->addVertices(vertices_);
     return mesh_;
 }
 
-std::uint32_t MarchingTetrahedra::MeshHelper::addVertex(vec3 pos, size_t i, size_t j) {
+std::uint32_t MarchingTetrahedra::MeshHelper::addVertex(vec3 pos, size_t i, size_t j, float t) {
     IVW_ASSERT(i != j, "i and j should not be the same value");
-    if (j < i) std::swap(i, j);
+    if (j < i) {
+        std::swap(i, j);
+        t = 1.0f - t;
+    }
     
-    auto [edgeIt, inserted] = edgeToVertex_.try_emplace(std::make_pair(i, j), vertices_.size());
+    TNM067_PROFILE_STAGE_START(dedupTimer_);
+    auto [vertex, inserted] = edgeToVertex_.tryEmplace(std::make_pair(i, j), vertices_.size());
     if (inserted) {
         vertices_.push_back({pos, vec3(0, 0, 0), pos, vec4(0.7f, 0.7f, 0.7f, 1.0f)});
+        if (normals_ == Normals::Gradient) vertexEdges_.push_back({i, j, t});
+    } else {
+        TNM067_PROFILE_COUNT(profile(), VerticesDeduplicated, 1);
     }
-    return static_cast<std::uint32_t>(edgeIt->second);
+    TNM067_PROFILE_COUNT(profile(), HashLookups, 1);
+    TNM067_PROFILE_STAGE_STOP(dedupTimer_);
+    return static_cast<std::uint32_t>(vertex);
 }
 
 }  // namespace inviwo
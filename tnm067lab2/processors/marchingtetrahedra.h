@@ -1,24 +1,62 @@
 #pragma once
 
 #include <modules/tnm067lab2/tnm067lab2moduledefine.h>
-#include <inviwo/core/processors/processor.h>
+#include <inviwo/core/processors/poolprocessor.h>
 #include <inviwo/core/properties/ordinalproperty.h>
+#include <inviwo/core/properties/optionproperty.h>
+#include <inviwo/core/properties/boolproperty.h>
 #include <inviwo/core/ports/imageport.h>
 #include <inviwo/core/ports/volumeport.h>
 #include <inviwo/core/ports/meshport.h>
 #include <inviwo/core/datastructures/geometry/basicmesh.h>
+#include <modules/tnm067lab1/properties/profilingproperty.h>
+#include <modules/tnm067lab1/properties/meshcacheproperty.h>
+#include <modules/tnm067lab2/utils/brickedvolume.h>
+#include <modules/tnm067lab1/utils/parallelutils.h>
+#include <modules/tnm067lab1/utils/bufferpool.h>
+#include <modules/tnm067lab1/utils/flathashmap.h>
+#include <modules/tnm067lab1/utils/jobcontrol.h>
+#include <inviwo/core/ports/datainport.h>
+
+#include <cstdint>
 
 namespace inviwo {
 
-class IVW_MODULE_TNM067LAB2_API MarchingTetrahedra : public Processor {
+/**
+ * \class MarchingTetrahedra
+ * \brief Extracts the iso surface of a dense or brick-compressed volume.
+ * With Run in Background set the surface is extracted on the thread pool. A new volume or property
+ * change stops the job in flight and the previous mesh stays on the outport until the new one is
+ * done.
+ */
+class IVW_MODULE_TNM067LAB2_API MarchingTetrahedra : public PoolProcessor {
 public:
+    /**
+     * Tetrahedra splits every cell into six tetrahedra, Cubes triangulates the cells directly
+     * using the marching cubes tables which gives fewer triangles
+     */
+    enum class Engine { Tetrahedra, Cubes };
+
+    /**
+     * Faces accumulates the normals of the triangles around each vertex, Gradient uses the
+     * negated volume gradient interpolated along the edge of each vertex
+     */
+    enum class Normals { Faces, Gradient };
+
+    /**
+     * Hash of an edge given by the indices of its two DataPoints. Stateless, so extractions running
+     * at the same time do not affect each other's maps.
+     */
     struct HashFunc {
-        static size_t max;
         size_t operator()(std::pair<size_t, size_t> p) const {
-            size_t asdf;
-            asdf = p.first;
-            asdf += p.second * max;
-            return std::hash<size_t>{}(asdf);
+            return static_cast<size_t>(mix(mix(p.first) ^ p.second));
+        }
+
+        /// Finalizer of splitmix64
+        static std::uint64_t mix(std::uint64_t x) {
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+            return x ^ (x >> 31);
         }
     };
 
@@ -38,7 +76,15 @@ public:
 
     struct MeshHelper {
 
-        MeshHelper(std::shared_ptr<const Volume> vol);
+        /**
+         * With a pool, the vertex storage, the edge hash map and the mesh are taken from the pool,
+         * so repeated extractions of similar size do not allocate
+         */
+        MeshHelper(std::shared_ptr<const Volume> vol, Normals normals = Normals::Faces,
+                   TNM067::Profile* profile = nullptr, TNM067::BufferPool* pool = nullptr);
+        MeshHelper(const mat4& modelMatrix, const mat4& worldMatrix,
+                   Normals normals = Normals::Faces, TNM067::Profile* profile = nullptr,
+                   TNM067::BufferPool* pool = nullptr);
 
         /**
          * Adds a vertex to the mesh. The input parameters i and j are the DataPoint-indices of the two
@@ -50,16 +96,68 @@ public:
          * @param pos spatial position of the vertex
          * @param i DataPoint index of first DataPoint of the edge
          * @param j DataPoint index of second DataPoint of the edge
+         * @param t position of the vertex along the edge from i to j, used for gradient normals
          */
-        std::uint32_t addVertex(vec3 pos, size_t i, size_t j);
+        std::uint32_t addVertex(vec3 pos, size_t i, size_t j, float t = 0.5f);
         void addTriangle(size_t i0, size_t i1, size_t i2);
         std::shared_ptr<BasicMesh> toBasicMesh();
 
+        size_t getVertexCount() const { return vertices_.size(); }
+
+        /**
+         * Sets the normals of the vertices from first and onwards to the negated gradient,
+         * interpolated between the gradients at the two DataPoints of the edge of each vertex.
+         * gradient(index) returns the gradient at a DataPoint index, it is called in parallel.
+         * Only used with Normals::Gradient.
+         */
+        template <typename Gradient>
+        void computeGradientNormals(size_t first, Gradient gradient) {
+            TNM067_PROFILE_SCOPE(profile(), "Gradient normals");
+            TNM067::forEachRangeParallel(vertices_.size() - first, [&](size_t begin, size_t end,
+                                                                       size_t) {
+                for (size_t v = first + begin; v < first + end; ++v) {
+                    const auto& edge = vertexEdges_[v];
+                    const vec3 g = glm::mix(gradient(edge.i), gradient(edge.j), edge.t);
+                    const float length = glm::length(g);
+                    std::get<1>(vertices_[v]) = length > 0.0f ? -g / length : vec3(0.0f);
+                }
+            });
+        }
+
     private:
-        std::unordered_map<std::pair<size_t, size_t>, size_t, HashFunc> edgeToVertex_;
-        std::vector<BasicMesh::Vertex> vertices_;
+        struct VertexEdge {
+            size_t i;
+            size_t j;
+            float t;
+        };
+
+        struct Storage {
+            std::vector<VertexEdge> vertexEdges;
+            TNM067::FlatHashMap<std::pair<size_t, size_t>, size_t, HashFunc> edgeToVertex;
+            std::vector<BasicMesh::Vertex> vertices;
+        };
+
+        Normals normals_;
+        std::unique_ptr<Storage> ownStorage_;  //!< Only used without a pool
+        Storage& storage_;
+        std::vector<VertexEdge>& vertexEdges_;
+        TNM067::FlatHashMap<std::pair<size_t, size_t>, size_t, HashFunc>& edgeToVertex_;
+        std::vector<BasicMesh::Vertex>& vertices_;
+        /// The profile to record to, always null when instrumentation is compiled out
+        TNM067::Profile* profile() const {
+#if TNM067_ENABLE_INSTRUMENTATION
+            return profile_;
+#else
+            return nullptr;
+#endif
+        }
+
         std::shared_ptr<BasicMesh> mesh_;
-        std::shared_ptr<IndexBufferRAM> indexBuffer_;
+        IndexBufferRAM* indexBuffer_;
+#if TNM067_ENABLE_INSTRUMENTATION
+        TNM067::Profile* profile_;
+        TNM067::StageTimer dedupTimer_;
+#endif
     };
 
     MarchingTetrahedra();
@@ -74,14 +172,87 @@ public:
 
     virtual void process() override;
 
+    /**
+     * Extracts the iso surface of vol at iso value iso. Cells are classified on the voxels as
+     * stored, integer volumes against iso mapped to their data range, and only the voxels of
+     * cells the surface passes through are converted. This is what process() runs, exposed to
+     * allow running it outside of a processor network. The mesh and temporaries are taken from
+     * pool if given. Returns nullptr if control is stopped, which is checked once per z-slice of
+     * cells.
+     */
+    static std::shared_ptr<BasicMesh> extract(std::shared_ptr<const Volume> vol, float iso,
+                                              Engine engine = Engine::Tetrahedra,
+                                              Normals normals = Normals::Faces,
+                                              TNM067::Profile* profile = nullptr,
+                                              TNM067::BufferPool* pool = nullptr,
+                                              const TNM067::JobControl* control = nullptr);
+
+    /**
+     * Extracts the iso surface of vol like extract() but writes it to a binary PLY file at path
+     * one z-slab of cells at a time instead of building a mesh. Vertices are only deduplicated
+     * against the vertices of the slabs next to them and normals are always the volume gradient,
+     * so the memory used does not depend on the size of the surface. Returns false if control is
+     * stopped, which is checked once per slab, the incomplete file is then removed.
+     * @throw FileException if the file could not be written
+     */
+    static bool extractToPLY(std::shared_ptr<const Volume> vol, float iso, const std::string& path,
+                             Engine engine = Engine::Tetrahedra,
+                             TNM067::Profile* profile = nullptr,
+                             const TNM067::JobControl* control = nullptr);
+
+    /**
+     * Extracts the iso surface of vol from the leaves of a TNM067::IsoOctree instead of every cell.
+     * Only octree nodes whose value range contains iso are refined, and refinement stops where
+     * the volume is within maxError (in the value range) of trilinear interpolation across the node.
+     * Leaves of different size are triangulated to match along shared faces, so the surface is
+     * free of cracks. control is checked after building the octree and then once per batch of
+     * leaves.
+     */
+    static std::shared_ptr<BasicMesh> extractAdaptive(std::shared_ptr<const Volume> vol, float iso,
+                                                      float maxError,
+                                                      Normals normals = Normals::Faces,
+                                                      TNM067::Profile* profile = nullptr,
+                                                      TNM067::BufferPool* pool = nullptr,
+                                                      const TNM067::JobControl* control = nullptr);
+
+    /**
+     * Extracts the iso surface of a brick-compressed volume. Only the bricks whose value range
+     * contains iso are decompressed, one at a time. control is checked once per brick.
+     */
+    static std::shared_ptr<BasicMesh> extract(const TNM067::BrickedVolume& vol, float iso,
+                                              Engine engine = Engine::Tetrahedra,
+                                              Normals normals = Normals::Faces,
+                                              TNM067::Profile* profile = nullptr,
+                                              TNM067::BufferPool* pool = nullptr,
+                                              const TNM067::JobControl* control = nullptr);
+
     virtual const ProcessorInfo getProcessorInfo() const override;
     static const ProcessorInfo processorInfo_;
 
 private:
+    /**
+     * Puts the mesh of extraction(profile, pool, control) on the outport, computed on the thread
+     * pool if background_ is set. store(mesh) is called with every new mesh on the thread that
+     * computed it.
+     */
+    template <typename Extraction, typename Store>
+    void run(Extraction extraction, Store store);
+
     VolumeInport volume_;
+    DataInport<TNM067::BrickedVolume> bricks_;
     MeshOutport mesh_;
 
     FloatProperty isoValue_;
+    TemplateOptionProperty<Engine> engine_;
+    TemplateOptionProperty<Normals> normals_;
+    BoolProperty adaptive_;  //!< Only used for dense volumes
+    FloatProperty adaptiveError_;
+    BoolProperty background_;
+    MeshCacheProperty meshCache_;
+    ProfilingProperty profiling_;
+    // Shared with the background jobs, which may outlive a process() call
+    std::shared_ptr<TNM067::BufferPool> pool_;
+    size_t generation_ = 0;  //!< Counts process() calls, results of older jobs are dropped
 };
 
 }  // namespace inviwo
@@ -0,0 +1,61 @@
+#include <modules/tnm067lab2/processors/meshdecimation.h>
+#include <modules/tnm067lab2/utils/quadricdecimation.h>
+#include <modules/tnm067lab2/utils/meshexport.h>
+
+#include <cmath>
+#include <limits>
+
+namespace inviwo {
+
+const ProcessorInfo MeshDecimation::processorInfo_{
+    "org.inviwo.MeshDecimation",  // Class identifier
+    "Mesh Decimation",            // Display name
+    "TNM067",                     // Category
+    CodeState::Experimental,      // Code state
+    Tags::CPU,                    // Tags
+};
+const ProcessorInfo MeshDecimation::getProcessorInfo() const { return processorInfo_; }
+
+MeshDecimation::MeshDecimation()
+    : Processor()
+    , inport_("mesh")
+    , outport_("decimated")
+    , targetRatio_("targetRatio", "Target Ratio", 0.1f, 0.0f, 1.0f, 0.01f)
+    , maxError_("maxError", "Max Error (0 = unlimited)", 0.0f, 0.0f, 1.0f, 0.0001f)
+    , info_("info", "Info", "")
+    , profiling_("profiling", "Profiling") {
+    addPort(inport_);
+    addPort(outport_);
+
+    info_.setReadOnly(true);
+    info_.setSerializationMode(PropertySerializationMode::None);
+
+    addProperty(targetRatio_);
+    addProperty(maxError_);
+    addProperty(info_);
+    addProperty(profiling_);
+}
+
+void MeshDecimation::process() {
+    auto mesh = inport_.getData();
+
+    const double maxError = maxError_.get() > 0.0f ? static_cast<double>(maxError_.get())
+                                                   : std::numeric_limits<double>::infinity();
+    const size_t inputTriangles = TNM067::collectTriangles(*mesh).size() / 3;
+    const auto target = static_cast<size_t>(std::round(inputTriangles * targetRatio_.get()));
+
+    TNM067::DecimationStats stats;
+    auto profile = profiling_.begin();
+    auto decimated = TNM067::decimate(*mesh, target, maxError, &stats, profile);
+    profiling_.end();
+
+    info_.set(std::to_string(stats.inputTriangles) + " -> " +
+              std::to_string(stats.outputTriangles) + " triangles, " +
+              std::to_string(stats.collapses) + " collapses, max error " +
+              std::to_string(stats.maxError) + ", " + std::to_string(stats.lockedVertices) +
+              " locked vertices");
+
+    outport_.setData(decimated);
+}
+
+}  // namespace inviwo
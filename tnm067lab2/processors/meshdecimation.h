@@ -0,0 +1,38 @@
+#pragma once
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <inviwo/core/processors/processor.h>
+#include <inviwo/core/properties/ordinalproperty.h>
+#include <inviwo/core/properties/stringproperty.h>
+#include <inviwo/core/ports/meshport.h>
+#include <modules/tnm067lab1/properties/profilingproperty.h>
+
+namespace inviwo {
+
+/**
+ * \class MeshDecimation
+ * \brief Simplifies a triangle mesh, e.g. the output of MarchingTetrahedra, with quadric error
+ * metric edge collapses. Collapses stop at the target ratio of the input triangles or when the
+ * error of the next collapse exceeds the max error, whichever comes first.
+ */
+class IVW_MODULE_TNM067LAB2_API MeshDecimation : public Processor {
+public:
+    MeshDecimation();
+    virtual ~MeshDecimation() = default;
+
+    virtual void process() override;
+
+    virtual const ProcessorInfo getProcessorInfo() const override;
+    static const ProcessorInfo processorInfo_;
+
+private:
+    MeshInport inport_;
+    MeshOutport outport_;
+
+    FloatProperty targetRatio_;
+    FloatProperty maxError_;
+    StringProperty info_;
+    ProfilingProperty profiling_;
+};
+
+}  // namespace inviwo
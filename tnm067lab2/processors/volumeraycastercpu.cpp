@@ -0,0 +1,349 @@
+#include <modules/tnm067lab2/processors/volumeraycastercpu.h>
+#include <modules/tnm067lab1/utils/parallelutils.h>
+#include <inviwo/core/datastructures/image/layerramprecision.h>
+#include <inviwo/core/datastructures/volume/volume.h>
+#include <inviwo/core/datastructures/volume/volumeramprecision.h>
+#include <inviwo/core/util/formatdispatching.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+namespace inviwo {
+
+const ProcessorInfo VolumeRaycasterCPU::processorInfo_{
+    "org.inviwo.VolumeRaycasterCPU",  // Class identifier
+    "Volume Raycaster CPU",           // Display name
+    "TNM067",                         // Category
+    CodeState::Experimental,          // Code state
+    Tags::CPU,                        // Tags
+};
+const ProcessorInfo VolumeRaycasterCPU::getProcessorInfo() const { return processorInfo_; }
+
+VolumeRaycasterCPU::VolumeRaycasterCPU()
+    : Processor()
+    , volume_("volume")
+    , outport_("outport")
+    , camera_("camera", "Camera")
+    , trackball_(&camera_)
+    , samplingRate_("samplingRate", "Sampling Rate", 2.0f, 0.25f, 8.0f, 0.25f)
+    , skipEmptySpace_("skipEmptySpace", "Empty Space Skipping", true)
+    , numColors_("numColors", "Number of colors", 3, 1, 10)
+    , colors_(
+          {FloatVec4Property{"color1", "Color 1", util::ordinalColor(0.0f, 0.0f, 0.0f, 0.0f)},
+           FloatVec4Property{"color2", "Color 2", util::ordinalColor(1.0f, 0.5f, 0.0f, 0.05f)},
+           FloatVec4Property{"color3", "Color 3", util::ordinalColor(1.0f, 1.0f, 1.0f, 0.5f)},
+           FloatVec4Property{"color4", "Color 4", util::ordinalColor(1.0f, 1.0f, 1.0f, 1.0f)},
+           FloatVec4Property{"color5", "Color 5", util::ordinalColor(1.0f, 1.0f, 1.0f, 1.0f)},
+           FloatVec4Property{"color6", "Color 6", util::ordinalColor(1.0f, 1.0f, 1.0f, 1.0f)},
+           FloatVec4Property{"color7", "Color 7", util::ordinalColor(1.0f, 1.0f, 1.0f, 1.0f)},
+           FloatVec4Property{"color8", "Color 8", util::ordinalColor(1.0f, 1.0f, 1.0f, 1.0f)},
+           FloatVec4Property{"color9", "Color 9", util::ordinalColor(1.0f, 1.0f, 1.0f, 1.0f)},
+           FloatVec4Property{"color10", "Color 10", util::ordinalColor(1.0f, 1.0f, 1.0f, 1.0f)}})
+    , profiling_("profiling", "Profiling") {
+    addPort(volume_);
+    addPort(outport_);
+    addProperty(camera_);
+    addProperty(trackball_);
+    addProperty(samplingRate_);
+    addProperty(skipEmptySpace_);
+
+    addProperty(numColors_);
+    for (auto& c : colors_) {
+        addProperty(c);
+    }
+    addProperty(profiling_);
+
+    auto colorVisibility = [&]() {
+        for (size_t i = 0; i < 10; i++) {
+            colors_[i].setVisible(i < numColors_);
+        }
+    };
+    numColors_.onChange(colorVisibility);
+    colorVisibility();
+}
+
+void VolumeRaycasterCPU::process() {
+    auto profile = profiling_.begin();
+    if (volume_.isChanged() || !prepared_) {
+        prepared_ = prepare(*volume_.getData(), profile);
+    }
+
+    ScalarToColorMapping map;
+    for (size_t i = 0; i < numColors_; ++i) {
+        map.addBaseColors(colors_[i].get());
+    }
+    outport_.setData(render(*prepared_, camera_.get(), map, outport_.getDimensions(),
+                            samplingRate_.get(), skipEmptySpace_.get(), profile, &pool_));
+    profiling_.end();
+}
+
+std::shared_ptr<const VolumeRaycasterCPU::PreparedVolume> VolumeRaycasterCPU::prepare(
+    const Volume& volume, TNM067::Profile* profile) {
+    TNM067_PROFILE_SCOPE(profile, "Prepare volume");
+    auto prepared = std::make_shared<PreparedVolume>();
+    const auto ram = volume.getRepresentation<VolumeRAM>();
+    const size3_t dims = ram->getDimensions();
+    prepared->dims = dims;
+    prepared->values.resize(glm::compMul(dims));
+
+    const dvec2 range = volume.dataMap_.dataRange;
+    const double scale = range.y > range.x ? 1.0 / (range.y - range.x) : 0.0;
+    ram->dispatch<void>([&](const auto rep) {
+        const auto data = rep->getDataTyped();
+        TNM067::forEachRangeParallel(prepared->values.size(), [&](size_t begin, size_t end,
+                                                                   size_t) {
+            for (size_t i = begin; i < end; ++i) {
+                const double v = static_cast<double>(util::glmcomp(data[i], 0));
+                prepared->values[i] = static_cast<float>((v - range.x) * scale);
+            }
+        });
+    });
+    prepared->macrocells =
+        TNM067::MacrocellGrid::build(prepared->values.data(), dims, macrocellSize, profile);
+
+    // Texture coordinates [0 1] span the volume, with voxel centers at (i + 0.5) / dims
+    prepared->worldToVoxel = glm::translate(vec3(-0.5f)) * glm::scale(vec3(dims)) *
+                             glm::inverse(volume.getWorldMatrix() * volume.getModelMatrix());
+    TNM067_PROFILE_COUNT(profile, VoxelsProcessed, prepared->values.size());
+    return prepared;
+}
+
+namespace {
+
+/**
+ * Transfer function lookup table with premultiplied and opacity corrected colors, and a prefix
+ * count of the visible entries to tell if a value range is fully transparent.
+ */
+struct TransferFunction {
+    static constexpr size_t size = 1024;
+
+    TransferFunction(const ScalarToColorMapping& map, float stepLength)
+        : colors(size), visible(size + 1, 0) {
+        for (size_t i = 0; i < size; ++i) {
+            const vec4 c = map.sample(static_cast<float>(i) / static_cast<float>(size - 1));
+            const float alpha = 1.0f - std::pow(1.0f - glm::clamp(c.a, 0.0f, 1.0f), stepLength);
+            colors[i] = vec4(vec3(c) * alpha, alpha);
+            visible[i + 1] = visible[i] + (alpha > 0.0f ? 1 : 0);
+        }
+    }
+
+    static size_t index(float value) {
+        const float entry = value * static_cast<float>(size - 1) + 0.5f;
+        if (!(entry > 0.0f)) return 0;  // Also NaN
+        return std::min(static_cast<size_t>(entry), size - 1);
+    }
+
+    /// True if every value in range maps to a fully transparent entry
+    bool transparent(vec2 range) const {
+        return visible[index(range.y) + 1] == visible[index(range.x)];
+    }
+
+    std::vector<vec4> colors;
+    std::vector<std::uint32_t> visible;
+};
+
+/**
+ * Rays of a packet, one array element per lane. Positions and directions are in voxel space with
+ * unit length directions, so t is the distance in voxels.
+ */
+struct Packet {
+    using Lanes = std::array<float, VolumeRaycasterCPU::packetSize>;
+    Lanes ox, oy, oz;
+    Lanes dx, dy, dz;
+    Lanes tNear, tFar;
+    Lanes step;  //!< Index of the next sample, at tNear + step * stepLength
+    Lanes r, g, b, a;
+    std::array<bool, VolumeRaycasterCPU::packetSize> active;
+};
+
+}  // namespace
+
+std::shared_ptr<Image> VolumeRaycasterCPU::render(const PreparedVolume& volume,
+                                                  const Camera& camera,
+                                                  const ScalarToColorMapping& map, size2_t size,
+                                                  float samplingRate, bool skipEmptySpace,
+                                                  TNM067::Profile* profile,
+                                                  TNM067::BufferPool* pool) {
+    TNM067_PROFILE_SCOPE(profile, "Raycast");
+    constexpr size_t N = packetSize;
+    const float stepLength = 1.0f / samplingRate;
+    const TransferFunction tf(map, stepLength);
+
+    const size3_t dims = volume.dims;
+    const size3_t cells = volume.macrocells.getDimensions();
+    const vec3 maxVoxel = vec3(dims - size3_t(1));
+    const float cellSize = static_cast<float>(volume.macrocells.getCellSize());
+
+    // Macrocells the transfer function makes fully transparent, none if not skipping
+    std::vector<std::uint8_t> empty(volume.macrocells.getRanges().size(), 0);
+    if (skipEmptySpace) {
+        const auto& ranges = volume.macrocells.getRanges();
+        for (size_t i = 0; i < ranges.size(); ++i) empty[i] = tf.transparent(ranges[i]) ? 1 : 0;
+    }
+
+    auto image = pool ? pool->image(size, DataVec4UInt8::get())
+                      : std::make_shared<Image>(size, DataVec4UInt8::get());
+    auto layer = static_cast<LayerRAMPrecision<glm::u8vec4>*>(
+        image->getColorLayer()->getEditableRepresentation<LayerRAM>());
+    glm::u8vec4* pixels = layer->getDataTyped();
+
+    const mat4 ndcToVoxel = volume.worldToVoxel *
+                            glm::inverse(camera.getProjectionMatrix() * camera.getViewMatrix());
+    const vec3 boxMin(-0.5f);
+    const vec3 boxMax = vec3(dims) - vec3(0.5f);
+
+    auto sample = [&](float x, float y, float z) {
+        // Clamp to the border voxels, the box reaches half a voxel beyond them
+        const vec3 p = glm::clamp(vec3(x, y, z), vec3(0.0f), maxVoxel);
+        const size3_t i0 = glm::min(size3_t(p), dims - size3_t(1));
+        const size3_t i1 = glm::min(i0 + size3_t(1), dims - size3_t(1));
+        const vec3 f = p - vec3(i0);
+        const float* v = volume.values.data();
+        auto at = [&](size_t x, size_t y, size_t z) { return v[x + dims.x * (y + dims.y * z)]; };
+        const float c00 = glm::mix(at(i0.x, i0.y, i0.z), at(i1.x, i0.y, i0.z), f.x);
+        const float c10 = glm::mix(at(i0.x, i1.y, i0.z), at(i1.x, i1.y, i0.z), f.x);
+        const float c01 = glm::mix(at(i0.x, i0.y, i1.z), at(i1.x, i0.y, i1.z), f.x);
+        const float c11 = glm::mix(at(i0.x, i1.y, i1.z), at(i1.x, i1.y, i1.z), f.x);
+        return glm::mix(glm::mix(c00, c10, f.y), glm::mix(c01, c11, f.y), f.z);
+    };
+
+    // Macrocell along one axis of voxel position p, and the distance along the ray to its exit.
+    // The first and last macrocell extend to the box, which limits the ray anyway.
+    auto cellExit = [&](float p, float d, float extent, size_t cellCount, size_t& cell) {
+        const float c = std::floor(glm::clamp(p, 0.0f, extent) / cellSize);
+        cell = std::min(static_cast<size_t>(c), cellCount - 1);
+        constexpr float inf = std::numeric_limits<float>::infinity();
+        const float lo = cell == 0 ? -inf : static_cast<float>(cell) * cellSize;
+        const float hi = cell + 1 == cellCount ? inf : static_cast<float>(cell + 1) * cellSize;
+        if (d > 0.0f) return (hi - p) / d;
+        if (d < 0.0f) return (lo - p) / d;
+        return inf;
+    };
+
+    auto tracePacket = [&](size_t px, size_t py, size_t& samples, size_t& skipped) {
+        Packet ray;
+        // Lanes are 4 x 2 pixels
+        for (size_t l = 0; l < N; ++l) {
+            const size_t x = px + l % 4;
+            const size_t y = py + l / 4;
+            ray.r[l] = ray.g[l] = ray.b[l] = ray.a[l] = 0.0f;
+            ray.step[l] = 0.0f;
+            ray.active[l] = false;
+            ray.tNear[l] = ray.tFar[l] = 0.0f;
+            ray.ox[l] = ray.oy[l] = ray.oz[l] = ray.dx[l] = ray.dy[l] = ray.dz[l] = 0.0f;
+            if (x >= size.x || y >= size.y) continue;
+
+            const vec2 ndc = (vec2(x, y) + vec2(0.5f)) / vec2(size) * 2.0f - 1.0f;
+            const vec4 n = ndcToVoxel * vec4(ndc, -1.0f, 1.0f);
+            const vec4 f = ndcToVoxel * vec4(ndc, 1.0f, 1.0f);
+            const vec3 origin = vec3(n) / n.w;
+            const vec3 dir = glm::normalize(vec3(f) / f.w - origin);
+
+            // Slab test against the box, starting at the near plane
+            const vec3 inv = 1.0f / dir;
+            const vec3 t0 = (boxMin - origin) * inv;
+            const vec3 t1 = (boxMax - origin) * inv;
+            const float tNear = std::max(glm::compMax(glm::min(t0, t1)), 0.0f);
+            const float tFar = glm::compMin(glm::max(t0, t1));
+            if (!(tNear < tFar)) continue;
+
+            ray.ox[l] = origin.x;
+            ray.oy[l] = origin.y;
+            ray.oz[l] = origin.z;
+            ray.dx[l] = dir.x;
+            ray.dy[l] = dir.y;
+            ray.dz[l] = dir.z;
+            ray.tNear[l] = tNear;
+            ray.tFar[l] = tFar;
+            ray.active[l] = true;
+        }
+
+        Packet::Lanes x, y, z, next, sr, sg, sb, sa;
+        std::array<bool, N> sampled;
+        while (true) {
+            // Positions of the next samples, lanes past the box are done
+            bool any = false;
+            for (size_t l = 0; l < N; ++l) {
+                const float t = ray.tNear[l] + ray.step[l] * stepLength;
+                ray.active[l] = ray.active[l] && t <= ray.tFar[l];
+                any = any || ray.active[l];
+                x[l] = ray.ox[l] + t * ray.dx[l];
+                y[l] = ray.oy[l] + t * ray.dy[l];
+                z[l] = ray.oz[l] + t * ray.dz[l];
+                next[l] = ray.step[l] + 1.0f;
+            }
+            if (!any) break;
+
+            // Lanes in empty macrocells move on to the first sample after the macrocell, the
+            // others sample the volume and the transfer function
+            for (size_t l = 0; l < N; ++l) {
+                sampled[l] = false;
+                sr[l] = sg[l] = sb[l] = sa[l] = 0.0f;
+                if (!ray.active[l]) continue;
+                size3_t cell;
+                const float exit =
+                    std::min({cellExit(x[l], ray.dx[l], maxVoxel.x, cells.x, cell.x),
+                              cellExit(y[l], ray.dy[l], maxVoxel.y, cells.y, cell.y),
+                              cellExit(z[l], ray.dz[l], maxVoxel.z, cells.z, cell.z)});
+                if (empty[cell.x + cells.x * (cell.y + cells.y * cell.z)]) {
+                    const float t = ray.tNear[l] + ray.step[l] * stepLength + exit;
+                    next[l] = std::max(next[l], std::ceil((t - ray.tNear[l]) / stepLength));
+                    ++skipped;
+                    continue;
+                }
+                const vec4& c = tf.colors[TransferFunction::index(sample(x[l], y[l], z[l]))];
+                sr[l] = c.r;
+                sg[l] = c.g;
+                sb[l] = c.b;
+                sa[l] = c.a;
+                sampled[l] = true;
+                ++samples;
+            }
+
+            // Front to back compositing, rays stop once they are almost opaque
+            for (size_t l = 0; l < N; ++l) {
+                const float w = 1.0f - ray.a[l];
+                ray.r[l] += w * sr[l];
+                ray.g[l] += w * sg[l];
+                ray.b[l] += w * sb[l];
+                ray.a[l] += w * sa[l];
+                ray.step[l] = next[l];
+                ray.active[l] = ray.active[l] && ray.a[l] < 0.99f;
+            }
+        }
+
+        for (size_t l = 0; l < N; ++l) {
+            const size_t x = px + l % 4;
+            const size_t y = py + l / 4;
+            if (x >= size.x || y >= size.y) continue;
+            const vec4 c = glm::clamp(vec4(ray.r[l], ray.g[l], ray.b[l], ray.a[l]), 0.0f, 1.0f);
+            pixels[x + y * size.x] = glm::u8vec4(c * 255.0f + 0.5f);
+        }
+    };
+
+    const size2_t tiles = (size + size2_t(tileSize - 1)) / size2_t(tileSize);
+    const size_t tileCount = tiles.x * tiles.y;
+    std::atomic<size_t> nextTile{0};
+    // Tiles are handed out one at a time since their cost depends on how much volume they see
+    TNM067::forEachRangeParallel(TNM067::defaultJobCount(), [&](size_t, size_t, size_t) {
+        size_t samples = 0;
+        size_t skipped = 0;
+        for (size_t tile = nextTile++; tile < tileCount; tile = nextTile++) {
+            const size2_t origin = size2_t(tile % tiles.x, tile / tiles.x) * tileSize;
+            for (size_t py = origin.y; py < std::min(origin.y + tileSize, size.y); py += 2) {
+                for (size_t px = origin.x; px < std::min(origin.x + tileSize, size.x); px += 4) {
+                    tracePacket(px, py, samples, skipped);
+                }
+            }
+        }
+        TNM067_PROFILE_COUNT(profile, RaySamples, samples);
+        TNM067_PROFILE_COUNT(profile, MacrocellsSkipped, skipped);
+    });
+    TNM067_PROFILE_COUNT(profile, PixelsProcessed, size.x * size.y);
+
+    return image;
+}
+
+}  // namespace inviwo
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <inviwo/core/processors/processor.h>
+#include <inviwo/core/properties/ordinalproperty.h>
+#include <inviwo/core/properties/boolproperty.h>
+#include <inviwo/core/properties/cameraproperty.h>
+#include <inviwo/core/interaction/cameratrackball.h>
+#include <inviwo/core/ports/imageport.h>
+#include <inviwo/core/ports/volumeport.h>
+#include <modules/tnm067lab1/utils/scalartocolormapping.h>
+#include <modules/tnm067lab1/properties/profilingproperty.h>
+#include <modules/tnm067lab1/utils/bufferpool.h>
+#include <modules/tnm067lab2/utils/macrocellgrid.h>
+
+#include <array>
+#include <vector>
+
+namespace inviwo {
+
+/**
+ * \class VolumeRaycasterCPU
+ * \brief Direct volume rendering on the CPU with a ScalarToColorMapping as transfer function.
+ * Rays are traced in packets of packetSize neighboring pixels, with the lanes of a packet stored
+ * as arrays so the per-sample arithmetic vectorizes. Macrocells in which the transfer function is
+ * fully transparent are skipped, and rays stop once they are almost opaque. The image is split
+ * into tiles of tileSize^2 pixels that the threads take one at a time.
+ */
+class IVW_MODULE_TNM067LAB2_API VolumeRaycasterCPU : public Processor {
+public:
+    static constexpr size_t packetSize = 8;
+    static constexpr size_t tileSize = 16;
+    static constexpr size_t macrocellSize = 8;
+
+    /**
+     * The first channel of a volume normalized by its data range to [0 1], as floats, and its
+     * macrocell grid. Only depends on the volume, so it is built once per volume.
+     */
+    struct PreparedVolume {
+        size3_t dims{0};
+        std::vector<float> values;
+        TNM067::MacrocellGrid macrocells;
+        mat4 worldToVoxel;  //!< From world space to voxel positions, voxel i is at i
+    };
+
+    VolumeRaycasterCPU();
+    virtual ~VolumeRaycasterCPU() = default;
+
+    virtual void process() override;
+
+    virtual const ProcessorInfo getProcessorInfo() const override;
+    static const ProcessorInfo processorInfo_;
+
+    static std::shared_ptr<const PreparedVolume> prepare(const Volume& volume,
+                                                         TNM067::Profile* profile = nullptr);
+
+    /**
+     * Renders volume as seen by camera into a RGBA8 image of the given size, with the colors
+     * premultiplied by alpha. samplingRate is the number of samples per voxel length along the
+     * rays, the opacities of map are given per voxel length and corrected for it. This is what
+     * process() runs, exposed to allow rendering outside of a processor network. The image is
+     * taken from pool if given.
+     */
+    static std::shared_ptr<Image> render(const PreparedVolume& volume, const Camera& camera,
+                                         const ScalarToColorMapping& map, size2_t size,
+                                         float samplingRate, bool skipEmptySpace = true,
+                                         TNM067::Profile* profile = nullptr,
+                                         TNM067::BufferPool* pool = nullptr);
+
+private:
+    VolumeInport volume_;
+    ImageOutport outport_;
+
+    CameraProperty camera_;
+    CameraTrackball trackball_;
+    FloatProperty samplingRate_;
+    BoolProperty skipEmptySpace_;
+    IntSizeTProperty numColors_;
+    std::array<FloatVec4Property, 10> colors_;
+    ProfilingProperty profiling_;
+    TNM067::BufferPool pool_;
+    std::shared_ptr<const PreparedVolume> prepared_;
+};
+
+}  // namespace inviwo
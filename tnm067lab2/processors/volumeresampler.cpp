@@ -0,0 +1,99 @@
+#include <modules/tnm067lab2/processors/volumeresampler.h>
+#include <inviwo/core/datastructures/volume/volume.h>
+#include <inviwo/core/datastructures/volume/volumeramprecision.h>
+#include <inviwo/core/util/formatdispatching.h>
+
+namespace inviwo {
+
+const ProcessorInfo VolumeResampler::processorInfo_{
+    "org.inviwo.VolumeResampler",  // Class identifier
+    "Volume Resampler",            // Display name
+    "TNM067",                      // Category
+    CodeState::Experimental,       // Code state
+    Tags::CPU,                     // Tags
+};
+
+const ProcessorInfo VolumeResampler::getProcessorInfo() const { return processorInfo_; }
+
+VolumeResampler::VolumeResampler()
+    : PoolProcessor(pool::Option::KeepOldResults | pool::Option::DelayDispatch)
+    , inport_("inport")
+    , outport_("outport")
+    , dimensions_("dimensions", "Dimensions", size3_t(64), size3_t(2), size3_t(2048))
+    , kernel_("kernel", "Interpolation",
+              {{"nearest", "Nearest", TNM067::InterpolationKernel::Nearest},
+               {"trilinear", "Trilinear", TNM067::InterpolationKernel::Linear},
+               {"tricubic", "Tricubic", TNM067::InterpolationKernel::Cubic}},
+              1)
+    , background_("background", "Run in Background", true)
+    , profiling_("profiling", "Profiling") {
+    addPort(inport_);
+    addPort(outport_);
+    addProperty(dimensions_);
+    addProperty(kernel_);
+    addProperty(background_);
+    addProperty(profiling_);
+}
+
+void VolumeResampler::process() {
+    const auto generation = ++generation_;
+    auto volume = inport_.getData();
+    if (!background_) {
+        auto profile = profiling_.begin();
+        outport_.setData(resample(*volume, dimensions_.get(), kernel_.get(), profile));
+        profiling_.end();
+        return;
+    }
+
+    auto job = [volume, dims = dimensions_.get(), kernel = kernel_.get()](
+                   pool::Stop stop, pool::Progress progress) {
+        const auto profile = ProfilingProperty::beginJob();
+        const TNM067::JobControl control{[stop]() { return stop(); },
+                                         [progress](float done) { progress(done); }};
+        auto result = resample(*volume, dims, kernel, profile.get(), &control);
+        if (profile) profile->end();
+        return std::make_pair(result, profile);
+    };
+    dispatchOne(job, [this, generation](auto result) {
+        if (!result.first || generation != generation_) return;
+        if (result.second) profiling_.report(*result.second);
+        outport_.setData(result.first);
+        newResults();
+    });
+}
+
+std::shared_ptr<Volume> VolumeResampler::resample(const Volume& vol, size3_t dims,
+                                                  TNM067::InterpolationKernel kernel,
+                                                  TNM067::Profile* profile,
+                                                  const TNM067::JobControl* control) {
+    TNM067_PROFILE_SCOPE(profile, "Resample");
+    const auto inRam = vol.getRepresentation<VolumeRAM>();
+    const size3_t inDims = inRam->getDimensions();
+
+    auto result = std::make_shared<Volume>(dims, vol.getDataFormat());
+    result->setModelMatrix(vol.getModelMatrix());
+    result->setWorldMatrix(vol.getWorldMatrix());
+    result->dataMap_ = vol.dataMap_;
+    auto outRam = result->getEditableRepresentation<VolumeRAM>();
+
+    TNM067::AxisWeights wx, wy, wz;
+    {
+        TNM067_PROFILE_SCOPE(profile, "Axis weights");
+        wx = TNM067::computeAxisWeights(inDims.x, dims.x, kernel);
+        wy = TNM067::computeAxisWeights(inDims.y, dims.y, kernel);
+        wz = TNM067::computeAxisWeights(inDims.z, dims.z, kernel);
+    }
+
+    const bool done = inRam->dispatch<bool>([&](const auto inRep) {
+        using T = util::PrecisionValueType<decltype(inRep)>;
+        auto out = static_cast<VolumeRAMPrecision<T>*>(outRam)->getDataTyped();
+        return TNM067::resample(inRep->getDataTyped(), inDims, out, dims, wx, wy, wz, brickSize,
+                                control);
+    });
+    if (!done) return nullptr;
+
+    TNM067_PROFILE_COUNT(profile, VoxelsProcessed, dims.x * dims.y * dims.z);
+    return result;
+}
+
+}  // namespace inviwo
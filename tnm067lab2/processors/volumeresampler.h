@@ -0,0 +1,57 @@
+#pragma once
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <inviwo/core/processors/poolprocessor.h>
+#include <inviwo/core/properties/ordinalproperty.h>
+#include <inviwo/core/properties/optionproperty.h>
+#include <inviwo/core/properties/boolproperty.h>
+#include <inviwo/core/ports/volumeport.h>
+#include <modules/tnm067lab1/properties/profilingproperty.h>
+#include <modules/tnm067lab1/utils/resampling.h>
+#include <modules/tnm067lab1/utils/jobcontrol.h>
+
+namespace inviwo {
+
+/**
+ * \class VolumeResampler
+ * \brief Resamples a volume to new dimensions with nearest, trilinear or tricubic interpolation.
+ * The volume keeps its basis and offset, so it covers the same region of space on a grid of the
+ * new dimensions. With Run in Background set the volume is resampled on the thread pool. A new
+ * volume or property change stops the job in flight and the previous volume stays on the outport
+ * until the new one is done.
+ */
+class IVW_MODULE_TNM067LAB2_API VolumeResampler : public PoolProcessor {
+public:
+    /// Side of the cubic output bricks resample() processes in parallel
+    static constexpr size_t brickSize = 32;
+
+    VolumeResampler();
+    virtual ~VolumeResampler() = default;
+
+    virtual void process() override;
+
+    virtual const ProcessorInfo getProcessorInfo() const override;
+    static const ProcessorInfo processorInfo_;
+
+    /**
+     * Resamples all channels of vol to dims using the given kernel, Cubic being Catmull-Rom. This
+     * is what process() runs, exposed to allow running it outside of a processor network. Returns
+     * nullptr if control is stopped, which is checked once per brick of the output.
+     */
+    static std::shared_ptr<Volume> resample(const Volume& vol, size3_t dims,
+                                            TNM067::InterpolationKernel kernel,
+                                            TNM067::Profile* profile = nullptr,
+                                            const TNM067::JobControl* control = nullptr);
+
+private:
+    VolumeInport inport_;
+    VolumeOutport outport_;
+
+    IntSize3Property dimensions_;
+    TemplateOptionProperty<TNM067::InterpolationKernel> kernel_;
+    BoolProperty background_;
+    ProfilingProperty profiling_;
+    size_t generation_ = 0;  //!< Counts process() calls, results of older jobs are dropped
+};
+
+}  // namespace inviwo
@@ -0,0 +1,272 @@
+#include <modules/tnm067lab2/utils/brickedvolume.h>
+#include <inviwo/core/datastructures/volume/volumeram.h>
+#include <inviwo/core/util/formatdispatching.h>
+#include <inviwo/core/util/exception.h>
+#include <modules/base/algorithm/dataminmax.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+
+namespace inviwo {
+
+namespace TNM067 {
+
+const std::string BrickedVolume::classIdentifier = "org.inviwo.TNM067.BrickedVolume";
+
+/**
+ * Compresses the bricks of one layer of bricks at a time from a window of slices covering the
+ * layer and its apron
+ */
+class BrickedVolume::Builder {
+public:
+    /**
+     * range holds all values of the volume. With quantization it is divided into the levels of
+     * the quantized type to get the step shared by all bricks.
+     */
+    Builder(BrickedVolume& volume, Quantization quantization, dvec2 range)
+        : volume_(volume), quantization_(quantization), brick_(cube(volume.getStoredSize())) {
+        const double levels = quantization == Quantization::UInt8
+                                  ? std::numeric_limits<std::uint8_t>::max()
+                                  : std::numeric_limits<std::uint16_t>::max();
+        if (quantization != Quantization::None && range.y > range.x) {
+            volume_.step_ = (range.y - range.x) / levels;
+        }
+    }
+
+    /**
+     * Adds all bricks of layer z. slices holds the values of the slices starting at the first slice
+     * of the layer, x fastest, and must cover the layer and its apron within the volume.
+     */
+    void addLayer(size_t z, const std::vector<float>& slices) {
+        const size3_t dims = volume_.dims_;
+        const size_t stored = volume_.getStoredSize();
+        const size_t first = z * volume_.brickSize_;
+
+        for (size_t by = 0; by < volume_.brickCount_.y; ++by) {
+            for (size_t bx = 0; bx < volume_.brickCount_.x; ++bx) {
+                const size3_t origin = volume_.getBrickOrigin(size3_t(bx, by, z));
+                float min = std::numeric_limits<float>::max();
+                float max = std::numeric_limits<float>::lowest();
+                size_t i = 0;
+                for (size_t k = 0; k < stored; ++k) {
+                    const size_t vz = std::min(origin.z + k, dims.z - 1) - first;
+                    for (size_t j = 0; j < stored; ++j) {
+                        const size_t vy = std::min(origin.y + j, dims.y - 1);
+                        const float* row = slices.data() + (vy + vz * dims.y) * dims.x;
+                        for (size_t l = 0; l < stored; ++l) {
+                            const float v = row[std::min(origin.x + l, dims.x - 1)];
+                            brick_[i++] = v;
+                            min = std::min(min, v);
+                            max = std::max(max, v);
+                        }
+                    }
+                }
+                volume_.bricks_.push_back(encode(min, max));
+                volume_.valueRange.x = std::min(volume_.valueRange.x, static_cast<double>(min));
+                volume_.valueRange.y = std::max(volume_.valueRange.y, static_cast<double>(max));
+            }
+        }
+    }
+
+private:
+    static size_t cube(size_t s) { return s * s * s; }
+
+    std::int64_t level(float v) const {
+        return static_cast<std::int64_t>(std::llround(static_cast<double>(v) / volume_.step_));
+    }
+
+    /// The value v decodes to, the same in every brick
+    float snap(float v) const { return volume_.step_ > 0.0 ? volume_.decode(level(v)) : v; }
+
+    /**
+     * Stores the levels of the brick relative to the level of its min. The range of the brick is
+     * that of the decoded values, so intersects() agrees with the decompressed brick.
+     */
+    template <typename T>
+    Brick quantize(std::vector<T>& payload, Encoding encoding, float min, float max) {
+        const size_t offset = payload.size();
+        const std::int64_t base = level(min);
+        const auto top = static_cast<std::int64_t>(std::numeric_limits<T>::max());
+        for (const float v : brick_) {
+            payload.push_back(static_cast<T>(std::clamp(level(v) - base, std::int64_t{0}, top)));
+        }
+        return {encoding, volume_.decode(base), volume_.decode(std::min(level(max), base + top)),
+                offset, base};
+    }
+
+    Brick encode(float min, float max) {
+        if (min == max) return {Encoding::Constant, snap(min), snap(max), 0};
+
+        switch (volume_.step_ > 0.0 ? quantization_ : Quantization::None) {
+            case Quantization::UInt8:
+                return quantize(volume_.uint8s_, Encoding::UInt8, min, max);
+            case Quantization::UInt16:
+                return quantize(volume_.uint16s_, Encoding::UInt16, min, max);
+            case Quantization::None:
+            default: {
+                const size_t offset = volume_.floats_.size();
+                volume_.floats_.insert(volume_.floats_.end(), brick_.begin(), brick_.end());
+                return {Encoding::Float, min, max, offset};
+            }
+        }
+    }
+
+    BrickedVolume& volume_;
+    Quantization quantization_;
+    std::vector<float> brick_;
+};
+
+BrickedVolume::BrickedVolume(size3_t dims, size_t brickSize)
+    : valueRange(std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest())
+    , dims_(dims)
+    , brickSize_(brickSize)
+    , brickCount_(glm::max((dims - size3_t(1) + size3_t(brickSize - 1)) / brickSize, size3_t(1))) {
+    bricks_.reserve(glm::compMul(brickCount_));
+}
+
+BrickedVolume BrickedVolume::fromVolume(const Volume& volume, size_t brickSize,
+                                        Quantization quantization) {
+    const auto ram = volume.getRepresentation<VolumeRAM>();
+    const size3_t dims = ram->getDimensions();
+    const size_t sliceSize = dims.x * dims.y;
+
+    BrickedVolume bricked(dims, brickSize);
+    bricked.modelMatrix = volume.getModelMatrix();
+    bricked.worldMatrix = volume.getWorldMatrix();
+
+    // Quantized volumes store their values in a data range different from the value range
+    const auto& map = volume.dataMap_;
+    const bool mapped = map.dataRange != map.valueRange;
+
+    dvec2 range(0.0);
+    if (quantization != Quantization::None) {
+        const auto minMax = util::volumeMinMax(ram);
+        const double a = mapped ? map.mapFromDataToValue(minMax.first.x) : minMax.first.x;
+        const double b = mapped ? map.mapFromDataToValue(minMax.second.x) : minMax.second.x;
+        range = dvec2(std::min(a, b), std::max(a, b));
+    }
+
+    Builder builder(bricked, quantization, range);
+    std::vector<float> slices;
+    ram->dispatch<void, dispatching::filter::Scalars>([&](const auto vrprecision) {
+        const auto data = vrprecision->getDataTyped();
+        for (size_t z = 0; z < bricked.brickCount_.z; ++z) {
+            const size_t first = z * brickSize;
+            const size_t last = std::min(first + brickSize, dims.z - 1);
+            slices.assign(data + first * sliceSize, data + (last + 1) * sliceSize);
+            if (mapped) {
+                for (auto& value : slices) {
+                    value = static_cast<float>(map.mapFromDataToValue(static_cast<double>(value)));
+                }
+            }
+            builder.addLayer(z, slices);
+        }
+    });
+    return bricked;
+}
+
+BrickedVolume BrickedVolume::fromRawFile(const std::string& path, size3_t dims,
+                                         const DataFormatBase* format, size_t brickSize,
+                                         Quantization quantization) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw FileException("Could not open " + path, IVW_CONTEXT_CUSTOM("TNM067"));
+    }
+    const size_t sliceSize = dims.x * dims.y;
+
+    BrickedVolume bricked(dims, brickSize);
+
+    std::vector<float> slices;
+    format->dispatch<void, dispatching::filter::Scalars>([&](auto dataFormat) {
+        using T = util::PrecisionValueType<decltype(dataFormat)>;
+        std::vector<T> buffer;
+        // Reads the slices [first, last] into buffer
+        auto read = [&](size_t first, size_t last) {
+            buffer.resize((last + 1 - first) * sliceSize);
+            in.seekg(static_cast<std::streamoff>(first * sliceSize * sizeof(T)));
+            if (!in.read(reinterpret_cast<char*>(buffer.data()),
+                         static_cast<std::streamsize>(buffer.size() * sizeof(T)))) {
+                throw FileException("Could not read slices " + std::to_string(first) + "-" +
+                                        std::to_string(last) + " from " + path,
+                                    IVW_CONTEXT_CUSTOM("TNM067"));
+            }
+        };
+
+        // The quantization step depends on the range of the whole file, which is read one slice
+        // at a time before bricking
+        dvec2 range(0.0);
+        if (quantization != Quantization::None) {
+            range = dvec2(std::numeric_limits<double>::max(),
+                          std::numeric_limits<double>::lowest());
+            for (size_t z = 0; z < dims.z; ++z) {
+                read(z, z);
+                for (const T& value : buffer) {
+                    const auto v = static_cast<double>(static_cast<float>(value));
+                    range.x = std::min(range.x, v);
+                    range.y = std::max(range.y, v);
+                }
+            }
+        }
+
+        Builder builder(bricked, quantization, range);
+        for (size_t z = 0; z < bricked.brickCount_.z; ++z) {
+            const size_t first = z * brickSize;
+            const size_t last = std::min(first + brickSize, dims.z - 1);
+            read(first, last);
+            slices.assign(buffer.begin(), buffer.end());
+            builder.addLayer(z, slices);
+        }
+    });
+    return bricked;
+}
+
+const BrickedVolume::Brick& BrickedVolume::getBrick(size3_t brick) const {
+    return bricks_[brick.x + brickCount_.x * (brick.y + brickCount_.y * brick.z)];
+}
+
+bool BrickedVolume::intersects(size3_t brick, float iso) const {
+    const auto& b = getBrick(brick);
+    return b.min < iso && iso <= b.max;
+}
+
+void BrickedVolume::decompress(size3_t brick, std::vector<float>& out) const {
+    const size_t stored = getStoredSize();
+    const size_t count = stored * stored * stored;
+    const auto& b = getBrick(brick);
+    out.resize(count);
+
+    switch (b.encoding) {
+        case Encoding::Constant:
+            std::fill(out.begin(), out.end(), b.min);
+            break;
+        case Encoding::Float:
+            std::copy_n(floats_.begin() + b.offset, count, out.begin());
+            break;
+        case Encoding::UInt8: {
+            std::transform(uint8s_.begin() + b.offset, uint8s_.begin() + b.offset + count,
+                           out.begin(), [&](std::uint8_t q) { return decode(b.base + q); });
+            break;
+        }
+        case Encoding::UInt16: {
+            std::transform(uint16s_.begin() + b.offset, uint16s_.begin() + b.offset + count,
+                           out.begin(), [&](std::uint16_t q) { return decode(b.base + q); });
+            break;
+        }
+    }
+}
+
+size_t BrickedVolume::getConstantBrickCount() const {
+    return std::count_if(bricks_.begin(), bricks_.end(),
+                         [](const Brick& b) { return b.encoding == Encoding::Constant; });
+}
+
+size_t BrickedVolume::getSizeInBytes() const {
+    return bricks_.size() * sizeof(Brick) + floats_.size() * sizeof(float) +
+           uint8s_.size() * sizeof(std::uint8_t) + uint16s_.size() * sizeof(std::uint16_t);
+}
+
+}  // namespace TNM067
+
+}  // namespace inviwo
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <inviwo/core/datastructures/volume/volume.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace inviwo {
+
+namespace TNM067 {
+
+/**
+ * \class BrickedVolume
+ * \brief A scalar volume split into cubic bricks that are compressed individually.
+ * Every brick stores its brickSize^3 voxels plus a one voxel apron towards the next brick, so all
+ * cells with their first corner inside a brick can be processed from that brick alone. Bricks where
+ * all voxels (including the apron) are equal are stored as a single value, other bricks are stored
+ * as floats or quantized to 8 or 16 bits. Quantization uses one step for all bricks, dividing the
+ * value range of the volume into the levels of the type, so a voxel shared by several bricks
+ * decodes to the same value in all of them. The value range of every brick is kept so bricks can
+ * be skipped without decompressing them.
+ */
+class IVW_MODULE_TNM067LAB2_API BrickedVolume {
+public:
+    static const std::string classIdentifier;
+
+    enum class Quantization { None, UInt8, UInt16 };
+    enum class Encoding : std::uint8_t { Constant, Float, UInt8, UInt16 };
+
+    struct Brick {
+        Encoding encoding;
+        float min;
+        float max;
+        size_t offset;  //!< Start of the brick data in the payload of its encoding
+        std::int64_t base = 0;  //!< Quantized voxels store their level round(v / step) - base
+    };
+
+    BrickedVolume() = default;
+
+    /**
+     * Bricks the first channel of the RAM representation of volume, mapped from its data range to
+     * its value range
+     */
+    static BrickedVolume fromVolume(const Volume& volume, size_t brickSize,
+                                    Quantization quantization = Quantization::None);
+
+    /**
+     * Bricks a raw file of a scalar volume without loading it completely. The file is read one
+     * layer of bricks at a time, so only brickSize + 1 slices are kept in memory.
+     * @throw FileException if the file could not be read
+     */
+    static BrickedVolume fromRawFile(const std::string& path, size3_t dims,
+                                     const DataFormatBase* format, size_t brickSize,
+                                     Quantization quantization = Quantization::None);
+
+    size3_t getDimensions() const { return dims_; }
+    size_t getBrickSize() const { return brickSize_; }
+    size3_t getBrickCount() const { return brickCount_; }
+    const Brick& getBrick(size3_t brick) const;
+
+    /// First voxel of a brick
+    size3_t getBrickOrigin(size3_t brick) const { return brick * brickSize_; }
+
+    /// Number of voxels along each side of a decompressed brick, brickSize + 1
+    size_t getStoredSize() const { return brickSize_ + 1; }
+
+    /**
+     * Returns true if the brick contains both values below iso and values at or above iso, i.e.
+     * if an iso surface at iso passes through its cells
+     */
+    bool intersects(size3_t brick, float iso) const;
+
+    /**
+     * Decompresses a brick including its apron into out, getStoredSize()^3 values with x fastest.
+     * Voxels outside of the volume repeat the last voxel.
+     */
+    void decompress(size3_t brick, std::vector<float>& out) const;
+
+    /// Number of bricks stored as a single value
+    size_t getConstantBrickCount() const;
+
+    /// Bytes used by the brick table and the payload
+    size_t getSizeInBytes() const;
+
+    dvec2 valueRange{0.0, 1.0};
+    mat4 modelMatrix{1.0f};
+    mat4 worldMatrix{1.0f};
+
+private:
+    class Builder;
+    BrickedVolume(size3_t dims, size_t brickSize);
+
+    /// Value of a quantization level
+    float decode(std::int64_t level) const {
+        return static_cast<float>(static_cast<double>(level) * step_);
+    }
+
+    size3_t dims_{0};
+    size_t brickSize_ = 0;
+    size3_t brickCount_{0};
+    double step_ = 0.0;  //!< Quantization step, 0 if not quantized
+    std::vector<Brick> bricks_;
+    std::vector<float> floats_;
+    std::vector<std::uint8_t> uint8s_;
+    std::vector<std::uint16_t> uint16s_;
+};
+
+}  // namespace TNM067
+
+}  // namespace inviwo
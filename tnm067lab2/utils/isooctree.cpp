@@ -0,0 +1,295 @@
+#include <modules/tnm067lab2/utils/isooctree.h>
+#include <modules/tnm067lab1/utils/parallelutils.h>
+#include <inviwo/core/util/formatdispatching.h>
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace inviwo {
+
+namespace TNM067 {
+
+namespace {
+
+size3_t childOffset(size_t i) { return {i & 1, (i >> 1) & 1, (i >> 2) & 1}; }
+
+/// Coordinates of the node at level containing cell
+size3_t nodeAt(size3_t cell, size_t level) {
+    return {cell.x >> level, cell.y >> level, cell.z >> level};
+}
+
+}  // namespace
+
+template <typename T>
+class IsoOctree::Builder {
+public:
+    Builder(IsoOctree& tree, const T* data, float iso, float maxError)
+        : tree_(tree)
+        , data_(data)
+        , dims_(tree.dims_)
+        , cells_(tree.dims_ - size3_t(1))
+        , iso_(iso)
+        , maxError_(maxError)
+        , blockCount_((cells_ + size3_t(blockSize - 1)) / blockSize) {}
+
+    /// Value range of every block of blockSize^3 cells, used for the nodes larger than a block
+    void computeBlocks() {
+        blocks_.resize(glm::compMul(blockCount_));
+        forEachRangeParallel(blockCount_.z, [&](size_t begin, size_t end, size_t) {
+            size3_t block{};
+            for (block.z = begin; block.z < end; ++block.z) {
+                for (block.y = 0; block.y < blockCount_.y; ++block.y) {
+                    for (block.x = 0; block.x < blockCount_.x; ++block.x) {
+                        const size3_t first = block * blockSize;
+                        blocks_[block.x + blockCount_.x * (block.y + blockCount_.y * block.z)] =
+                            scan(first, glm::min(first + size3_t(blockSize), cells_));
+                    }
+                }
+            }
+        });
+    }
+
+    /// Splits nodes top-down until they are inactive, flat enough or single cells
+    void refine() {
+        std::vector<std::pair<size_t, size3_t>> stack{{tree_.rootLevel_, size3_t(0)}};
+        while (!stack.empty()) {
+            const auto [level, coords] = stack.back();
+            stack.pop_back();
+            const size_t size = size_t{1} << level;
+            const size3_t origin = coords * size;
+            if (isOutside(origin) || level == 0 || !isActive(range(origin, size))) continue;
+            // Nodes reaching outside of the volume can not be interpolated from their corners
+            if (!isPartial(origin, size) && isFlat(origin, size)) continue;
+
+            tree_.split(level, coords);
+            for (size_t i = 0; i < 8; ++i) {
+                stack.push_back({level - 1, coords * size_t{2} + childOffset(i)});
+            }
+        }
+    }
+
+    /**
+     * Splits leaves until all leaves sharing a face, an edge or a corner differ by at most one
+     * level. A leaf only has to look at one cell in each of the 26 directions since a leaf more
+     * than one level larger covers the whole neighbor at the level of the leaf.
+     */
+    void balance() {
+        std::vector<std::pair<size_t, size3_t>> work;
+        forEachLeaf([&](size_t level, size3_t coords) { work.push_back({level, coords}); });
+
+        while (!work.empty()) {
+            const auto [level, coords] = work.back();
+            work.pop_back();
+            // Leaves that were split after being queued have queued their children instead
+            if (tree_.isSplit(level, coords)) continue;
+
+            const size_t size = size_t{1} << level;
+            const size3_t origin = coords * size;
+            for (int d = 0; d < 27; ++d) {
+                const ivec3 dir(d % 3 - 1, (d / 3) % 3 - 1, d / 9 - 1);
+                if (dir == ivec3(0)) continue;
+
+                size3_t cell = origin;
+                bool inside = true;
+                for (size_t axis = 0; axis < 3; ++axis) {
+                    if (dir[axis] < 0) {
+                        inside &= origin[axis] > 0;
+                        cell[axis] = origin[axis] - 1;
+                    } else if (dir[axis] > 0) {
+                        cell[axis] = origin[axis] + size;
+                        inside &= cell[axis] < cells_[axis];
+                    }
+                }
+                if (!inside) continue;
+
+                auto neighborLevel = find(cell);
+                while (neighborLevel > level + 1) {
+                    const size3_t neighbor = nodeAt(cell, neighborLevel);
+                    tree_.split(neighborLevel, neighbor);
+                    for (size_t i = 0; i < 8; ++i) {
+                        const size3_t child = neighbor * size_t{2} + childOffset(i);
+                        if (!isOutside(child * (size_t{1} << (neighborLevel - 1)))) {
+                            work.push_back({neighborLevel - 1, child});
+                        }
+                    }
+                    --neighborLevel;
+                }
+            }
+        }
+    }
+
+    void collect() {
+        forEachLeaf([&](size_t level, size3_t coords) {
+            const size_t size = size_t{1} << level;
+            const size3_t origin = coords * size;
+            const bool active = !isPartial(origin, size) && isActive(range(origin, size));
+            tree_.leaves_.push_back({origin, level, active});
+        });
+    }
+
+private:
+    static constexpr size_t blockSize = 8;
+
+    float value(size3_t v) const {
+        return static_cast<float>(data_[v.x + dims_.x * (v.y + dims_.y * v.z)]);
+    }
+
+    bool isOutside(size3_t origin) const {
+        return glm::any(glm::greaterThanEqual(origin, cells_));
+    }
+    bool isPartial(size3_t origin, size_t size) const {
+        return glm::any(glm::greaterThan(origin + size3_t(size), cells_));
+    }
+    bool isActive(vec2 range) const { return range.x < iso_ && iso_ <= range.y; }
+
+    /// Level of the leaf containing cell
+    size_t find(size3_t cell) const {
+        size_t level = tree_.rootLevel_;
+        while (tree_.isSplit(level, nodeAt(cell, level))) --level;
+        return level;
+    }
+
+    template <typename F>
+    void forEachLeaf(F f) const {
+        std::vector<std::pair<size_t, size3_t>> stack{{tree_.rootLevel_, size3_t(0)}};
+        while (!stack.empty()) {
+            const auto [level, coords] = stack.back();
+            stack.pop_back();
+            if (isOutside(coords * (size_t{1} << level))) continue;
+            if (!tree_.isSplit(level, coords)) {
+                f(level, coords);
+                continue;
+            }
+            for (size_t i = 0; i < 8; ++i) {
+                stack.push_back({level - 1, coords * size_t{2} + childOffset(i)});
+            }
+        }
+    }
+
+    /// Value range of the voxels in [first, last]
+    vec2 scan(size3_t first, size3_t last) const {
+        vec2 r(std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest());
+        for (size_t z = first.z; z <= last.z; ++z) {
+            for (size_t y = first.y; y <= last.y; ++y) {
+                for (size_t x = first.x; x <= last.x; ++x) {
+                    const float v = value({x, y, z});
+                    r.x = std::min(r.x, v);
+                    r.y = std::max(r.y, v);
+                }
+            }
+        }
+        return r;
+    }
+
+    /// Value range of the voxels of a node, clipped to the volume
+    vec2 range(size3_t origin, size_t size) const {
+        const size3_t end = glm::min(origin + size3_t(size), cells_);
+        if (size <= blockSize) return scan(origin, end);
+
+        // Larger nodes are aligned to the blocks
+        vec2 r(std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest());
+        const size3_t first = origin / blockSize;
+        const size3_t last = (end - size3_t(1)) / blockSize;
+        for (size_t z = first.z; z <= last.z; ++z) {
+            for (size_t y = first.y; y <= last.y; ++y) {
+                for (size_t x = first.x; x <= last.x; ++x) {
+                    const vec2 b = blocks_[x + blockCount_.x * (y + blockCount_.y * z)];
+                    r.x = std::min(r.x, b.x);
+                    r.y = std::max(r.y, b.y);
+                }
+            }
+        }
+        return r;
+    }
+
+    /**
+     * True if trilinear interpolation of the corners is within maxError of the volume at the
+     * corners, edge midpoints, face centers and center of the node
+     */
+    bool isFlat(size3_t origin, size_t size) const {
+        float corners[8];
+        for (size_t i = 0; i < 8; ++i) corners[i] = value(origin + childOffset(i) * size);
+
+        for (size_t k = 0; k < 3; ++k) {
+            for (size_t j = 0; j < 3; ++j) {
+                for (size_t i = 0; i < 3; ++i) {
+                    const vec3 t = vec3(i, j, k) * 0.5f;
+                    const float x0 = glm::mix(corners[0], corners[1], t.x);
+                    const float x1 = glm::mix(corners[2], corners[3], t.x);
+                    const float x2 = glm::mix(corners[4], corners[5], t.x);
+                    const float x3 = glm::mix(corners[6], corners[7], t.x);
+                    const float interpolated =
+                        glm::mix(glm::mix(x0, x1, t.y), glm::mix(x2, x3, t.y), t.z);
+                    const float v = value(origin + size3_t(i, j, k) * size / size_t{2});
+                    if (std::abs(v - interpolated) > maxError_) return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    IsoOctree& tree_;
+    const T* data_;
+    size3_t dims_;
+    size3_t cells_;
+    float iso_;
+    float maxError_;
+    size3_t blockCount_;
+    std::vector<vec2> blocks_;
+};
+
+IsoOctree::IsoOctree(size3_t dims) : dims_(dims), rootLevel_(0) {
+    const size_t cells = glm::compMax(dims) - 1;
+    while ((size_t{1} << rootLevel_) < cells) ++rootLevel_;
+    split_.resize(rootLevel_ + 1);
+}
+
+IsoOctree IsoOctree::build(const VolumeRAM& volume, float iso, float maxError, Profile* profile) {
+    IsoOctree tree(volume.getDimensions());
+    volume.dispatch<void, dispatching::filter::Scalars>([&](const auto vrprecision) {
+        using T = util::PrecisionValueType<decltype(vrprecision)>;
+        Builder<T> builder(tree, vrprecision->getDataTyped(), iso, maxError);
+        {
+            TNM067_PROFILE_SCOPE(profile, "Octree refinement");
+            builder.computeBlocks();
+            builder.refine();
+        }
+        {
+            TNM067_PROFILE_SCOPE(profile, "Octree balance");
+            builder.balance();
+            builder.collect();
+        }
+    });
+    TNM067_PROFILE_COUNT(profile, OctreeLeaves, tree.leaves_.size());
+    return tree;
+}
+
+size_t IsoOctree::getActiveLeafCount() const {
+    return std::count_if(leaves_.begin(), leaves_.end(), [](const Node& n) { return n.active; });
+}
+
+bool IsoOctree::isSplit(const Node& node, ivec3 offset) const {
+    const size3_t coords = nodeAt(node.origin, node.level);
+    size3_t neighbor;
+    for (size_t axis = 0; axis < 3; ++axis) {
+        if (offset[axis] < 0 && coords[axis] < static_cast<size_t>(-offset[axis])) return false;
+        neighbor[axis] = coords[axis] + offset[axis];
+    }
+    return isSplit(node.level, neighbor);
+}
+
+std::uint64_t IsoOctree::key(size3_t coords) {
+    return static_cast<std::uint64_t>(coords.x) | (static_cast<std::uint64_t>(coords.y) << 21) |
+           (static_cast<std::uint64_t>(coords.z) << 42);
+}
+
+bool IsoOctree::isSplit(size_t level, size3_t coords) const {
+    return level > 0 && split_[level].count(key(coords)) > 0;
+}
+
+void IsoOctree::split(size_t level, size3_t coords) { split_[level].insert(key(coords)); }
+
+}  // namespace TNM067
+
+}  // namespace inviwo
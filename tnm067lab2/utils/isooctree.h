@@ -0,0 +1,73 @@
+#pragma once
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <modules/tnm067lab1/utils/instrumentation.h>
+#include <inviwo/core/datastructures/volume/volumeram.h>
+
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+namespace inviwo {
+
+namespace TNM067 {
+
+/**
+ * \class IsoOctree
+ * \brief Octree over the cells of a volume, refined only where an iso surface passes through.
+ * A node is split if the value range of its voxels straddles the iso value and the volume inside
+ * it is not well approximated by trilinear interpolation of its eight corners. The tree is 2:1
+ * balanced afterwards, so leaves sharing a face, an edge or a corner differ by at most one level,
+ * which lets neighboring leaves agree on how their shared faces are triangulated.
+ */
+class IVW_MODULE_TNM067LAB2_API IsoOctree {
+public:
+    struct Node {
+        size3_t origin;  //!< First voxel of the node
+        size_t level;    //!< The node covers 2^level cells along each axis
+        bool active;     //!< The value range of the node straddles the iso value
+
+        size_t size() const { return size_t{1} << level; }
+    };
+
+    /**
+     * Builds the octree for the first channel of volume. maxError is the largest difference,
+     * in data values, between a voxel and the trilinear interpolation of the corners of its leaf
+     * for the leaf to not be refined further. Checked at the corners, edge midpoints, face centers
+     * and center of the node. A maxError of 0 refines all active nodes down to single cells.
+     */
+    static IsoOctree build(const VolumeRAM& volume, float iso, float maxError,
+                           Profile* profile = nullptr);
+
+    size3_t getDimensions() const { return dims_; }
+
+    /// Leaves that are at least partially inside the volume, active leaves are fully inside
+    const std::vector<Node>& getLeaves() const { return leaves_; }
+
+    size_t getActiveLeafCount() const;
+
+    /**
+     * Returns true if the node at the same level as node, offset by offset nodes, is split into
+     * children. Nodes outside the tree are never split.
+     */
+    bool isSplit(const Node& node, ivec3 offset) const;
+
+private:
+    template <typename T>
+    class Builder;
+
+    explicit IsoOctree(size3_t dims);
+
+    static std::uint64_t key(size3_t coords);
+    bool isSplit(size_t level, size3_t coords) const;
+    void split(size_t level, size3_t coords);
+
+    size3_t dims_;
+    size_t rootLevel_;
+    std::vector<std::unordered_set<std::uint64_t>> split_;  //!< Split nodes per level
+    std::vector<Node> leaves_;
+};
+
+}  // namespace TNM067
+
+}  // namespace inviwo
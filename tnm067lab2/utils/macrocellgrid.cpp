@@ -0,0 +1,50 @@
+#include <modules/tnm067lab2/utils/macrocellgrid.h>
+#include <modules/tnm067lab1/utils/parallelutils.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace inviwo {
+
+namespace TNM067 {
+
+MacrocellGrid MacrocellGrid::build(const float* values, size3_t dims, size_t cellSize,
+                                   Profile* profile) {
+    TNM067_PROFILE_SCOPE(profile, "Macrocell grid");
+    MacrocellGrid grid;
+    grid.cellSize_ = cellSize;
+    // Voxel positions go up to dims - 1, which is the upper face of the last macrocell
+    grid.dims_ = glm::max((dims - size3_t(1) + size3_t(cellSize - 1)) / size3_t(cellSize),
+                          size3_t(1));
+    grid.ranges_.resize(glm::compMul(grid.dims_));
+
+    const size3_t cells = grid.dims_;
+    forEachRangeParallel(cells.z, [&](size_t begin, size_t end, size_t) {
+        for (size_t cz = begin; cz < end; ++cz) {
+            for (size_t cy = 0; cy < cells.y; ++cy) {
+                for (size_t cx = 0; cx < cells.x; ++cx) {
+                    const size3_t cell{cx, cy, cz};
+                    const size3_t lo = cell * cellSize;
+                    const size3_t hi = glm::min(lo + size3_t(cellSize), dims - size3_t(1));
+                    vec2 range(std::numeric_limits<float>::max(),
+                               std::numeric_limits<float>::lowest());
+                    for (size_t z = lo.z; z <= hi.z; ++z) {
+                        for (size_t y = lo.y; y <= hi.y; ++y) {
+                            const float* row = values + (y + z * dims.y) * dims.x;
+                            for (size_t x = lo.x; x <= hi.x; ++x) {
+                                range.x = std::min(range.x, row[x]);
+                                range.y = std::max(range.y, row[x]);
+                            }
+                        }
+                    }
+                    grid.ranges_[cx + cells.x * (cy + cells.y * cz)] = range;
+                }
+            }
+        }
+    });
+    return grid;
+}
+
+}  // namespace TNM067
+
+}  // namespace inviwo
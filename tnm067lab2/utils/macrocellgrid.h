@@ -0,0 +1,42 @@
+#pragma once
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <modules/tnm067lab1/utils/instrumentation.h>
+#include <inviwo/core/util/glm.h>
+
+#include <vector>
+
+namespace inviwo {
+
+namespace TNM067 {
+
+/**
+ * \class MacrocellGrid
+ * \brief Value range of blocks of cellSize^3 voxels of a volume, used to skip empty space.
+ * Macrocell m covers the voxel positions [m * cellSize, (m + 1) * cellSize] along each axis. Its
+ * range includes the voxels on its upper faces, which it shares with the next macrocell, so
+ * trilinear interpolation anywhere inside a macrocell stays within its range.
+ */
+class IVW_MODULE_TNM067LAB2_API MacrocellGrid {
+public:
+    MacrocellGrid() = default;
+
+    /// Builds the grid of values, dims.x * dims.y * dims.z floats with x fastest
+    static MacrocellGrid build(const float* values, size3_t dims, size_t cellSize,
+                               Profile* profile = nullptr);
+
+    size3_t getDimensions() const { return dims_; }
+    size_t getCellSize() const { return cellSize_; }
+
+    /// Smallest and largest value of every macrocell, x fastest
+    const std::vector<vec2>& getRanges() const { return ranges_; }
+
+private:
+    size3_t dims_{0};
+    size_t cellSize_ = 1;
+    std::vector<vec2> ranges_;
+};
+
+}  // namespace TNM067
+
+}  // namespace inviwo
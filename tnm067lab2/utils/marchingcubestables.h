@@ -0,0 +1,341 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace inviwo {
+
+namespace TNM067 {
+namespace MarchingCubes {
+
+// clang-format off
+/*
+ Corner i of a cell is at (i & 1, (i >> 1) & 1, (i >> 2) & 1), the same numbering as
+ MarchingTetrahedra::calculateDataPointIndexInCell. The case index of a cell has bit i set if the
+ value at corner i is below the iso value.
+
+       6--------7         edges  0-3:  along x
+      /|       /|         edges  4-7:  along y
+     / |      / |         edges 8-11:  along z
+    4--------5  |
+    |  2-----|--3
+    | /      | /
+    |/       |/
+    0--------1
+ */
+// clang-format on
+constexpr std::array<std::array<std::uint8_t, 2>, 12> edgeCorners = {{
+    {0, 1}, {2, 3}, {4, 5}, {6, 7}, {0, 2}, {1, 3},
+    {4, 6}, {5, 7}, {0, 4}, {1, 5}, {2, 6}, {3, 7},
+}};
+
+/**
+ * Bit e is set if the iso surface crosses edge e
+ */
+constexpr std::array<std::uint16_t, 256> edgeTable = {{
+    0x000, 0x111, 0x221, 0x330, 0x412, 0x503, 0x633, 0x722,
+    0x822, 0x933, 0xa03, 0xb12, 0xc30, 0xd21, 0xe11, 0xf00,
+    0x144, 0x055, 0x365, 0x274, 0x556, 0x447, 0x777, 0x666,
+    0x966, 0x877, 0xb47, 0xa56, 0xd74, 0xc65, 0xf55, 0xe44,
+    0x284, 0x395, 0x0a5, 0x1b4, 0x696, 0x787, 0x4b7, 0x5a6,
+    0xaa6, 0xbb7, 0x887, 0x996, 0xeb4, 0xfa5, 0xc95, 0xd84,
+    0x3c0, 0x2d1, 0x1e1, 0x0f0, 0x7d2, 0x6c3, 0x5f3, 0x4e2,
+    0xbe2, 0xaf3, 0x9c3, 0x8d2, 0xff0, 0xee1, 0xdd1, 0xcc0,
+    0x448, 0x559, 0x669, 0x778, 0x05a, 0x14b, 0x27b, 0x36a,
+    0xc6a, 0xd7b, 0xe4b, 0xf5a, 0x878, 0x969, 0xa59, 0xb48,
+    0x50c, 0x41d, 0x72d, 0x63c, 0x11e, 0x00f, 0x33f, 0x22e,
+    0xd2e, 0xc3f, 0xf0f, 0xe1e, 0x93c, 0x82d, 0xb1d, 0xa0c,
+    0x6cc, 0x7dd, 0x4ed, 0x5fc, 0x2de, 0x3cf, 0x0ff, 0x1ee,
+    0xeee, 0xfff, 0xccf, 0xdde, 0xafc, 0xbed, 0x8dd, 0x9cc,
+    0x788, 0x699, 0x5a9, 0x4b8, 0x39a, 0x28b, 0x1bb, 0x0aa,
+    0xfaa, 0xebb, 0xd8b, 0xc9a, 0xbb8, 0xaa9, 0x999, 0x888,
+    0x888, 0x999, 0xaa9, 0xbb8, 0xc9a, 0xd8b, 0xebb, 0xfaa,
+    0x0aa, 0x1bb, 0x28b, 0x39a, 0x4b8, 0x5a9, 0x699, 0x788,
+    0x9cc, 0x8dd, 0xbed, 0xafc, 0xdde, 0xccf, 0xfff, 0xeee,
+    0x1ee, 0x0ff, 0x3cf, 0x2de, 0x5fc, 0x4ed, 0x7dd, 0x6cc,
+    0xa0c, 0xb1d, 0x82d, 0x93c, 0xe1e, 0xf0f, 0xc3f, 0xd2e,
+    0x22e, 0x33f, 0x00f, 0x11e, 0x63c, 0x72d, 0x41d, 0x50c,
+    0xb48, 0xa59, 0x969, 0x878, 0xf5a, 0xe4b, 0xd7b, 0xc6a,
+    0x36a, 0x27b, 0x14b, 0x05a, 0x778, 0x669, 0x559, 0x448,
+    0xcc0, 0xdd1, 0xee1, 0xff0, 0x8d2, 0x9c3, 0xaf3, 0xbe2,
+    0x4e2, 0x5f3, 0x6c3, 0x7d2, 0x0f0, 0x1e1, 0x2d1, 0x3c0,
+    0xd84, 0xc95, 0xfa5, 0xeb4, 0x996, 0x887, 0xbb7, 0xaa6,
+    0x5a6, 0x4b7, 0x787, 0x696, 0x1b4, 0x0a5, 0x395, 0x284,
+    0xe44, 0xf55, 0xc65, 0xd74, 0xa56, 0xb47, 0x877, 0x966,
+    0x666, 0x777, 0x447, 0x556, 0x274, 0x365, 0x055, 0x144,
+    0xf00, 0xe11, 0xd21, 0xc30, 0xb12, 0xa03, 0x933, 0x822,
+    0x722, 0x633, 0x503, 0x412, 0x330, 0x221, 0x111, 0x000,
+}};
+
+/**
+ * Triangles of each case as triplets of edge indices terminated by -1, at most five per case.
+ * The tables are derived from the face intersections of each case: on faces with two diagonally
+ * opposite corners below the iso value those corners are separated, which only depends on the face
+ * and thus gives crack free surfaces between neighboring cells. The polygons are triangulated as
+ * fans where possible, but never with a diagonal between two edges of the same cell face, since
+ * such a diagonal would be shared with the neighboring cell and make the surface non-manifold.
+ * Triangles are ordered so that the normals point towards lower values, like the tetrahedra.
+ */
+constexpr std::array<std::array<std::int8_t, 16>, 256> triTable = {{
+    {{-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 5, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{4, 5, 9, 4, 9, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 4, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 10, 0, 10, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 5, 9, 1, 4, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 5, 9, 1, 9, 8, 1, 8, 10, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 11, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 4, 1, 11, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 1, 11, 0, 11, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 11, 9, 1, 9, 8, 1, 8, 4, -1, -1, -1, -1, -1, -1, -1}},
+    {{4, 10, 11, 4, 11, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 10, 0, 10, 11, 0, 11, 5, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 4, 10, 0, 10, 11, 0, 11, 9, -1, -1, -1, -1, -1, -1, -1}},
+    {{8, 10, 11, 8, 11, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{2, 6, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 2, 6, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 5, 9, 2, 6, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{2, 6, 4, 2, 4, 5, 2, 5, 9, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 4, 10, 2, 6, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 2, 6, 0, 6, 10, 0, 10, 1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 5, 9, 1, 4, 10, 2, 6, 8, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 5, 9, 1, 9, 2, 1, 2, 6, 1, 6, 10, -1, -1, -1, -1}},
+    {{1, 11, 5, 2, 6, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 2, 6, 0, 6, 4, 1, 11, 5, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 1, 11, 0, 11, 9, 2, 6, 8, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 11, 9, 1, 9, 2, 1, 2, 6, 1, 6, 4, -1, -1, -1, -1}},
+    {{2, 6, 8, 4, 10, 11, 4, 11, 5, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 2, 6, 0, 6, 10, 0, 10, 11, 0, 11, 5, -1, -1, -1, -1}},
+    {{0, 4, 10, 0, 10, 11, 0, 11, 9, 2, 6, 8, -1, -1, -1, -1}},
+    {{2, 6, 10, 2, 10, 11, 2, 11, 9, -1, -1, -1, -1, -1, -1, -1}},
+    {{2, 9, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 4, 2, 9, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 5, 7, 0, 7, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{2, 8, 4, 2, 4, 5, 2, 5, 7, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 4, 10, 2, 9, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 10, 0, 10, 1, 2, 9, 7, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 5, 7, 0, 7, 2, 1, 4, 10, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 5, 7, 1, 7, 2, 1, 2, 8, 1, 8, 10, -1, -1, -1, -1}},
+    {{1, 11, 5, 2, 9, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 4, 1, 11, 5, 2, 9, 7, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 1, 11, 0, 11, 7, 0, 7, 2, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 11, 7, 1, 7, 2, 1, 2, 8, 1, 8, 4, -1, -1, -1, -1}},
+    {{2, 9, 7, 4, 10, 11, 4, 11, 5, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 10, 0, 10, 11, 0, 11, 5, 2, 9, 7, -1, -1, -1, -1}},
+    {{0, 4, 10, 0, 10, 11, 0, 11, 7, 0, 7, 2, -1, -1, -1, -1}},
+    {{2, 8, 10, 2, 10, 11, 2, 11, 7, -1, -1, -1, -1, -1, -1, -1}},
+    {{6, 8, 9, 6, 9, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 9, 7, 0, 7, 6, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 5, 7, 0, 7, 6, 0, 6, 8, -1, -1, -1, -1, -1, -1, -1}},
+    {{4, 5, 7, 4, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 4, 10, 6, 8, 9, 6, 9, 7, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 9, 7, 0, 7, 6, 0, 6, 10, 0, 10, 1, -1, -1, -1, -1}},
+    {{0, 5, 7, 0, 7, 6, 0, 6, 8, 1, 4, 10, -1, -1, -1, -1}},
+    {{1, 5, 7, 1, 7, 6, 1, 6, 10, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 11, 5, 6, 8, 9, 6, 9, 7, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 9, 7, 0, 7, 6, 0, 6, 4, 1, 11, 5, -1, -1, -1, -1}},
+    {{0, 1, 11, 0, 11, 7, 0, 7, 6, 0, 6, 8, -1, -1, -1, -1}},
+    {{1, 11, 7, 1, 7, 6, 1, 6, 4, -1, -1, -1, -1, -1, -1, -1}},
+    {{4, 10, 11, 4, 11, 5, 6, 8, 9, 6, 9, 7, -1, -1, -1, -1}},
+    {{0, 9, 7, 0, 7, 6, 0, 6, 10, 0, 10, 11, 0, 11, 5, -1}},
+    {{0, 4, 10, 0, 10, 11, 0, 11, 7, 0, 7, 6, 0, 6, 8, -1}},
+    {{6, 10, 11, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{3, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 4, 3, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 5, 9, 3, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{3, 10, 6, 4, 5, 9, 4, 9, 8, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 4, 6, 1, 6, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 6, 0, 6, 3, 0, 3, 1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 5, 9, 1, 4, 6, 1, 6, 3, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 5, 9, 1, 9, 8, 1, 8, 6, 1, 6, 3, -1, -1, -1, -1}},
+    {{1, 11, 5, 3, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 4, 1, 11, 5, 3, 10, 6, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 1, 11, 0, 11, 9, 3, 10, 6, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 11, 9, 1, 9, 8, 1, 8, 4, 3, 10, 6, -1, -1, -1, -1}},
+    {{3, 11, 5, 3, 5, 4, 3, 4, 6, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 6, 0, 6, 3, 0, 3, 11, 0, 11, 5, -1, -1, -1, -1}},
+    {{0, 4, 6, 0, 6, 3, 0, 3, 11, 0, 11, 9, -1, -1, -1, -1}},
+    {{3, 11, 9, 3, 9, 8, 3, 8, 6, -1, -1, -1, -1, -1, -1, -1}},
+    {{2, 3, 10, 2, 10, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 2, 3, 0, 3, 10, 0, 10, 4, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 5, 9, 2, 3, 10, 2, 10, 8, -1, -1, -1, -1, -1, -1, -1}},
+    {{2, 3, 10, 2, 10, 4, 2, 4, 5, 2, 5, 9, -1, -1, -1, -1}},
+    {{1, 4, 8, 1, 8, 2, 1, 2, 3, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 2, 3, 0, 3, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 5, 9, 1, 4, 8, 1, 8, 2, 1, 2, 3, -1, -1, -1, -1}},
+    {{1, 5, 9, 1, 9, 2, 1, 2, 3, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 11, 5, 2, 3, 10, 2, 10, 8, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 2, 3, 0, 3, 10, 0, 10, 4, 1, 11, 5, -1, -1, -1, -1}},
+    {{0, 1, 11, 0, 11, 9, 2, 3, 10, 2, 10, 8, -1, -1, -1, -1}},
+    {{9, 2, 3, 9, 3, 10, 9, 10, 4, 9, 4, 1, 9, 1, 11, -1}},
+    {{2, 3, 11, 2, 11, 5, 2, 5, 4, 2, 4, 8, -1, -1, -1, -1}},
+    {{0, 2, 3, 0, 3, 11, 0, 11, 5, -1, -1, -1, -1, -1, -1, -1}},
+    {{4, 8, 2, 4, 2, 3, 4, 3, 11, 4, 11, 9, 4, 9, 0, -1}},
+    {{2, 3, 11, 2, 11, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{2, 9, 7, 3, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 4, 2, 9, 7, 3, 10, 6, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 5, 7, 0, 7, 2, 3, 10, 6, -1, -1, -1, -1, -1, -1, -1}},
+    {{2, 8, 4, 2, 4, 5, 2, 5, 7, 3, 10, 6, -1, -1, -1, -1}},
+    {{1, 4, 6, 1, 6, 3, 2, 9, 7, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 6, 0, 6, 3, 0, 3, 1, 2, 9, 7, -1, -1, -1, -1}},
+    {{0, 5, 7, 0, 7, 2, 1, 4, 6, 1, 6, 3, -1, -1, -1, -1}},
+    {{1, 5, 7, 1, 7, 2, 1, 2, 8, 1, 8, 6, 1, 6, 3, -1}},
+    {{1, 11, 5, 2, 9, 7, 3, 10, 6, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 4, 1, 11, 5, 2, 9, 7, 3, 10, 6, -1, -1, -1, -1}},
+    {{0, 1, 11, 0, 11, 7, 0, 7, 2, 3, 10, 6, -1, -1, -1, -1}},
+    {{1, 11, 7, 1, 7, 2, 1, 2, 8, 1, 8, 4, 3, 10, 6, -1}},
+    {{2, 9, 7, 3, 11, 5, 3, 5, 4, 3, 4, 6, -1, -1, -1, -1}},
+    {{0, 8, 6, 0, 6, 3, 0, 3, 11, 0, 11, 5, 2, 9, 7, -1}},
+    {{0, 4, 6, 0, 6, 3, 0, 3, 11, 0, 11, 7, 0, 7, 2, -1}},
+    {{8, 6, 3, 8, 3, 11, 8, 11, 7, 8, 7, 2, -1, -1, -1, -1}},
+    {{3, 10, 8, 3, 8, 9, 3, 9, 7, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 9, 7, 0, 7, 3, 0, 3, 10, 0, 10, 4, -1, -1, -1, -1}},
+    {{0, 5, 7, 0, 7, 3, 0, 3, 10, 0, 10, 8, -1, -1, -1, -1}},
+    {{3, 10, 4, 3, 4, 5, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 4, 8, 1, 8, 9, 1, 9, 7, 1, 7, 3, -1, -1, -1, -1}},
+    {{0, 9, 7, 0, 7, 3, 0, 3, 1, -1, -1, -1, -1, -1, -1, -1}},
+    {{7, 3, 1, 7, 1, 4, 7, 4, 8, 7, 8, 0, 7, 0, 5, -1}},
+    {{1, 5, 7, 1, 7, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 11, 5, 3, 10, 8, 3, 8, 9, 3, 9, 7, -1, -1, -1, -1}},
+    {{0, 9, 7, 0, 7, 3, 0, 3, 10, 0, 10, 4, 1, 11, 5, -1}},
+    {{0, 1, 11, 0, 11, 7, 0, 7, 3, 0, 3, 10, 0, 10, 8, -1}},
+    {{7, 3, 10, 7, 10, 4, 7, 4, 1, 7, 1, 11, -1, -1, -1, -1}},
+    {{3, 11, 5, 3, 5, 4, 3, 4, 8, 3, 8, 9, 3, 9, 7, -1}},
+    {{0, 9, 7, 0, 7, 3, 0, 3, 11, 0, 11, 5, -1, -1, -1, -1}},
+    {{0, 4, 8, 3, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{3, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{3, 7, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 4, 3, 7, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 5, 9, 3, 7, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{3, 7, 11, 4, 5, 9, 4, 9, 8, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 4, 10, 3, 7, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 10, 0, 10, 1, 3, 7, 11, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 5, 9, 1, 4, 10, 3, 7, 11, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 5, 9, 1, 9, 8, 1, 8, 10, 3, 7, 11, -1, -1, -1, -1}},
+    {{1, 3, 7, 1, 7, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 4, 1, 3, 7, 1, 7, 5, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 1, 3, 0, 3, 7, 0, 7, 9, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 3, 7, 1, 7, 9, 1, 9, 8, 1, 8, 4, -1, -1, -1, -1}},
+    {{3, 7, 5, 3, 5, 4, 3, 4, 10, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 10, 0, 10, 3, 0, 3, 7, 0, 7, 5, -1, -1, -1, -1}},
+    {{0, 4, 10, 0, 10, 3, 0, 3, 7, 0, 7, 9, -1, -1, -1, -1}},
+    {{3, 7, 9, 3, 9, 8, 3, 8, 10, -1, -1, -1, -1, -1, -1, -1}},
+    {{2, 6, 8, 3, 7, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 2, 6, 0, 6, 4, 3, 7, 11, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 5, 9, 2, 6, 8, 3, 7, 11, -1, -1, -1, -1, -1, -1, -1}},
+    {{2, 6, 4, 2, 4, 5, 2, 5, 9, 3, 7, 11, -1, -1, -1, -1}},
+    {{1, 4, 10, 2, 6, 8, 3, 7, 11, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 2, 6, 0, 6, 10, 0, 10, 1, 3, 7, 11, -1, -1, -1, -1}},
+    {{0, 5, 9, 1, 4, 10, 2, 6, 8, 3, 7, 11, -1, -1, -1, -1}},
+    {{1, 5, 9, 1, 9, 2, 1, 2, 6, 1, 6, 10, 3, 7, 11, -1}},
+    {{1, 3, 7, 1, 7, 5, 2, 6, 8, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 2, 6, 0, 6, 4, 1, 3, 7, 1, 7, 5, -1, -1, -1, -1}},
+    {{0, 1, 3, 0, 3, 7, 0, 7, 9, 2, 6, 8, -1, -1, -1, -1}},
+    {{1, 3, 7, 1, 7, 9, 1, 9, 2, 1, 2, 6, 1, 6, 4, -1}},
+    {{2, 6, 8, 3, 7, 5, 3, 5, 4, 3, 4, 10, -1, -1, -1, -1}},
+    {{0, 2, 6, 0, 6, 10, 0, 10, 3, 0, 3, 7, 0, 7, 5, -1}},
+    {{0, 4, 10, 0, 10, 3, 0, 3, 7, 0, 7, 9, 2, 6, 8, -1}},
+    {{10, 3, 7, 10, 7, 9, 10, 9, 2, 10, 2, 6, -1, -1, -1, -1}},
+    {{2, 9, 11, 2, 11, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 4, 2, 9, 11, 2, 11, 3, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 5, 11, 0, 11, 3, 0, 3, 2, -1, -1, -1, -1, -1, -1, -1}},
+    {{2, 8, 4, 2, 4, 5, 2, 5, 11, 2, 11, 3, -1, -1, -1, -1}},
+    {{1, 4, 10, 2, 9, 11, 2, 11, 3, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 10, 0, 10, 1, 2, 9, 11, 2, 11, 3, -1, -1, -1, -1}},
+    {{0, 5, 11, 0, 11, 3, 0, 3, 2, 1, 4, 10, -1, -1, -1, -1}},
+    {{5, 11, 3, 5, 3, 2, 5, 2, 8, 5, 8, 10, 5, 10, 1, -1}},
+    {{1, 3, 2, 1, 2, 9, 1, 9, 5, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 4, 1, 3, 2, 1, 2, 9, 1, 9, 5, -1, -1, -1, -1}},
+    {{0, 1, 3, 0, 3, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 3, 2, 1, 2, 8, 1, 8, 4, -1, -1, -1, -1, -1, -1, -1}},
+    {{2, 9, 5, 2, 5, 4, 2, 4, 10, 2, 10, 3, -1, -1, -1, -1}},
+    {{10, 3, 2, 10, 2, 9, 10, 9, 5, 10, 5, 0, 10, 0, 8, -1}},
+    {{0, 4, 10, 0, 10, 3, 0, 3, 2, -1, -1, -1, -1, -1, -1, -1}},
+    {{2, 8, 10, 2, 10, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{3, 6, 8, 3, 8, 9, 3, 9, 11, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 9, 11, 0, 11, 3, 0, 3, 6, 0, 6, 4, -1, -1, -1, -1}},
+    {{0, 5, 11, 0, 11, 3, 0, 3, 6, 0, 6, 8, -1, -1, -1, -1}},
+    {{3, 6, 4, 3, 4, 5, 3, 5, 11, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 4, 10, 3, 6, 8, 3, 8, 9, 3, 9, 11, -1, -1, -1, -1}},
+    {{0, 9, 11, 0, 11, 3, 0, 3, 6, 0, 6, 10, 0, 10, 1, -1}},
+    {{0, 5, 11, 0, 11, 3, 0, 3, 6, 0, 6, 8, 1, 4, 10, -1}},
+    {{5, 11, 3, 5, 3, 6, 5, 6, 10, 5, 10, 1, -1, -1, -1, -1}},
+    {{1, 3, 6, 1, 6, 8, 1, 8, 9, 1, 9, 5, -1, -1, -1, -1}},
+    {{9, 5, 1, 9, 1, 3, 9, 3, 6, 9, 6, 4, 9, 4, 0, -1}},
+    {{0, 1, 3, 0, 3, 6, 0, 6, 8, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 3, 6, 1, 6, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{3, 6, 8, 3, 8, 9, 3, 9, 5, 3, 5, 4, 3, 4, 10, -1}},
+    {{0, 9, 5, 3, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 4, 10, 0, 10, 3, 0, 3, 6, 0, 6, 8, -1, -1, -1, -1}},
+    {{3, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{6, 7, 11, 6, 11, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 4, 6, 7, 11, 6, 11, 10, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 5, 9, 6, 7, 11, 6, 11, 10, -1, -1, -1, -1, -1, -1, -1}},
+    {{4, 5, 9, 4, 9, 8, 6, 7, 11, 6, 11, 10, -1, -1, -1, -1}},
+    {{1, 4, 6, 1, 6, 7, 1, 7, 11, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 6, 0, 6, 7, 0, 7, 11, 0, 11, 1, -1, -1, -1, -1}},
+    {{0, 5, 9, 1, 4, 6, 1, 6, 7, 1, 7, 11, -1, -1, -1, -1}},
+    {{1, 5, 9, 1, 9, 8, 1, 8, 6, 1, 6, 7, 1, 7, 11, -1}},
+    {{1, 10, 6, 1, 6, 7, 1, 7, 5, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 4, 1, 10, 6, 1, 6, 7, 1, 7, 5, -1, -1, -1, -1}},
+    {{0, 1, 10, 0, 10, 6, 0, 6, 7, 0, 7, 9, -1, -1, -1, -1}},
+    {{1, 10, 6, 1, 6, 7, 1, 7, 9, 1, 9, 8, 1, 8, 4, -1}},
+    {{4, 6, 7, 4, 7, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 6, 0, 6, 7, 0, 7, 5, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 4, 6, 0, 6, 7, 0, 7, 9, -1, -1, -1, -1, -1, -1, -1}},
+    {{6, 7, 9, 6, 9, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{2, 7, 11, 2, 11, 10, 2, 10, 8, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 2, 7, 0, 7, 11, 0, 11, 10, 0, 10, 4, -1, -1, -1, -1}},
+    {{0, 5, 9, 2, 7, 11, 2, 11, 10, 2, 10, 8, -1, -1, -1, -1}},
+    {{2, 7, 11, 2, 11, 10, 2, 10, 4, 2, 4, 5, 2, 5, 9, -1}},
+    {{1, 4, 8, 1, 8, 2, 1, 2, 7, 1, 7, 11, -1, -1, -1, -1}},
+    {{0, 2, 7, 0, 7, 11, 0, 11, 1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 5, 9, 1, 4, 8, 1, 8, 2, 1, 2, 7, 1, 7, 11, -1}},
+    {{1, 5, 9, 1, 9, 2, 1, 2, 7, 1, 7, 11, -1, -1, -1, -1}},
+    {{1, 10, 8, 1, 8, 2, 1, 2, 7, 1, 7, 5, -1, -1, -1, -1}},
+    {{2, 7, 5, 2, 5, 1, 2, 1, 10, 2, 10, 4, 2, 4, 0, -1}},
+    {{1, 10, 8, 1, 8, 2, 1, 2, 7, 1, 7, 9, 1, 9, 0, -1}},
+    {{1, 10, 4, 2, 7, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{2, 7, 5, 2, 5, 4, 2, 4, 8, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 2, 7, 0, 7, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{4, 8, 2, 4, 2, 7, 4, 7, 9, 4, 9, 0, -1, -1, -1, -1}},
+    {{2, 7, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{2, 9, 11, 2, 11, 10, 2, 10, 6, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 8, 4, 2, 9, 11, 2, 11, 10, 2, 10, 6, -1, -1, -1, -1}},
+    {{0, 5, 11, 0, 11, 10, 0, 10, 6, 0, 6, 2, -1, -1, -1, -1}},
+    {{2, 8, 4, 2, 4, 5, 2, 5, 11, 2, 11, 10, 2, 10, 6, -1}},
+    {{1, 4, 6, 1, 6, 2, 1, 2, 9, 1, 9, 11, -1, -1, -1, -1}},
+    {{6, 2, 9, 6, 9, 11, 6, 11, 1, 6, 1, 0, 6, 0, 8, -1}},
+    {{11, 1, 4, 11, 4, 6, 11, 6, 2, 11, 2, 0, 11, 0, 5, -1}},
+    {{1, 5, 11, 2, 8, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 10, 6, 1, 6, 2, 1, 2, 9, 1, 9, 5, -1, -1, -1, -1}},
+    {{0, 8, 4, 1, 10, 6, 1, 6, 2, 1, 2, 9, 1, 9, 5, -1}},
+    {{0, 1, 10, 0, 10, 6, 0, 6, 2, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 10, 6, 1, 6, 2, 1, 2, 8, 1, 8, 4, -1, -1, -1, -1}},
+    {{2, 9, 5, 2, 5, 4, 2, 4, 6, -1, -1, -1, -1, -1, -1, -1}},
+    {{6, 2, 9, 6, 9, 5, 6, 5, 0, 6, 0, 8, -1, -1, -1, -1}},
+    {{0, 4, 6, 0, 6, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{2, 8, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{8, 9, 11, 8, 11, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 9, 11, 0, 11, 10, 0, 10, 4, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 5, 11, 0, 11, 10, 0, 10, 8, -1, -1, -1, -1, -1, -1, -1}},
+    {{4, 5, 11, 4, 11, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 4, 8, 1, 8, 9, 1, 9, 11, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 9, 11, 0, 11, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{11, 1, 4, 11, 4, 8, 11, 8, 0, 11, 0, 5, -1, -1, -1, -1}},
+    {{1, 5, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 10, 8, 1, 8, 9, 1, 9, 5, -1, -1, -1, -1, -1, -1, -1}},
+    {{9, 5, 1, 9, 1, 10, 9, 10, 4, 9, 4, 0, -1, -1, -1, -1}},
+    {{0, 1, 10, 0, 10, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{1, 10, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{4, 8, 9, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 9, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{0, 4, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+    {{-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}},
+}};
+
+}  // namespace MarchingCubes
+}  // namespace TNM067
+
+}  // namespace inviwo
@@ -0,0 +1,248 @@
+#include <modules/tnm067lab2/utils/meshexport.h>
+#include <inviwo/core/datastructures/buffer/bufferram.h>
+#include <inviwo/core/util/exception.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+namespace inviwo {
+
+namespace TNM067 {
+
+namespace {
+
+struct MeshData {
+    std::vector<vec3> positions;
+    std::vector<vec3> normals;
+    std::vector<glm::u8vec4> colors;
+    std::vector<std::uint32_t> triangles;
+};
+
+MeshData collect(const Mesh& mesh) {
+    MeshData data;
+
+    const mat4 toWorld = mesh.getWorldMatrix() * mesh.getModelMatrix();
+    const mat3 normalToWorld = glm::transpose(glm::inverse(mat3(toWorld)));
+
+    if (auto positions = mesh.findBuffer(BufferType::PositionAttrib).first) {
+        const auto ram = positions->getRepresentation<BufferRAM>();
+        data.positions.reserve(ram->getSize());
+        for (size_t i = 0; i < ram->getSize(); ++i) {
+            data.positions.push_back(vec3(toWorld * vec4(vec3(ram->getAsDVec3(i)), 1.0f)));
+        }
+    }
+    if (auto normals = mesh.findBuffer(BufferType::NormalAttrib).first) {
+        const auto ram = normals->getRepresentation<BufferRAM>();
+        data.normals.reserve(ram->getSize());
+        for (size_t i = 0; i < ram->getSize(); ++i) {
+            data.normals.push_back(glm::normalize(normalToWorld * vec3(ram->getAsDVec3(i))));
+        }
+    }
+    if (auto colors = mesh.findBuffer(BufferType::ColorAttrib).first) {
+        const auto ram = colors->getRepresentation<BufferRAM>();
+        data.colors.reserve(ram->getSize());
+        for (size_t i = 0; i < ram->getSize(); ++i) {
+            const dvec4 c = glm::clamp(ram->getAsDVec4(i), dvec4(0.0), dvec4(1.0));
+            data.colors.push_back(glm::u8vec4(c * 255.0 + 0.5));
+        }
+    }
+
+    data.triangles = collectTriangles(mesh);
+
+    return data;
+}
+
+std::ofstream open(const std::string& path, std::ios::openmode mode) {
+    std::ofstream out(path, mode);
+    if (!out) {
+        throw FileException("Could not open " + path + " for writing", IVW_CONTEXT_CUSTOM("TNM067"));
+    }
+    return out;
+}
+
+/// Width of the element counts of a streamed PLY header, which are filled in when done
+constexpr int countWidth = 20;
+
+}  // namespace
+
+std::vector<std::uint32_t> collectTriangles(const Mesh& mesh) {
+    std::vector<std::uint32_t> triangles;
+
+    constexpr auto restart = std::numeric_limits<std::uint32_t>::max();
+    for (size_t i = 0; i < mesh.getNumberOfIndicies(); ++i) {
+        const auto info = mesh.getIndexMeshInfo(i);
+        if (info.dt != DrawType::Triangles) continue;
+        const auto& indices =
+            mesh.getIndices(i)->getRAMRepresentation()->getDataContainer();
+
+        if (info.ct == ConnectivityType::Strip) {
+            size_t start = 0;
+            for (size_t j = 0; j < indices.size(); ++j) {
+                if (indices[j] == restart) {
+                    start = j + 1;
+                    continue;
+                }
+                if (j < start + 2) continue;
+                const auto a = indices[j - 2];
+                const auto b = indices[j - 1];
+                const auto c = indices[j];
+                if (a == b || b == c || a == c) continue;
+                // Every other triangle in a strip has reversed winding
+                if ((j - start) % 2 == 0) {
+                    triangles.insert(triangles.end(), {a, b, c});
+                } else {
+                    triangles.insert(triangles.end(), {b, a, c});
+                }
+            }
+        } else {
+            triangles.insert(triangles.end(), indices.begin(),
+                             indices.begin() + (indices.size() / 3) * 3);
+        }
+    }
+
+    return triangles;
+}
+
+void writePLY(const Mesh& mesh, const std::string& path) {
+    const auto data = collect(mesh);
+    const bool hasNormals = data.normals.size() == data.positions.size();
+    const bool hasColors = data.colors.size() == data.positions.size();
+
+    auto out = open(path, std::ios::out | std::ios::binary);
+    out << "ply\nformat binary_little_endian 1.0\n";
+    out << "element vertex " << data.positions.size() << "\n";
+    out << "property float x\nproperty float y\nproperty float z\n";
+    if (hasNormals) out << "property float nx\nproperty float ny\nproperty float nz\n";
+    if (hasColors) {
+        out << "property uchar red\nproperty uchar green\nproperty uchar blue\n"
+               "property uchar alpha\n";
+    }
+    out << "element face " << data.triangles.size() / 3 << "\n";
+    out << "property list uchar uint vertex_indices\nend_header\n";
+
+    for (size_t i = 0; i < data.positions.size(); ++i) {
+        out.write(reinterpret_cast<const char*>(&data.positions[i]), sizeof(vec3));
+        if (hasNormals) out.write(reinterpret_cast<const char*>(&data.normals[i]), sizeof(vec3));
+        if (hasColors) {
+            out.write(reinterpret_cast<const char*>(&data.colors[i]), sizeof(glm::u8vec4));
+        }
+    }
+    const std::uint8_t three = 3;
+    for (size_t i = 0; i < data.triangles.size(); i += 3) {
+        out.write(reinterpret_cast<const char*>(&three), 1);
+        out.write(reinterpret_cast<const char*>(&data.triangles[i]), 3 * sizeof(std::uint32_t));
+    }
+}
+
+void writeOBJ(const Mesh& mesh, const std::string& path) {
+    const auto data = collect(mesh);
+    const bool hasNormals = data.normals.size() == data.positions.size();
+    const bool hasColors = data.colors.size() == data.positions.size();
+
+    auto out = open(path, std::ios::out);
+    for (size_t i = 0; i < data.positions.size(); ++i) {
+        const auto& p = data.positions[i];
+        out << "v " << p.x << " " << p.y << " " << p.z;
+        // Vertex colors are a common OBJ extension understood by most tools
+        if (hasColors) {
+            const vec3 c = vec3(data.colors[i]) / 255.0f;
+            out << " " << c.r << " " << c.g << " " << c.b;
+        }
+        out << "\n";
+    }
+    if (hasNormals) {
+        for (const auto& n : data.normals) {
+            out << "vn " << n.x << " " << n.y << " " << n.z << "\n";
+        }
+    }
+    for (size_t i = 0; i < data.triangles.size(); i += 3) {
+        out << "f";
+        for (size_t j = 0; j < 3; ++j) {
+            const auto index = data.triangles[i + j] + 1;
+            out << " " << index;
+            if (hasNormals) out << "//" << index;
+        }
+        out << "\n";
+    }
+}
+
+PLYStreamWriter::PLYStreamWriter(const std::string& path, const mat4& toWorld)
+    : path_(path)
+    , facesPath_(path + ".faces")
+    , out_(open(path_, std::ios::out | std::ios::binary))
+    , faces_(open(facesPath_, std::ios::out | std::ios::binary))
+    , toWorld_(toWorld)
+    , normalToWorld_(glm::transpose(glm::inverse(mat3(toWorld)))) {
+    // The counts are padded with spaces, which PLY readers skip like any whitespace
+    out_ << "ply\nformat binary_little_endian 1.0\nelement vertex ";
+    vertexCountPos_ = out_.tellp();
+    out_ << std::left << std::setw(countWidth) << 0 << "\n";
+    out_ << "property float x\nproperty float y\nproperty float z\n";
+    out_ << "property float nx\nproperty float ny\nproperty float nz\n";
+    out_ << "element face ";
+    faceCountPos_ = out_.tellp();
+    out_ << std::left << std::setw(countWidth) << 0 << "\n";
+    out_ << "property list uchar uint vertex_indices\nend_header\n";
+}
+
+PLYStreamWriter::~PLYStreamWriter() {
+    if (faces_.is_open()) faces_.close();
+    std::error_code ec;
+    std::filesystem::remove(facesPath_, ec);
+    if (!finished_) {
+        out_.close();
+        std::filesystem::remove(path_, ec);
+    }
+}
+
+std::uint32_t PLYStreamWriter::addVertex(const vec3& pos, const vec3& normal) {
+    const vec3 n = normalToWorld_ * normal;
+    const float length = glm::length(n);
+    vertices_.push_back(vec3(toWorld_ * vec4(pos, 1.0f)));
+    vertices_.push_back(length > 0.0f ? n / length : vec3(0.0f));
+    return static_cast<std::uint32_t>(vertexCount_++);
+}
+
+void PLYStreamWriter::addTriangle(std::uint32_t i0, std::uint32_t i1, std::uint32_t i2) {
+    const std::uint32_t indices[3] = {i0, i1, i2};
+    const size_t offset = triangles_.size();
+    triangles_.resize(offset + 1 + sizeof(indices));
+    triangles_[offset] = 3;
+    std::memcpy(triangles_.data() + offset + 1, indices, sizeof(indices));
+    ++triangleCount_;
+}
+
+void PLYStreamWriter::flush() {
+    out_.write(reinterpret_cast<const char*>(vertices_.data()),
+               static_cast<std::streamsize>(vertices_.size() * sizeof(vec3)));
+    faces_.write(triangles_.data(), static_cast<std::streamsize>(triangles_.size()));
+    vertices_.clear();
+    triangles_.clear();
+    if (!out_ || !faces_) {
+        throw FileException("Could not write " + path_, IVW_CONTEXT_CUSTOM("TNM067"));
+    }
+}
+
+void PLYStreamWriter::finish() {
+    flush();
+    faces_.close();
+    {
+        std::ifstream faces(facesPath_, std::ios::in | std::ios::binary);
+        if (triangleCount_ > 0) out_ << faces.rdbuf();
+    }
+
+    out_.seekp(vertexCountPos_);
+    out_ << std::left << std::setw(countWidth) << vertexCount_;
+    out_.seekp(faceCountPos_);
+    out_ << std::left << std::setw(countWidth) << triangleCount_;
+    out_.close();
+    if (!out_) throw FileException("Could not write " + path_, IVW_CONTEXT_CUSTOM("TNM067"));
+    finished_ = true;
+}
+
+}  // namespace TNM067
+
+}  // namespace inviwo
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <inviwo/core/datastructures/geometry/mesh.h>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace inviwo {
+
+namespace TNM067 {
+
+/**
+ * Returns the triangles of all triangle index buffers of mesh as triplets of vertex indices.
+ * Triangle strips are converted to triangles, other index buffers are skipped.
+ */
+IVW_MODULE_TNM067LAB2_API std::vector<std::uint32_t> collectTriangles(const Mesh& mesh);
+
+/**
+ * Writes the triangles of mesh to a binary little endian PLY file. Positions are transformed to
+ * world space, normals and colors are written if the mesh has them. Index buffers that are not
+ * triangles are skipped, triangle strips are converted to triangles.
+ * @throw FileException if the file could not be written
+ */
+IVW_MODULE_TNM067LAB2_API void writePLY(const Mesh& mesh, const std::string& path);
+
+/**
+ * Writes the triangles of mesh to a Wavefront OBJ file, see writePLY.
+ * @throw FileException if the file could not be written
+ */
+IVW_MODULE_TNM067LAB2_API void writeOBJ(const Mesh& mesh, const std::string& path);
+
+/**
+ * \class PLYStreamWriter
+ * \brief Writes a binary little endian PLY file of positions, normals and triangles while they
+ * are produced, without holding the mesh in memory.
+ * Vertices are appended to the file and triangles to a temporary file next to it, only what was
+ * added since the last flush() is buffered. finish() appends the triangles and fills in the
+ * element counts of the header. A writer destroyed before finish() removes both files.
+ * @throw FileException if the files could not be written
+ */
+class IVW_MODULE_TNM067LAB2_API PLYStreamWriter {
+public:
+    /// Positions and normals are transformed by toWorld when written, like in writePLY
+    PLYStreamWriter(const std::string& path, const mat4& toWorld);
+    PLYStreamWriter(const PLYStreamWriter&) = delete;
+    PLYStreamWriter& operator=(const PLYStreamWriter&) = delete;
+    ~PLYStreamWriter();
+
+    /// Adds a vertex and returns its index, normal need not be normalized
+    std::uint32_t addVertex(const vec3& pos, const vec3& normal);
+    void addTriangle(std::uint32_t i0, std::uint32_t i1, std::uint32_t i2);
+
+    /// Writes the buffered vertices and triangles
+    void flush();
+    void finish();
+
+    size_t getVertexCount() const { return vertexCount_; }
+    size_t getTriangleCount() const { return triangleCount_; }
+
+private:
+    std::string path_;
+    std::string facesPath_;
+    std::ofstream out_;
+    std::ofstream faces_;
+    mat4 toWorld_;
+    mat3 normalToWorld_;
+    std::streampos vertexCountPos_;
+    std::streampos faceCountPos_;
+    std::vector<vec3> vertices_;  //!< Position and normal of every buffered vertex
+    std::vector<char> triangles_;
+    size_t vertexCount_ = 0;
+    size_t triangleCount_ = 0;
+    bool finished_ = false;
+};
+
+}  // namespace TNM067
+
+}  // namespace inviwo
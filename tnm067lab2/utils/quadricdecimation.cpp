@@ -0,0 +1,493 @@
+#include <modules/tnm067lab2/utils/quadricdecimation.h>
+#include <modules/tnm067lab2/utils/meshexport.h>
+#include <modules/tnm067lab1/utils/parallelutils.h>
+#include <inviwo/core/datastructures/buffer/bufferram.h>
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <tuple>
+
+namespace inviwo {
+
+namespace TNM067 {
+
+Quadric Quadric::plane(const dvec3& n, double d, double weight) {
+    Quadric q;
+    q.m_ = {n.x * n.x, n.x * n.y, n.x * n.z, n.x * d, n.y * n.y,
+            n.y * n.z, n.y * d,   n.z * n.z, n.z * d, d * d};
+    for (auto& v : q.m_) v *= weight;
+    return q;
+}
+
+Quadric& Quadric::operator+=(const Quadric& rhs) {
+    for (size_t i = 0; i < m_.size(); ++i) m_[i] += rhs.m_[i];
+    return *this;
+}
+
+Quadric Quadric::operator+(const Quadric& rhs) const {
+    Quadric q(*this);
+    q += rhs;
+    return q;
+}
+
+double Quadric::error(const dvec3& p) const {
+    const auto& m = m_;
+    const double e = m[0] * p.x * p.x + 2.0 * m[1] * p.x * p.y + 2.0 * m[2] * p.x * p.z +
+                     2.0 * m[3] * p.x + m[4] * p.y * p.y + 2.0 * m[5] * p.y * p.z +
+                     2.0 * m[6] * p.y + m[7] * p.z * p.z + 2.0 * m[8] * p.z + m[9];
+    return std::max(e, 0.0);
+}
+
+bool Quadric::minimize(dvec3& p) const {
+    const auto& m = m_;
+    const dmat3 a(m[0], m[1], m[2], m[1], m[4], m[5], m[2], m[5], m[7]);
+    const double det = glm::determinant(a);
+    // Relative to the scale of the matrix, flat and linear regions give (near) singular matrices
+    const double scale = m[0] + m[4] + m[7];
+    if (std::abs(det) <= 1e-12 * scale * scale * scale) return false;
+    p = glm::inverse(a) * -dvec3(m[3], m[6], m[8]);
+    return true;
+}
+
+namespace {
+
+constexpr std::uint32_t invalid = std::numeric_limits<std::uint32_t>::max();
+
+std::uint32_t next(std::uint32_t h) { return h - h % 3 + (h + 1) % 3; }
+std::uint32_t prev(std::uint32_t h) { return h - h % 3 + (h + 2) % 3; }
+
+/**
+ * Half-edge h belongs to triangle h / 3 and starts at vertex origin[h], the next half-edge of the
+ * triangle is next(h). twin[h] is the opposite half-edge in the neighboring triangle or invalid for
+ * boundary edges. All arrays are flat and indexed by half-edge, triangle or vertex.
+ */
+class Decimator {
+public:
+    Decimator(std::vector<dvec3> positions, std::vector<std::uint32_t> triangles)
+        : positions_(std::move(positions))
+        , origin_(std::move(triangles))
+        , twin_(origin_.size(), invalid)
+        , removed_(origin_.size() / 3, false)
+        , vertexEdge_(positions_.size(), invalid)
+        , locked_(positions_.size(), false)
+        , version_(positions_.size(), 0)
+        , quadrics_(positions_.size())
+        , liveTriangles_(origin_.size() / 3) {}
+
+    void build(Profile* profile);
+    void collapse(size_t targetTriangles, double maxError, DecimationStats& stats,
+                  Profile* profile);
+
+    size_t liveTriangles() const { return liveTriangles_; }
+    bool isRemoved(size_t triangle) const { return removed_[triangle]; }
+    size_t lockedVertices() const { return std::count(locked_.begin(), locked_.end(), true); }
+    std::uint32_t origin(std::uint32_t h) const { return origin_[h]; }
+    const dvec3& position(size_t v) const { return positions_[v]; }
+
+    /// Called for every collapse of a into b with the interpolation parameter of the new position
+    std::function<void(std::uint32_t a, std::uint32_t b, double s)> onCollapse;
+
+private:
+    struct Candidate {
+        double cost;
+        dvec3 pos;
+        std::uint32_t edge;
+        std::uint32_t a;
+        std::uint32_t b;
+        std::uint32_t versionA;
+        std::uint32_t versionB;
+
+        bool operator<(const Candidate& rhs) const { return cost > rhs.cost; }
+    };
+
+    std::uint32_t dest(std::uint32_t h) const { return origin_[next(h)]; }
+
+    /**
+     * Calls f(h) for all outgoing half-edges of v, returns false if the fan around v is open
+     */
+    template <typename F>
+    bool forEachOutgoing(std::uint32_t v, F f) const {
+        const std::uint32_t start = vertexEdge_[v];
+        if (start == invalid) return true;
+        std::uint32_t h = start;
+        do {
+            f(h);
+            h = twin_[prev(h)];
+        } while (h != invalid && h != start);
+        if (h == start) return true;
+
+        // Open fan, walk the other way from start as well
+        for (h = twin_[start]; h != invalid; h = twin_[h]) {
+            h = next(h);
+            f(h);
+        }
+        return false;
+    }
+
+    bool isBoundary(std::uint32_t v) const {
+        return !forEachOutgoing(v, [](std::uint32_t) {});
+    }
+
+    Candidate evaluate(std::uint32_t h) const;
+    bool canCollapse(const Candidate& c) const;
+    void apply(const Candidate& c);
+    void pushCandidates(std::uint32_t v);
+
+    std::vector<dvec3> positions_;
+    std::vector<std::uint32_t> origin_;
+    std::vector<std::uint32_t> twin_;
+    std::vector<bool> removed_;
+    std::vector<std::uint32_t> vertexEdge_;
+    std::vector<bool> locked_;
+    std::vector<std::uint32_t> version_;
+    std::vector<Quadric> quadrics_;
+    std::priority_queue<Candidate> heap_;
+    size_t liveTriangles_;
+};
+
+void Decimator::build(Profile* profile) {
+    TNM067_PROFILE_SCOPE(profile, "Half-edges and quadrics");
+    const auto halfEdges = static_cast<std::uint32_t>(origin_.size());
+
+    // Match half-edges by sorting them on their undirected edge
+    struct Key {
+        std::uint32_t lo;
+        std::uint32_t hi;
+        std::uint32_t h;
+    };
+    std::vector<Key> keys;
+    keys.reserve(halfEdges);
+    for (std::uint32_t t = 0; t < removed_.size(); ++t) {
+        const auto v0 = origin_[3 * t];
+        const auto v1 = origin_[3 * t + 1];
+        const auto v2 = origin_[3 * t + 2];
+        if (v0 == v1 || v1 == v2 || v2 == v0) {
+            removed_[t] = true;
+            --liveTriangles_;
+            continue;
+        }
+        for (std::uint32_t h = 3 * t; h < 3 * t + 3; ++h) {
+            keys.push_back({std::min(origin_[h], dest(h)), std::max(origin_[h], dest(h)), h});
+        }
+    }
+    std::sort(keys.begin(), keys.end(), [](const Key& x, const Key& y) {
+        return std::tie(x.lo, x.hi, x.h) < std::tie(y.lo, y.hi, y.h);
+    });
+    for (size_t i = 0; i < keys.size();) {
+        size_t j = i + 1;
+        while (j < keys.size() && keys[j].lo == keys[i].lo && keys[j].hi == keys[i].hi) ++j;
+        if (j - i == 2 && origin_[keys[i].h] != origin_[keys[i + 1].h]) {
+            twin_[keys[i].h] = keys[i + 1].h;
+            twin_[keys[i + 1].h] = keys[i].h;
+        } else if (j - i >= 2) {
+            // Non-manifold or inconsistently oriented edge, keep its vertices as they are
+            locked_[keys[i].lo] = true;
+            locked_[keys[i].hi] = true;
+        }
+        i = j;
+    }
+
+    std::vector<std::uint32_t> outgoing(positions_.size(), 0);
+    for (std::uint32_t h = 0; h < halfEdges; ++h) {
+        if (removed_[h / 3]) continue;
+        const auto v = origin_[h];
+        ++outgoing[v];
+        // Prefer a half-edge on the boundary so the fan walk starts at one of its ends
+        if (vertexEdge_[v] == invalid || twin_[prev(h)] == invalid) vertexEdge_[v] = h;
+    }
+
+    // Vertices where several fans meet can not be handled by the half-edge walk
+    for (std::uint32_t v = 0; v < positions_.size(); ++v) {
+        std::uint32_t count = 0;
+        forEachOutgoing(v, [&](std::uint32_t) { ++count; });
+        if (count != outgoing[v]) locked_[v] = true;
+    }
+
+    for (std::uint32_t t = 0; t < removed_.size(); ++t) {
+        if (removed_[t]) continue;
+        const auto& p0 = positions_[origin_[3 * t]];
+        const auto& p1 = positions_[origin_[3 * t + 1]];
+        const auto& p2 = positions_[origin_[3 * t + 2]];
+        const dvec3 cross = glm::cross(p1 - p0, p2 - p0);
+        const double length = glm::length(cross);
+        if (length == 0.0) continue;
+        const dvec3 n = cross / length;
+        const auto q = Quadric::plane(n, -glm::dot(n, p0));
+        for (std::uint32_t k = 0; k < 3; ++k) {
+            const auto h = 3 * t + k;
+            quadrics_[origin_[h]] += q;
+            if (twin_[h] != invalid) continue;
+
+            // Boundary edge, add a heavily weighted plane through the edge perpendicular to the
+            // triangle to keep the boundary in place
+            const auto& a = positions_[origin_[h]];
+            const auto& b = positions_[dest(h)];
+            const dvec3 along = b - a;
+            const dvec3 perpendicular = glm::cross(along, n);
+            const double perpendicularLength = glm::length(perpendicular);
+            if (perpendicularLength == 0.0) continue;
+            const dvec3 m = perpendicular / perpendicularLength;
+            const auto boundary = Quadric::plane(m, -glm::dot(m, a), 100.0);
+            quadrics_[origin_[h]] += boundary;
+            quadrics_[dest(h)] += boundary;
+        }
+    }
+}
+
+Decimator::Candidate Decimator::evaluate(std::uint32_t h) const {
+    const auto a = origin_[h];
+    const auto b = dest(h);
+    const Quadric q = quadrics_[a] + quadrics_[b];
+
+    Candidate c{0.0, positions_[b], h, a, b, version_[a], version_[b]};
+    dvec3 optimal;
+    if (q.minimize(optimal)) {
+        c.pos = optimal;
+        c.cost = q.error(optimal);
+    } else {
+        c.cost = q.error(c.pos);
+        for (const auto& p : {positions_[a], 0.5 * (positions_[a] + positions_[b])}) {
+            const double e = q.error(p);
+            if (e < c.cost) {
+                c.cost = e;
+                c.pos = p;
+            }
+        }
+    }
+    return c;
+}
+
+bool Decimator::canCollapse(const Candidate& c) const {
+    if (locked_[c.a] || locked_[c.b]) return false;
+
+    const auto h = c.edge;
+    const auto t0 = h / 3;
+    const auto t1 = twin_[h] == invalid ? invalid : twin_[h] / 3;
+
+    // Two boundary vertices connected through the interior would pinch the mesh
+    if (t1 != invalid && isBoundary(c.a) && isBoundary(c.b)) return false;
+
+    // Link condition: the only vertices adjacent to both a and b are the opposite vertices of the
+    // triangles sharing the edge
+    std::vector<std::uint32_t> ringA;
+    forEachOutgoing(c.a, [&](std::uint32_t e) {
+        ringA.push_back(dest(e));
+        ringA.push_back(origin_[prev(e)]);
+    });
+    std::sort(ringA.begin(), ringA.end());
+    size_t shared = 0;
+    std::vector<std::uint32_t> ringB;
+    forEachOutgoing(c.b, [&](std::uint32_t e) {
+        ringB.push_back(dest(e));
+        ringB.push_back(origin_[prev(e)]);
+    });
+    std::sort(ringB.begin(), ringB.end());
+    ringB.erase(std::unique(ringB.begin(), ringB.end()), ringB.end());
+    for (const auto v : ringB) {
+        if (v != c.a && std::binary_search(ringA.begin(), ringA.end(), v)) ++shared;
+    }
+    if (shared != (t1 == invalid ? 1u : 2u)) return false;
+
+    // The triangles that remain around a and b must not flip
+    bool flips = false;
+    auto check = [&](std::uint32_t v) {
+        forEachOutgoing(v, [&](std::uint32_t e) {
+            const auto t = e / 3;
+            if (t == t0 || t == t1) return;
+            const auto& p0 = positions_[origin_[e]];
+            const auto& p1 = positions_[dest(e)];
+            const auto& p2 = positions_[origin_[prev(e)]];
+            const dvec3 before = glm::cross(p1 - p0, p2 - p0);
+            const dvec3 after = glm::cross(p1 - c.pos, p2 - c.pos);
+            if (glm::dot(before, after) <= 0.0) flips = true;
+        });
+    };
+    check(c.a);
+    check(c.b);
+    return !flips;
+}
+
+void Decimator::apply(const Candidate& c) {
+    const auto h = c.edge;
+    const auto a = c.a;
+    const auto b = c.b;
+
+    // Half-edges leaving a now leave b
+    std::vector<std::uint32_t> fan;
+    forEachOutgoing(a, [&](std::uint32_t e) { fan.push_back(e); });
+    forEachOutgoing(b, [&](std::uint32_t e) { fan.push_back(e); });
+    for (const auto e : fan) {
+        if (origin_[e] == a) origin_[e] = b;
+    }
+
+    // Remove the triangles of the edge and connect the neighbors across them
+    auto removeTriangle = [&](std::uint32_t e) {
+        const auto n = next(e);
+        const auto p = prev(e);
+        const auto x = twin_[n];
+        const auto y = twin_[p];
+        if (x != invalid) twin_[x] = y;
+        if (y != invalid) twin_[y] = x;
+
+        const auto opposite = origin_[p];
+        if (vertexEdge_[opposite] / 3 == e / 3) {
+            vertexEdge_[opposite] = x != invalid ? x : (y != invalid ? next(y) : invalid);
+        }
+        removed_[e / 3] = true;
+        --liveTriangles_;
+    };
+    const auto twin = twin_[h];
+    removeTriangle(h);
+    if (twin != invalid) removeTriangle(twin);
+
+    vertexEdge_[a] = invalid;
+    vertexEdge_[b] = invalid;
+    for (const auto e : fan) {
+        if (removed_[e / 3]) continue;
+        // Prefer a boundary half-edge, see build()
+        if (vertexEdge_[b] == invalid || twin_[prev(e)] == invalid) vertexEdge_[b] = e;
+    }
+
+    const dvec3 ab = positions_[b] - positions_[a];
+    const double length2 = glm::dot(ab, ab);
+    const double s =
+        length2 > 0.0 ? glm::clamp(glm::dot(c.pos - positions_[a], ab) / length2, 0.0, 1.0) : 1.0;
+    if (onCollapse) onCollapse(a, b, s);
+
+    positions_[b] = c.pos;
+    quadrics_[b] += quadrics_[a];
+    ++version_[a];
+    ++version_[b];
+}
+
+void Decimator::pushCandidates(std::uint32_t v) {
+    forEachOutgoing(v, [&](std::uint32_t e) {
+        heap_.push(evaluate(e));
+        heap_.push(evaluate(prev(e)));
+    });
+}
+
+void Decimator::collapse(size_t targetTriangles, double maxError, DecimationStats& stats,
+                         Profile* profile) {
+    {
+        TNM067_PROFILE_SCOPE(profile, "Initial candidates");
+        // One candidate per edge, evaluated in parallel
+        std::vector<std::uint32_t> edges;
+        for (std::uint32_t h = 0; h < origin_.size(); ++h) {
+            if (!removed_[h / 3] && (twin_[h] == invalid || h < twin_[h])) edges.push_back(h);
+        }
+        std::vector<Candidate> candidates(edges.size());
+        forEachRangeParallel(edges.size(), [&](size_t begin, size_t end, size_t) {
+            for (size_t i = begin; i < end; ++i) candidates[i] = evaluate(edges[i]);
+        });
+        heap_ = std::priority_queue<Candidate>(std::less<Candidate>(), std::move(candidates));
+    }
+
+    TNM067_PROFILE_SCOPE(profile, "Collapses");
+    const double maxCost = maxError * maxError;
+    while (liveTriangles_ > targetTriangles && !heap_.empty()) {
+        const Candidate c = heap_.top();
+        if (c.cost > maxCost) break;
+        heap_.pop();
+
+        // Skip candidates that were invalidated by earlier collapses
+        if (removed_[c.edge / 3] || origin_[c.edge] != c.a || dest(c.edge) != c.b ||
+            version_[c.a] != c.versionA || version_[c.b] != c.versionB) {
+            continue;
+        }
+        if (!canCollapse(c)) continue;
+
+        apply(c);
+        pushCandidates(c.b);
+        ++stats.collapses;
+        stats.maxError = std::max(stats.maxError, std::sqrt(c.cost));
+    }
+}
+
+}  // namespace
+
+std::shared_ptr<BasicMesh> decimate(const Mesh& mesh, size_t targetTriangles, double maxError,
+                                    DecimationStats* stats, Profile* profile) {
+    TNM067_PROFILE_SCOPE(profile, "Decimate");
+
+    std::vector<dvec3> positions;
+    std::vector<vec3> normals;
+    std::vector<vec4> colors;
+    if (auto buffer = mesh.findBuffer(BufferType::PositionAttrib).first) {
+        const auto ram = buffer->getRepresentation<BufferRAM>();
+        positions.reserve(ram->getSize());
+        for (size_t i = 0; i < ram->getSize(); ++i) positions.push_back(ram->getAsDVec3(i));
+    }
+    if (auto buffer = mesh.findBuffer(BufferType::NormalAttrib).first) {
+        const auto ram = buffer->getRepresentation<BufferRAM>();
+        normals.reserve(ram->getSize());
+        for (size_t i = 0; i < ram->getSize(); ++i) normals.push_back(vec3(ram->getAsDVec3(i)));
+    }
+    if (auto buffer = mesh.findBuffer(BufferType::ColorAttrib).first) {
+        const auto ram = buffer->getRepresentation<BufferRAM>();
+        colors.reserve(ram->getSize());
+        for (size_t i = 0; i < ram->getSize(); ++i) colors.push_back(vec4(ram->getAsDVec4(i)));
+    }
+    normals.resize(positions.size(), vec3(0.0f));
+    colors.resize(positions.size(), vec4(0.7f, 0.7f, 0.7f, 1.0f));
+
+    // Triangles with a vertex outside the position buffer are dropped whole
+    auto triangles = collectTriangles(mesh);
+    size_t kept = 0;
+    for (size_t t = 0; t + 2 < triangles.size(); t += 3) {
+        if (triangles[t] >= positions.size() || triangles[t + 1] >= positions.size() ||
+            triangles[t + 2] >= positions.size()) {
+            continue;
+        }
+        for (size_t k = 0; k < 3; ++k) triangles[kept++] = triangles[t + k];
+    }
+    triangles.resize(kept);
+
+    DecimationStats localStats;
+    if (!stats) stats = &localStats;
+    *stats = DecimationStats{};
+    stats->inputTriangles = triangles.size() / 3;
+
+    Decimator decimator(std::move(positions), std::move(triangles));
+    decimator.onCollapse = [&](std::uint32_t a, std::uint32_t b, double s) {
+        const auto t = static_cast<float>(s);
+        const vec3 n = glm::mix(normals[a], normals[b], t);
+        const float length = glm::length(n);
+        normals[b] = length > 0.0f ? n / length : normals[b];
+        colors[b] = glm::mix(colors[a], colors[b], t);
+    };
+    decimator.build(profile);
+    stats->lockedVertices = decimator.lockedVertices();
+    decimator.collapse(targetTriangles, maxError, *stats, profile);
+
+    TNM067_PROFILE_SCOPE(profile, "Compact");
+    auto result = std::make_shared<BasicMesh>();
+    result->setModelMatrix(mesh.getModelMatrix());
+    result->setWorldMatrix(mesh.getWorldMatrix());
+    auto indices = result->addIndexBuffer(DrawType::Triangles, ConnectivityType::None);
+
+    std::vector<std::uint32_t> remap(normals.size(), invalid);
+    std::vector<BasicMesh::Vertex> vertices;
+    const size_t triangleCount = stats->inputTriangles;
+    for (std::uint32_t t = 0; t < triangleCount; ++t) {
+        if (decimator.isRemoved(t)) continue;
+        for (std::uint32_t k = 0; k < 3; ++k) {
+            const auto v = decimator.origin(3 * t + k);
+            if (remap[v] == invalid) {
+                remap[v] = static_cast<std::uint32_t>(vertices.size());
+                const vec3 p(decimator.position(v));
+                vertices.push_back({p, normals[v], p, colors[v]});
+            }
+            indices->add(remap[v]);
+        }
+    }
+    result->addVertices(vertices);
+    stats->outputTriangles = decimator.liveTriangles();
+
+    return result;
+}
+
+}  // namespace TNM067
+
+}  // namespace inviwo
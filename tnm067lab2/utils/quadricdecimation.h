@@ -0,0 +1,68 @@
+#pragma once
+
+#include <modules/tnm067lab2/tnm067lab2moduledefine.h>
+#include <modules/tnm067lab1/utils/instrumentation.h>
+#include <inviwo/core/datastructures/geometry/basicmesh.h>
+
+#include <array>
+#include <limits>
+
+namespace inviwo {
+
+namespace TNM067 {
+
+/**
+ * \class Quadric
+ * \brief Sum of squared distances to a set of planes, as a symmetric 4x4 matrix.
+ */
+class IVW_MODULE_TNM067LAB2_API Quadric {
+public:
+    Quadric() = default;
+
+    /// Quadric of the plane dot(n, x) + d = 0 scaled by weight, n must be normalized
+    static Quadric plane(const dvec3& n, double d, double weight = 1.0);
+
+    Quadric& operator+=(const Quadric& rhs);
+    Quadric operator+(const Quadric& rhs) const;
+
+    /// Sum of the weighted squared distances from p to the planes
+    double error(const dvec3& p) const;
+
+    /// Sets p to the point with minimal error, returns false if it is not unique
+    bool minimize(dvec3& p) const;
+
+private:
+    // Upper triangle of the matrix: aa ab ac ad bb bc bd cc cd dd
+    std::array<double, 10> m_{};
+};
+
+struct DecimationStats {
+    size_t inputTriangles = 0;
+    size_t outputTriangles = 0;
+    size_t collapses = 0;
+    double maxError = 0.0;  //!< Largest error, as a distance, of the collapses performed
+    /// Vertices on non-manifold or inconsistently oriented edges, which are never collapsed
+    size_t lockedVertices = 0;
+};
+
+/**
+ * Simplifies the triangles of mesh with quadric error metric edge collapses (Garland and Heckbert).
+ * Edges are collapsed in order of increasing error until the mesh has at most targetTriangles
+ * triangles or the next collapse would have an error larger than maxError. The error is the square
+ * root of the quadric error, i.e. roughly the distance to the planes of the original triangles, in
+ * model space.
+ *
+ * The mesh is stored as flat half-edge arrays and the candidate collapses in a heap that is updated
+ * lazily: collapses invalidate the candidates of the affected vertices by bumping their version and
+ * outdated entries are skipped when popped. Collapses that would change the topology or flip a
+ * triangle are rejected, and boundary edges are preserved by additional perpendicular planes.
+ * Normals and colors are interpolated along the collapsed edges.
+ */
+IVW_MODULE_TNM067LAB2_API std::shared_ptr<BasicMesh> decimate(
+    const Mesh& mesh, size_t targetTriangles,
+    double maxError = std::numeric_limits<double>::infinity(), DecimationStats* stats = nullptr,
+    Profile* profile = nullptr);
+
+}  // namespace TNM067
+
+}  // namespace inviwo
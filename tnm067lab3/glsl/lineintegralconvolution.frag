@@ -29,12 +29,8 @@ void traverse(vec2 posF, float stepSize, int nSteps, inout float accVal, inout i
         // Calculate new position based on euler
         position = position + (nVector * stepSize);
         
-        // Sample the color (rgb) information from noise layer (noiseColor) and
-        vec3 noise = texture(noiseColor, position).rgb;
-        
-        // Calculate the gray value from rgb
-        float grayValue = (noise.r + noise.g + noise.b)/3;
-        accVal += grayValue;
+        // Sample the noise layer (noiseColor), the noise is single channel so red holds the gray value
+        accVal += texture(noiseColor, position).r;
     }
 }
 
@@ -0,0 +1,415 @@
+#include <modules/tnm067lab3/processors/evenlyspacedstreamlines.h>
+#include <modules/tnm067lab1/utils/interpolationmethods.h>
+#include <modules/tnm067lab1/utils/parallelutils.h>
+#include <modules/tnm067lab1/utils/flathashmap.h>
+#include <inviwo/core/datastructures/image/layerramprecision.h>
+#include <inviwo/core/util/formatdispatching.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace inviwo {
+
+const ProcessorInfo EvenlySpacedStreamlines::processorInfo_{
+    "org.inviwo.EvenlySpacedStreamlines",  // Class identifier
+    "Evenly Spaced Streamlines",           // Display name
+    "TNM067",                              // Category
+    CodeState::Experimental,               // Code state
+    Tags::CPU,                             // Tags
+};
+const ProcessorInfo EvenlySpacedStreamlines::getProcessorInfo() const { return processorInfo_; }
+
+EvenlySpacedStreamlines::EvenlySpacedStreamlines()
+    : Processor()
+    , field_("field", true)
+    , mesh_("mesh")
+    , separation_("separation", "Separation (pixels)", 8.0f, 1.0f, 128.0f, 0.5f)
+    , testRatio_("testRatio", "Test Distance Ratio", 0.5f, 0.1f, 1.0f, 0.05f)
+    , stepSize_("stepSize", "Step Size (pixels)", 1.0f, 0.1f, 10.0f, 0.1f)
+    , maxSteps_("maxSteps", "Max Steps", 2000, 10, 100000)
+    , minLength_("minLength", "Min Length (pixels)", 16.0f, 0.0f, 1024.0f, 1.0f)
+    , color_("color", "Color", util::ordinalColor(0.0f, 0.0f, 0.0f, 1.0f))
+    , profiling_("profiling", "Profiling") {
+
+    addPort(field_);
+    addPort(mesh_);
+
+    addProperty(separation_);
+    addProperty(testRatio_);
+    addProperty(stepSize_);
+    addProperty(maxSteps_);
+    addProperty(minLength_);
+    addProperty(color_);
+    addProperty(profiling_);
+}
+
+namespace {
+
+constexpr auto none = std::numeric_limits<std::uint32_t>::max();
+
+/**
+ * Points binned in square cells of the separating distance, so the points closer than that to a
+ * position are in at most 2x2 cells. The cells cover the field with the pixel centers at integer
+ * coordinates.
+ */
+class PointGrid {
+public:
+    PointGrid(size2_t fieldDims, float cellSize)
+        : invCellSize_(1.0f / cellSize)
+        , dims_(glm::max(size2_t(glm::ceil(vec2(fieldDims) * invCellSize_)), size2_t(1)))
+        , cells_(dims_.x * dims_.y) {}
+
+    ivec2 cell(vec2 p) const {
+        return glm::clamp(ivec2(glm::floor((p + 0.5f) * invCellSize_)), ivec2(0),
+                          ivec2(dims_) - ivec2(1));
+    }
+    std::uint32_t index(ivec2 cell) const {
+        return static_cast<std::uint32_t>(cell.x + cell.y * dims_.x);
+    }
+
+    /**
+     * Calls callback(cellIndex) for the cells within distance of p, stopping when it returns
+     * false
+     */
+    template <typename Callback>
+    bool forNeighbors(vec2 p, float distance, Callback callback) const {
+        const ivec2 first = cell(p - distance);
+        const ivec2 last = cell(p + distance);
+        for (int y = first.y; y <= last.y; ++y) {
+            for (int x = first.x; x <= last.x; ++x) {
+                if (!callback(index({x, y}))) return false;
+            }
+        }
+        return true;
+    }
+
+    void add(vec2 p) { cells_[index(cell(p))].push_back(p); }
+
+    /// True if no point is closer than distance to p, distance is at most the cell size
+    bool isClear(vec2 p, float distance) const {
+        const float d2 = distance * distance;
+        return forNeighbors(p, distance, [&](std::uint32_t c) {
+            for (const auto& q : cells_[c]) {
+                const vec2 d = q - p;
+                if (glm::dot(d, d) < d2) return false;
+            }
+            return true;
+        });
+    }
+
+private:
+    float invCellSize_;
+    size2_t dims_;
+    std::vector<std::vector<vec2>> cells_;
+};
+
+/**
+ * Points of the line being integrated, binned like a PointGrid but only in the cells the line
+ * has visited. Each cell holds a linked list of its points, starting with the latest.
+ */
+struct OwnPoints {
+    void clear() {
+        heads.clear();
+        points.clear();
+        steps.clear();
+        next.clear();
+    }
+
+    void add(const PointGrid& grid, vec2 p, int step) {
+        const auto id = static_cast<std::uint32_t>(points.size());
+        auto head = heads.tryEmplace(grid.index(grid.cell(p)), id);
+        next.push_back(head.second ? none : head.first);
+        head.first = id;
+        points.push_back(p);
+        steps.push_back(step);
+    }
+
+    /**
+     * True if no point more than minGap steps away along the line is closer than distance to p,
+     * the points closer along the line are always near.
+     */
+    bool isClear(const PointGrid& grid, vec2 p, int step, float distance, int minGap) const {
+        const float d2 = distance * distance;
+        return grid.forNeighbors(p, distance, [&](std::uint32_t c) {
+            const auto head = heads.get(c);
+            for (auto i = head ? *head : none; i != none; i = next[i]) {
+                const vec2 d = points[i] - p;
+                if (std::abs(steps[i] - step) > minGap && glm::dot(d, d) < d2) return false;
+            }
+            return true;
+        });
+    }
+
+    TNM067::FlatHashMap<std::uint32_t, std::uint32_t> heads;
+    std::vector<vec2> points;
+    std::vector<int> steps;  //!< Signed step from the seed, negative backwards
+    std::vector<std::uint32_t> next;
+};
+
+struct Candidate {
+    vec2 seed;
+    std::uint32_t source;  //!< Line the seed is beside, none for seeds on the fallback grid
+    int side;
+};
+
+float lineLength(const std::vector<vec2>& line) {
+    float length = 0.0f;
+    for (size_t i = 1; i < line.size(); ++i) length += glm::distance(line[i - 1], line[i]);
+    return length;
+}
+
+}  // namespace
+
+std::vector<std::vector<vec2>> EvenlySpacedStreamlines::place(const LayerRAM& field,
+                                                              float separation, float testRatio,
+                                                              float stepSize, size_t maxSteps,
+                                                              float minLength,
+                                                              TNM067::Profile* profile) {
+    TNM067_PROFILE_SCOPE(profile, "Place streamlines");
+    const size2_t dims = field.getDimensions();
+    std::vector<std::vector<vec2>> lines;
+    if (dims.x < 2 || dims.y < 2 || separation <= 0.0f) return lines;
+
+    std::vector<vec2> vectors(dims.x * dims.y);
+    {
+        TNM067_PROFILE_SCOPE(profile, "Read field");
+        const bool twoChannels = field.getDataFormat()->getComponents() > 1;
+        field.dispatch<void>([&](const auto rep) {
+            const auto data = rep->getDataTyped();
+            TNM067::forEachRangeParallel(vectors.size(), [&](size_t begin, size_t end, size_t) {
+                for (size_t i = begin; i < end; ++i) {
+                    vectors[i] = vec2(static_cast<float>(util::glmcomp(data[i], 0)),
+                                      twoChannels ? static_cast<float>(util::glmcomp(data[i], 1))
+                                                  : 0.0f);
+                }
+            });
+        });
+        TNM067_PROFILE_COUNT(profile, PixelsProcessed, dims.x * dims.y);
+    }
+
+    const float testDistance = testRatio * separation;
+    // Longer steps could pass lines without a point within the test distance of them
+    const float step = glm::clamp(stepSize, 1e-3f, testDistance);
+    // Points this many steps apart along a line can be close without the line closing on itself
+    const int minGap = static_cast<int>(std::ceil(3.0f * separation / step));
+    // Seeds are at the separating distance of their line, which rounding can bring just below it
+    const float seedDistance = 0.99f * separation;
+    // Candidates are taken about every quarter separating distance along the lines
+    const size_t candidateStride =
+        std::max<size_t>(1, static_cast<size_t>(0.25f * separation / step));
+
+    const vec2 lo(-0.5f);
+    const vec2 hi = vec2(dims) - 0.5f;
+    auto inside = [&](vec2 p) { return glm::all(glm::greaterThanEqual(p, lo)) &&
+                                       glm::all(glm::lessThanEqual(p, hi)); };
+
+    // Normalized direction at p, false outside the field or at a critical point
+    auto direction = [&](vec2 p, vec2& dir) {
+        if (!inside(p)) return false;
+        const vec2 c = glm::clamp(p, vec2(0.0f), vec2(dims - size2_t(1)));
+        const ivec2 i0 = glm::min(ivec2(c), ivec2(dims) - ivec2(2));
+        const vec2 t = c - vec2(i0);
+        auto at = [&](int x, int y) { return vectors[x + y * dims.x]; };
+        const vec2 v = TNM067::Interpolation::bilinear<vec2, float>(
+            {at(i0.x, i0.y), at(i0.x + 1, i0.y), at(i0.x, i0.y + 1), at(i0.x + 1, i0.y + 1)}, t.x,
+            t.y);
+        const float length = glm::length(v);
+        if (!(length > 1e-6f)) return false;
+        dir = v / length;
+        return true;
+    };
+    auto rk4 = [&](vec2 p, float h, vec2& next) {
+        vec2 k1, k2, k3, k4;
+        if (!direction(p, k1) || !direction(p + 0.5f * h * k1, k2) ||
+            !direction(p + 0.5f * h * k2, k3) || !direction(p + h * k3, k4)) {
+            return false;
+        }
+        next = p + h / 6.0f * (k1 + 2.0f * k2 + 2.0f * k3 + k4);
+        return inside(next);
+    };
+
+    PointGrid grid(dims, separation);
+    auto validSeed = [&](vec2 seed) { return inside(seed) && grid.isClear(seed, seedDistance); };
+
+    // Integrates forwards and backwards from seed until the line comes within the test distance
+    // of the lines in grid or itself
+    auto integrate = [&](vec2 seed, OwnPoints& own, std::vector<vec2>& result) {
+        own.clear();
+        own.add(grid, seed, 0);
+        std::array<std::vector<vec2>, 2> halves;
+        for (int direction : {1, -1}) {
+            auto& half = halves[direction > 0 ? 0 : 1];
+            vec2 p = seed;
+            for (int i = 1; i <= static_cast<int>(maxSteps); ++i) {
+                vec2 next;
+                if (!rk4(p, direction * step, next)) break;
+                if (!grid.isClear(next, testDistance)) break;
+                if (!own.isClear(grid, next, direction * i, testDistance, minGap)) break;
+                own.add(grid, next, direction * i);
+                half.push_back(next);
+                p = next;
+            }
+        }
+        result.assign(halves[1].rbegin(), halves[1].rend());
+        result.push_back(seed);
+        result.insert(result.end(), halves[0].begin(), halves[0].end());
+    };
+
+    // Seeds beside line at its point k, on the left for side 0
+    auto candidate = [&](std::uint32_t line, size_t k, int side) {
+        const auto& points = lines[line];
+        const vec2 tangent = points[std::min(k + 1, points.size() - 1)] - points[k > 0 ? k - 1 : 0];
+        const float length = glm::length(tangent);
+        if (!(length > 0.0f)) return vec2(std::numeric_limits<float>::quiet_NaN());
+        const vec2 normal = vec2(-tangent.y, tangent.x) / length;
+        return points[k] + (side == 0 ? separation : -separation) * normal;
+    };
+
+    // Lines that still have candidates, their next candidate on each side
+    std::vector<std::array<size_t, 2>> cursors;
+    std::vector<std::uint32_t> window;
+    size_t nextSource = 0;
+    // Fallback seeds on a regular grid for regions no line reaches
+    const size2_t fallbackDims = glm::max(size2_t(vec2(dims) / separation), size2_t(1));
+    const size_t fallbackCount = glm::compMul(fallbackDims);
+    size_t fallback = 0;
+    auto fallbackSeed = [&](size_t i) {
+        return (vec2(i % fallbackDims.x, i / fallbackDims.x) + 0.5f) * vec2(dims) /
+                   vec2(fallbackDims) -
+               0.5f;
+    };
+
+    const size_t jobs = TNM067::defaultJobCount();
+    std::vector<OwnPoints> own(jobs);
+    std::vector<Candidate> wave;
+    std::vector<std::vector<vec2>> integrated(waveSize);
+    std::vector<std::array<bool, 2>> found;
+    std::atomic<size_t> seedsTested{0};
+
+    while (true) {
+        {
+            TNM067_PROFILE_SCOPE(profile, "Find seeds");
+            while (window.size() < waveSize / 2 && nextSource < lines.size()) {
+                window.push_back(static_cast<std::uint32_t>(nextSource++));
+            }
+            // Every line in the window moves to its next valid candidate on both sides
+            found.assign(window.size(), {false, false});
+            TNM067::forEachRangeParallel(window.size(), [&](size_t begin, size_t end, size_t) {
+                size_t tested = 0;
+                for (size_t w = begin; w < end; ++w) {
+                    const auto line = window[w];
+                    for (int side = 0; side < 2; ++side) {
+                        auto& cursor = cursors[line][side];
+                        for (; cursor < lines[line].size(); cursor += candidateStride) {
+                            ++tested;
+                            if (validSeed(candidate(line, cursor, side))) {
+                                found[w][side] = true;
+                                break;
+                            }
+                        }
+                    }
+                }
+                seedsTested += tested;
+            });
+
+            wave.clear();
+            size_t kept = 0;
+            for (size_t w = 0; w < window.size(); ++w) {
+                const auto line = window[w];
+                for (int side = 0; side < 2; ++side) {
+                    if (found[w][side]) {
+                        wave.push_back({candidate(line, cursors[line][side], side), line, side});
+                    }
+                }
+                if (found[w][0] || found[w][1]) window[kept++] = line;
+            }
+            window.resize(kept);
+
+            if (wave.empty()) {
+                if (nextSource < lines.size()) continue;
+                while (fallback < fallbackCount && !validSeed(fallbackSeed(fallback))) {
+                    ++fallback;
+                    ++seedsTested;
+                }
+                if (fallback == fallbackCount) break;
+                wave.push_back({fallbackSeed(fallback++), none, 0});
+            }
+        }
+
+        {
+            TNM067_PROFILE_SCOPE(profile, "Integrate");
+            TNM067::forEachRangeParallel(
+                wave.size(),
+                [&](size_t begin, size_t end, size_t job) {
+                    for (size_t i = begin; i < end; ++i) {
+                        integrate(wave[i].seed, own[job], integrated[i]);
+                    }
+                },
+                jobs);
+        }
+
+        TNM067_PROFILE_SCOPE(profile, "Accept");
+        // The lines were integrated against the grid before the wave, so they only need checking
+        // once a line of the wave has been accepted
+        bool accepted = false;
+        for (size_t i = 0; i < wave.size(); ++i) {
+            const auto& c = wave[i];
+            if (c.source != none) cursors[c.source][c.side] += candidateStride;
+            if (accepted && !grid.isClear(c.seed, seedDistance)) continue;
+
+            // A line that comes too close to a line accepted earlier in the wave is integrated
+            // again, since cutting it could leave one half stopped early against points of the
+            // other half that are cut away
+            auto& line = integrated[i];
+            if (accepted && !std::all_of(line.begin(), line.end(), [&](vec2 p) {
+                    return grid.isClear(p, testDistance);
+                })) {
+                integrate(c.seed, own.front(), line);
+            }
+            if (line.size() < 2 || lineLength(line) < minLength) continue;
+
+            for (const auto& p : line) grid.add(p);
+            lines.push_back(line);
+            cursors.push_back({0, 0});
+            accepted = true;
+        }
+    }
+
+    TNM067_PROFILE_COUNT(profile, SeedsTested, seedsTested);
+    TNM067_PROFILE_COUNT(profile, StreamlinesPlaced, lines.size());
+    return lines;
+}
+
+std::shared_ptr<EvenlySpacedStreamlines::LineMesh> EvenlySpacedStreamlines::toMesh(
+    const std::vector<std::vector<vec2>>& lines, size2_t dims, vec4 color) {
+    auto mesh = std::make_shared<LineMesh>();
+    auto& indices =
+        mesh->addIndexBuffer(DrawType::Lines, ConnectivityType::Strip)->getDataContainer();
+    std::vector<LineMesh::Vertex> vertices;
+    constexpr auto restart = std::numeric_limits<std::uint32_t>::max();
+    const vec2 toUnit = 1.0f / vec2(dims);
+    for (const auto& line : lines) {
+        if (!indices.empty()) indices.push_back(restart);
+        for (const auto& p : line) {
+            indices.push_back(static_cast<std::uint32_t>(vertices.size()));
+            vertices.emplace_back(vec3((p + 0.5f) * toUnit, 0.0f), color);
+        }
+    }
+    mesh->addVertices(vertices);
+    return mesh;
+}
+
+void EvenlySpacedStreamlines::process() {
+    auto profile = profiling_.begin();
+    const auto layer = field_.getData()->getColorLayer()->getRepresentation<LayerRAM>();
+    const auto lines = place(*layer, separation_.get(), testRatio_.get(), stepSize_.get(),
+                             maxSteps_.get(), minLength_.get(), profile);
+    mesh_.setData(toMesh(lines, layer->getDimensions(), color_.get()));
+    profiling_.end();
+}
+
+}  // namespace inviwo
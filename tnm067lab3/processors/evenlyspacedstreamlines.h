@@ -0,0 +1,87 @@
+#pragma once
+
+#include <modules/tnm067lab3/tnm067lab3moduledefine.h>
+#include <inviwo/core/processors/processor.h>
+#include <inviwo/core/properties/ordinalproperty.h>
+#include <inviwo/core/ports/imageport.h>
+#include <inviwo/core/ports/meshport.h>
+#include <inviwo/core/datastructures/geometry/typedmesh.h>
+#include <modules/tnm067lab1/properties/profilingproperty.h>
+
+#include <vector>
+
+namespace inviwo {
+
+/**
+ * \class EvenlySpacedStreamlines
+ * \brief Places streamlines of the vector field in the first two channels of an image, evenly
+ * spaced with the algorithm of Jobard and Lefer.
+ * New lines are seeded at the separating distance beside the lines placed before them and are
+ * integrated until they come closer than the test distance to any line, including themselves.
+ * Distances are looked up in a uniform grid of the points placed so far. The output is one line
+ * strip per streamline, in the unit square like the texture coordinates the LIC shader samples
+ * the field with.
+ */
+class IVW_MODULE_TNM067LAB3_API EvenlySpacedStreamlines : public Processor {
+public:
+    using LineMesh = TypedMesh<buffertraits::PositionsBuffer, buffertraits::ColorsBuffer>;
+
+    /// Number of candidate seeds integrated together, independent of the thread count so the
+    /// result is too
+    static constexpr size_t waveSize = 64;
+
+    EvenlySpacedStreamlines();
+    virtual ~EvenlySpacedStreamlines() = default;
+
+    virtual void process() override;
+
+    virtual const ProcessorInfo getProcessorInfo() const override;
+    static const ProcessorInfo processorInfo_;
+
+    /**
+     * Places streamlines in field, in pixel coordinates with the pixel centers at integer
+     * coordinates. The field is interpolated with TNM067::Interpolation::bilinear and normalized,
+     * and integrated with fourth order Runge-Kutta. This is what process() runs, exposed to allow
+     * running it outside of a processor network.
+     *
+     * Candidate seeds are integrated in waves of up to waveSize lines in parallel against the
+     * lines placed before the wave. The lines of a wave are then accepted in order, and lines
+     * that come too close to a line accepted earlier in the wave are integrated again. Every line
+     * is thus integrated against all lines accepted before it, and the result does not depend on
+     * the thread count. Candidates that become invalid within a wave are skipped rather than
+     * replaced by the next candidate, so the result is close to but not the same as placing the
+     * lines strictly one at a time.
+     *
+     * @param field vector field in the first two channels
+     * @param separation distance between the lines in pixels
+     * @param testRatio lines stop at testRatio * separation from other lines
+     * @param stepSize integration step in pixels, at most the test distance
+     * @param maxSteps maximal number of steps in each direction from the seed
+     * @param minLength lines shorter than this, in pixels, are dropped
+     */
+    static std::vector<std::vector<vec2>> place(const LayerRAM& field, float separation,
+                                                float testRatio = 0.5f, float stepSize = 1.0f,
+                                                size_t maxSteps = 2000, float minLength = 16.0f,
+                                                TNM067::Profile* profile = nullptr);
+
+    /**
+     * Line strips of lines given in pixel coordinates of an image of size dims, moved to the unit
+     * square and separated by the restart index 0xFFFFFFFF
+     */
+    static std::shared_ptr<LineMesh> toMesh(const std::vector<std::vector<vec2>>& lines,
+                                            size2_t dims, vec4 color);
+
+private:
+    ImageInport field_;
+    MeshOutport mesh_;
+
+    FloatProperty separation_;
+    FloatProperty testRatio_;
+    FloatProperty stepSize_;
+    IntSizeTProperty maxSteps_;
+    FloatProperty minLength_;
+    FloatVec4Property color_;
+    ProfilingProperty profiling_;
+};
+
+}  // namespace inviwo
@@ -0,0 +1,288 @@
+#include <modules/tnm067lab3/processors/noisegenerator.h>
+#include <modules/tnm067lab1/utils/interpolationmethods.h>
+#include <modules/tnm067lab1/utils/parallelutils.h>
+#include <inviwo/core/datastructures/image/layerramprecision.h>
+
+#include <cmath>
+
+namespace inviwo {
+
+const ProcessorInfo NoiseGenerator::processorInfo_{
+    "org.inviwo.NoiseGenerator",  // Class identifier
+    "Noise Generator",            // Display name
+    "TNM067",                     // Category
+    CodeState::Experimental,      // Code state
+    Tags::CPU,                    // Tags
+};
+const ProcessorInfo NoiseGenerator::getProcessorInfo() const { return processorInfo_; }
+
+NoiseGenerator::NoiseGenerator()
+    : Processor()
+    , outport_("outport", true)
+    , size_("size", "Size", size2_t(512), size2_t(1), size2_t(8192))
+    , type_("type", "Noise Type",
+            {{"white", "White", NoiseType::White},
+             {"bandLimited", "Band-limited", NoiseType::BandLimited}})
+    , format_("format", "Format",
+              {{"float32", "Float32", OutputFormat::Float32},
+               {"uint8", "UInt8", OutputFormat::UInt8}})
+    , featureSize_("featureSize", "Feature Size (pixels)", 4, 2, 64)
+    , seed_("seed", "Seed", 1, 0, 1000000)
+    , mipLevels_("mipLevels", "Mip Levels", 1, 1, 14)
+    , matchOutputSize_("matchOutputSize", "Match Output Size", true)
+    , level_("level", "Level", 0, 0, 0)
+    , profiling_("profiling", "Profiling") {
+
+    addPort(outport_);
+
+    addProperty(size_);
+    addProperty(type_);
+    addProperty(format_);
+    addProperty(featureSize_);
+    addProperty(seed_);
+    addProperty(mipLevels_);
+    addProperty(matchOutputSize_);
+    addProperty(level_);
+    addProperty(profiling_);
+
+    auto visibility = [&]() {
+        featureSize_.setVisible(type_ == NoiseType::BandLimited);
+        level_.setVisible(!matchOutputSize_);
+    };
+    type_.onChange(visibility);
+    matchOutputSize_.onChange(visibility);
+    visibility();
+
+    mipLevels_.onChange([&]() { level_.setMaxValue(mipLevels_ - 1); });
+}
+
+namespace {
+
+// Integer hash with good avalanche behavior, see https://nullprogram.com/blog/2018/07/31/
+constexpr std::uint32_t hash(std::uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+// Maps the upper 24 bits of a hash to [0 1)
+constexpr float toUnitFloat(std::uint32_t h) {
+    return static_cast<float>(h >> 8) * (1.0f / 16777216.0f);
+}
+
+template <typename T>
+T toPixel(float v) {
+    if constexpr (std::is_same_v<T, float>) {
+        return v;
+    } else {
+        return static_cast<T>(glm::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+}
+
+template <typename T>
+float fromPixel(T v) {
+    if constexpr (std::is_same_v<T, float>) {
+        return v;
+    } else {
+        return static_cast<float>(v) * (1.0f / 255.0f);
+    }
+}
+
+std::uint32_t rowKey(size_t y, std::uint32_t seedKey) {
+    return hash(static_cast<std::uint32_t>(y) + seedKey);
+}
+
+// Rows are independent and the inner loop has no branches, which lets the compiler vectorize it
+template <typename T>
+void whiteNoise(T* data, size2_t dims, std::uint32_t seed) {
+    const std::uint32_t seedKey = hash(seed);
+    TNM067::forEachRangeParallel(dims.y, [&](size_t begin, size_t end, size_t) {
+        for (size_t y = begin; y < end; ++y) {
+            const std::uint32_t key = rowKey(y, seedKey);
+            T* row = data + y * dims.x;
+            for (size_t x = 0; x < dims.x; ++x) {
+                const std::uint32_t h = hash(static_cast<std::uint32_t>(x) ^ key);
+                if constexpr (std::is_same_v<T, float>) {
+                    row[x] = toUnitFloat(h);
+                } else {
+                    row[x] = static_cast<T>(h >> 24);
+                }
+            }
+        }
+    });
+}
+
+// Value noise: white noise on a lattice with featureSize spacing, bilinearly interpolated
+template <typename T>
+void bandLimitedNoise(T* data, size2_t dims, size_t featureSize, std::uint32_t seed) {
+    const std::uint32_t seedKey = hash(seed);
+    const float invFeature = 1.0f / static_cast<float>(featureSize);
+
+    auto lattice = [&](size_t x, size_t y) {
+        return toUnitFloat(hash(static_cast<std::uint32_t>(x) ^ rowKey(y, seedKey)));
+    };
+
+    TNM067::forEachRangeParallel(dims.y, [&](size_t begin, size_t end, size_t) {
+        for (size_t y = begin; y < end; ++y) {
+            const size_t ly = y / featureSize;
+            const float ty = static_cast<float>(y % featureSize) * invFeature;
+            T* row = data + y * dims.x;
+            for (size_t x = 0; x < dims.x; ++x) {
+                const size_t lx = x / featureSize;
+                const float tx = static_cast<float>(x % featureSize) * invFeature;
+                const std::array<float, 4> values = {lattice(lx, ly), lattice(lx + 1, ly),
+                                                     lattice(lx, ly + 1),
+                                                     lattice(lx + 1, ly + 1)};
+                row[x] = toPixel<T>(TNM067::Interpolation::bilinear(values, tx, ty));
+            }
+        }
+    });
+}
+
+template <typename T>
+dvec2 meanAndDeviation(const T* data, size_t size) {
+    const size_t jobs = TNM067::defaultJobCount();
+    std::vector<dvec2> sums(jobs, dvec2(0.0));
+    TNM067::forEachRangeParallel(
+        size,
+        [&](size_t begin, size_t end, size_t job) {
+            dvec2 sum(0.0);
+            for (size_t i = begin; i < end; ++i) {
+                const double v = fromPixel(data[i]);
+                sum += dvec2(v, v * v);
+            }
+            sums[job] = sum;
+        },
+        jobs);
+
+    dvec2 sum(0.0);
+    for (const auto& s : sums) sum += s;
+    const double mean = sum.x / static_cast<double>(size);
+    const double variance = sum.y / static_cast<double>(size) - mean * mean;
+    return {mean, std::sqrt(std::max(variance, 0.0))};
+}
+
+template <typename T>
+void downsample(const T* in, size2_t inDims, T* out, size2_t outDims, dvec2 target) {
+    TNM067::forEachRangeParallel(outDims.y, [&](size_t begin, size_t end, size_t) {
+        for (size_t y = begin; y < end; ++y) {
+            const T* row0 = in + std::min(2 * y, inDims.y - 1) * inDims.x;
+            const T* row1 = in + std::min(2 * y + 1, inDims.y - 1) * inDims.x;
+            for (size_t x = 0; x < outDims.x; ++x) {
+                const size_t x0 = std::min(2 * x, inDims.x - 1);
+                const size_t x1 = std::min(2 * x + 1, inDims.x - 1);
+                const float v = 0.25f * (fromPixel(row0[x0]) + fromPixel(row0[x1]) +
+                                         fromPixel(row1[x0]) + fromPixel(row1[x1]));
+                out[x + y * outDims.x] = toPixel<T>(v);
+            }
+        }
+    });
+
+    // Averaging lowers the contrast of the noise, scale it back to that of the base level
+    const size_t size = outDims.x * outDims.y;
+    const dvec2 stats = meanAndDeviation(out, size);
+    if (stats.y <= 0.0) return;
+    const float scale = static_cast<float>(target.y / stats.y);
+    const float mean = static_cast<float>(stats.x);
+    const float targetMean = static_cast<float>(target.x);
+    TNM067::forEachRangeParallel(size, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            out[i] = toPixel<T>((fromPixel(out[i]) - mean) * scale + targetMean);
+        }
+    });
+}
+
+template <typename T>
+T* typedData(Image& image) {
+    return static_cast<LayerRAMPrecision<T>*>(
+               image.getColorLayer()->getEditableRepresentation<LayerRAM>())
+        ->getDataTyped();
+}
+
+}  // namespace
+
+std::shared_ptr<Image> NoiseGenerator::generate(size2_t dims, NoiseType type, OutputFormat format,
+                                                size_t featureSize, std::uint32_t seed,
+                                                TNM067::Profile* profile) {
+    TNM067_PROFILE_SCOPE(profile, "Generate");
+    TNM067_PROFILE_COUNT(profile, PixelsProcessed, dims.x * dims.y);
+    auto create = [&](auto dataFormat, auto* tag) {
+        using T = std::remove_pointer_t<decltype(tag)>;
+        auto image = std::make_shared<Image>(dims, dataFormat);
+        image->getColorLayer()->setSwizzleMask(swizzlemasks::luminance);
+        T* data = typedData<T>(*image);
+        if (type == NoiseType::White) {
+            whiteNoise(data, dims, seed);
+        } else {
+            bandLimitedNoise(data, dims, std::max<size_t>(featureSize, 1), seed);
+        }
+        return image;
+    };
+
+    if (format == OutputFormat::Float32) {
+        return create(DataFloat32::get(), static_cast<float*>(nullptr));
+    } else {
+        return create(DataUInt8::get(), static_cast<std::uint8_t*>(nullptr));
+    }
+}
+
+std::vector<std::shared_ptr<Image>> NoiseGenerator::buildMipChain(std::shared_ptr<Image> base,
+                                                                  size_t levels,
+                                                                  TNM067::Profile* profile) {
+    TNM067_PROFILE_SCOPE(profile, "Mip chain");
+    std::vector<std::shared_ptr<Image>> chain{base};
+
+    auto build = [&](auto* tag) {
+        using T = std::remove_pointer_t<decltype(tag)>;
+        const size2_t baseDims = base->getDimensions();
+        const dvec2 target = meanAndDeviation(typedData<T>(*base), baseDims.x * baseDims.y);
+
+        while (chain.size() < levels) {
+            const auto& prev = chain.back();
+            const size2_t inDims = prev->getDimensions();
+            if (inDims.x == 1 && inDims.y == 1) break;
+
+            const size2_t outDims = glm::max((inDims + size2_t(1)) / size2_t(2), size2_t(1));
+            auto image = std::make_shared<Image>(outDims, base->getDataFormat());
+            image->getColorLayer()->setSwizzleMask(swizzlemasks::luminance);
+            downsample(typedData<T>(*prev), inDims, typedData<T>(*image), outDims, target);
+            chain.push_back(image);
+        }
+    };
+
+    if (base->getDataFormat() == DataFloat32::get()) {
+        build(static_cast<float*>(nullptr));
+    } else {
+        build(static_cast<std::uint8_t*>(nullptr));
+    }
+    return chain;
+}
+
+void NoiseGenerator::process() {
+    if (levels_.empty() || size_.isModified() || type_.isModified() || format_.isModified() ||
+        featureSize_.isModified() || seed_.isModified() || mipLevels_.isModified()) {
+        auto profile = profiling_.begin();
+        auto base = generate(size_.get(), type_.get(), format_.get(), featureSize_.get(),
+                             static_cast<std::uint32_t>(seed_.get()), profile);
+        levels_ = buildMipChain(base, mipLevels_.get(), profile);
+        profiling_.end();
+    }
+
+    size_t level = std::min(level_.get(), levels_.size() - 1);
+    if (matchOutputSize_) {
+        // Pick the smallest level that is still at least as large as the requested size
+        const size2_t requested = outport_.getDimensions();
+        level = 0;
+        for (size_t i = 1; i < levels_.size(); ++i) {
+            if (glm::any(glm::lessThan(levels_[i]->getDimensions(), requested))) break;
+            level = i;
+        }
+    }
+
+    outport_.setData(levels_[level]);
+}
+
+}  // namespace inviwo
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <modules/tnm067lab3/tnm067lab3moduledefine.h>
+#include <inviwo/core/processors/processor.h>
+#include <inviwo/core/properties/ordinalproperty.h>
+#include <inviwo/core/properties/optionproperty.h>
+#include <inviwo/core/properties/boolproperty.h>
+#include <inviwo/core/ports/imageport.h>
+#include <modules/tnm067lab1/properties/profilingproperty.h>
+
+namespace inviwo {
+
+/**
+ * \class NoiseGenerator
+ * \brief Generates single channel noise images, e.g. as input for line integral convolution.
+ * The noise is a pure function of the seed and the pixel position, so the result is the same
+ * regardless of how the image is split between threads. Optionally a chain of mip levels is
+ * built and the level best matching the requested outport size is output.
+ */
+class IVW_MODULE_TNM067LAB3_API NoiseGenerator : public Processor {
+public:
+    enum class NoiseType { White, BandLimited };
+    enum class OutputFormat { Float32, UInt8 };
+
+    NoiseGenerator();
+    virtual ~NoiseGenerator() = default;
+
+    virtual void process() override;
+
+    virtual const ProcessorInfo getProcessorInfo() const override;
+    static const ProcessorInfo processorInfo_;
+
+    /**
+     * Generates a single channel noise image with values in [0 1]
+     *
+     * @param dims size of the image
+     * @param type white noise or band-limited (value) noise
+     * @param format Float32 or UInt8 pixel format
+     * @param featureSize lattice spacing in pixels for band-limited noise
+     * @param seed seed of the noise, the same seed always gives the same image
+     */
+    static std::shared_ptr<Image> generate(size2_t dims, NoiseType type, OutputFormat format,
+                                           size_t featureSize, std::uint32_t seed,
+                                           TNM067::Profile* profile = nullptr);
+
+    /**
+     * Builds the mip chain of a noise image generated by NoiseGenerator::generate. Each level is
+     * the 2x2 average of the previous one with its contrast restored to that of the base level.
+     * The returned vector starts with the base image.
+     */
+    static std::vector<std::shared_ptr<Image>> buildMipChain(std::shared_ptr<Image> base,
+                                                             size_t levels,
+                                                             TNM067::Profile* profile = nullptr);
+
+private:
+    ImageOutport outport_;
+
+    IntSize2Property size_;
+    TemplateOptionProperty<NoiseType> type_;
+    TemplateOptionProperty<OutputFormat> format_;
+    IntSizeTProperty featureSize_;
+    IntProperty seed_;
+    IntSizeTProperty mipLevels_;
+    BoolProperty matchOutputSize_;
+    IntSizeTProperty level_;
+    ProfilingProperty profiling_;
+
+    std::vector<std::shared_ptr<Image>> levels_;
+};
+
+}  // namespace inviwo